@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+"""
+Compiler throughput benchmark.
+
+Generates synthetic programs with bench/slgen.py scaling one axis at a time, compiles each one with slc and records
+lines per second and peak resident set size. Results are appended as JSON lines (one object per compilation) to the
+output file, so successive runs can be compared release over release.
+"""
+
+import argparse
+import json
+import os
+import re
+import shutil
+import signal
+import subprocess
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import slgen
+
+# axis -> scales; every other axis keeps its default value from slgen.DEFAULTS
+AXES = {
+    "functions": [100, 400, 1600],
+    "depth": [10, 50, 200],
+    "vars": [100, 400, 1600],
+    "expr_length": [100, 1000, 5000],
+    "statements": [1000, 4000, 16000],
+    "array_dims": [4, 8, 12],
+    "funparam_chain": [10, 100, 1000],
+}
+
+QUICK_AXES = {axis: scales[:1] for axis, scales in AXES.items()}
+
+
+def compile_program(compiler, source_path, timeout, time_command=None):
+    """
+    Runs the compiler once, returns (status, seconds, peak RSS in KiB or None).
+
+    The child of this process starts as a copy of the harness, so its ru_maxrss reports the harness when the compiler
+    stays smaller. The compiler is measured on its own: by GNU time, whose child is only a copy of time itself, or else
+    by sampling its VmHWM while it runs, which misses what it allocates after the last sample (None if it ends first).
+    """
+    command = [compiler]
+    report_path = None
+    if time_command:
+        report_path = source_path + ".time"
+        command = [time_command, "-f", "%M", "-o", report_path, compiler]
+
+    peak_rss = None
+    with open(source_path, "rb") as source, open(os.devnull, "wb") as devnull:
+        start = time.perf_counter()
+        # a session of its own, so a timeout also kills the compiler run by time
+        process = subprocess.Popen(command, stdin=source, stdout=devnull, stderr=devnull, start_new_session=True)
+        deadline = start + timeout
+        while True:
+            pid, status, _ = os.wait4(process.pid, os.WNOHANG)
+            if pid != 0:
+                break
+            sample = read_peak_rss(process.pid) if report_path is None else None
+            if sample is not None:
+                peak_rss = max(peak_rss or 0, sample)
+            if time.perf_counter() > deadline:
+                os.killpg(process.pid, signal.SIGKILL)
+                os.wait4(process.pid, 0)
+                if report_path is not None and os.path.exists(report_path):
+                    os.remove(report_path)
+                return "timeout", time.perf_counter() - start, peak_rss
+            time.sleep(0.001)
+        seconds = time.perf_counter() - start
+
+    if report_path is not None:
+        return read_time_report(report_path, status, seconds)
+    if os.WIFSIGNALED(status):
+        return "signal %d" % os.WTERMSIG(status), seconds, peak_rss
+    if os.WEXITSTATUS(status) != 0:
+        return "exit %d" % os.WEXITSTATUS(status), seconds, peak_rss
+    return "ok", seconds, peak_rss
+
+
+def read_peak_rss(pid):
+    """ The VmHWM of a running process in KiB, None once it exited. """
+    try:
+        with open("/proc/%d/status" % pid) as status:
+            for line in status:
+                if line.startswith("VmHWM:"):
+                    return int(line.split()[1])
+    except (OSError, ValueError):
+        pass
+    return None
+
+
+def read_time_report(report_path, status, seconds):
+    """ GNU time writes the maximum RSS last, preceded by a line when the command failed. """
+    with open(report_path) as report:
+        lines = report.read().splitlines()
+    os.remove(report_path)
+
+    peak_rss = int(lines[-1]) if lines and lines[-1].isdigit() else None
+    for line in lines[:-1]:
+        match = re.search(r"terminated by signal (\d+)", line)
+        if match:
+            return "signal %s" % match.group(1), seconds, peak_rss
+    if os.WIFSIGNALED(status):
+        return "signal %d" % os.WTERMSIG(status), seconds, peak_rss
+    if os.WEXITSTATUS(status) != 0:
+        return "exit %d" % os.WEXITSTATUS(status), seconds, peak_rss
+    return "ok", seconds, peak_rss
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--compiler", default="build/main")
+    parser.add_argument("--workdir", default="build/bench")
+    parser.add_argument("--output", default="build/bench/compile_results.jsonl")
+    parser.add_argument("--timeout", type=float, default=120.0)
+    parser.add_argument("--quick", action="store_true", help="only the smallest scale of every axis")
+    parser.add_argument("--axis", action="append", help="restricts the benchmark to the given axes")
+    parser.add_argument("--time-command", default=shutil.which("time", path="/usr/bin:/bin"),
+                        help="GNU time, measuring the compiler's peak RSS (default: /usr/bin/time if installed), "
+                             "without it the RSS is sampled from /proc while the compiler runs")
+    arguments = parser.parse_args()
+
+    os.makedirs(arguments.workdir, exist_ok=True)
+    axes = QUICK_AXES if arguments.quick else AXES
+    if arguments.axis:
+        axes = {axis: axes[axis] for axis in arguments.axis}
+
+    print("%-16s %8s %9s %10s %12s %10s  %s" % ("axis", "scale", "lines", "seconds", "lines/s", "rss KiB", "status"))
+    with open(arguments.output, "a") as results:
+        for axis, scales in axes.items():
+            for scale in scales:
+                program = slgen.generate(**{axis: scale})
+                source_path = os.path.join(arguments.workdir, "%s_%d.sl" % (axis, scale))
+                with open(source_path, "w") as source:
+                    source.write(program)
+
+                lines = program.count("\n")
+                status, seconds, rss = compile_program(arguments.compiler, source_path, arguments.timeout,
+                                                       arguments.time_command)
+                lines_per_second = lines / seconds if seconds > 0 else 0.0
+
+                print("%-16s %8d %9d %10.4f %12.0f %10s  %s" % (axis, scale, lines, seconds, lines_per_second,
+                                                              "-" if rss is None else rss, status))
+                results.write(json.dumps({
+                    "timestamp": int(time.time()),
+                    "axis": axis,
+                    "scale": scale,
+                    "lines": lines,
+                    "seconds": round(seconds, 6),
+                    "lines_per_second": round(lines_per_second, 1),
+                    "peak_rss_kib": rss,
+                    "status": status,
+                }) + "\n")
+
+
+if __name__ == "__main__":
+    main()
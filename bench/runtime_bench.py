@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""
+Runtime benchmark of the generated MEPA code.
+
+Every program bench/runtime/<name>.sl is compiled, executed by the MEPA interpreter with <name>.in as its input and
+its output is checked against <name>.out. The number of executed MEPA instructions is compared with the baseline in
+bench/runtime/baseline.json and every change is flagged, so the effect of a code generation change can be measured
+instead of guessed. Wall times are reported for reference only, they depend on the machine running the interpreter.
+
+Exit status: 1 if some program failed or produced a wrong output, 2 if only instruction counts changed.
+"""
+
+import argparse
+import glob
+import json
+import os
+import re
+import subprocess
+import sys
+import time
+
+BENCH_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "runtime")
+BASELINE_PATH = os.path.join(BENCH_DIR, "baseline.json")
+MEPA_OPTIONS = ["--silent", "--limit", "100000000", "--programsize", "5000", "--stacksize", "5000",
+                "--displaysize", "20"]
+EXECUTED_PATTERN = re.compile(r"Executed (\d+) instructions")
+
+
+def run_benchmark(name, compiler, compiler_args, mepa, workdir):
+    """ Returns a dict with the status, executed instructions and wall time of one benchmark. """
+    source_path = os.path.join(BENCH_DIR, name + ".sl")
+    input_path = os.path.join(BENCH_DIR, name + ".in")
+    expected_path = os.path.join(BENCH_DIR, name + ".out")
+    program_path = os.path.join(workdir, name + ".mep")
+
+    with open(source_path, "rb") as source, open(program_path, "wb") as program:
+        compilation = subprocess.run([compiler] + compiler_args, stdin=source, stdout=program,
+                                     stderr=subprocess.PIPE)
+    if compilation.returncode != 0:
+        return {"status": "compilation failed", "instructions": None, "seconds": None}
+
+    with open(input_path, "rb") as data:
+        start = time.perf_counter()
+        execution = subprocess.run([sys.executable, mepa] + MEPA_OPTIONS + ["--progfile", program_path],
+                                   stdin=data, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        seconds = time.perf_counter() - start
+
+    executed = EXECUTED_PATTERN.search(execution.stderr.decode(errors="replace"))
+    if execution.returncode != 0 or executed is None:
+        return {"status": "execution failed", "instructions": None, "seconds": seconds}
+
+    with open(expected_path, "rb") as expected:
+        if execution.stdout != expected.read():
+            return {"status": "wrong output", "instructions": int(executed.group(1)), "seconds": seconds}
+
+    return {"status": "ok", "instructions": int(executed.group(1)), "seconds": seconds}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--compiler", default="build/main")
+    parser.add_argument("--compiler-args", default="", help="options given to the compiler, e.g. \"--stats\"")
+    parser.add_argument("--mepa", default="build/mepa/mepa.py")
+    parser.add_argument("--workdir", default="build/bench/runtime")
+    parser.add_argument("--update-baseline", action="store_true",
+                        help="records the measured instruction counts and wall times as the new baseline")
+    parser.add_argument("names", nargs="*", help="benchmarks to run, all of them by default")
+    arguments = parser.parse_args()
+
+    os.makedirs(arguments.workdir, exist_ok=True)
+    with open(BASELINE_PATH) as baseline_file:
+        baseline = json.load(baseline_file)
+
+    names = arguments.names or sorted(os.path.basename(path)[:-3]
+                                      for path in glob.glob(os.path.join(BENCH_DIR, "*.sl")))
+
+    failed = False
+    changed = False
+    print("%-16s %12s %12s %9s %10s  %s" % ("benchmark", "baseline", "executed", "delta", "seconds", "status"))
+    for name in names:
+        result = run_benchmark(name, arguments.compiler, arguments.compiler_args.split(), arguments.mepa,
+                               arguments.workdir)
+        expected = baseline.get(name, {}).get("instructions")
+        status = result["status"]
+        delta = ""
+
+        if status != "ok":
+            failed = True
+        elif expected is None:
+            status = "no baseline"
+            changed = True
+        elif result["instructions"] != expected:
+            delta = "%+.1f%%" % (100.0 * (result["instructions"] - expected) / expected)
+            status = "CHANGED"
+            changed = True
+
+        print("%-16s %12s %12s %9s %10s  %s" % (
+            name,
+            expected if expected is not None else "-",
+            result["instructions"] if result["instructions"] is not None else "-",
+            delta,
+            "%.3f" % result["seconds"] if result["seconds"] is not None else "-",
+            status))
+
+        if arguments.update_baseline and result["status"] == "ok":
+            baseline[name] = {"instructions": result["instructions"], "seconds": round(result["seconds"], 3)}
+
+    if arguments.update_baseline:
+        with open(BASELINE_PATH, "w") as baseline_file:
+            json.dump(baseline, baseline_file, indent=4, sort_keys=True)
+            baseline_file.write("\n")
+        return 1 if failed else 0
+
+    if failed:
+        return 1
+    return 2 if changed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+"""
+Deterministic generator of synthetic SL programs used to stress the compiler.
+
+Every axis can be scaled independently, the other ones keep small default values:
+  --functions N        sibling functions declared in the main program
+  --depth N            levels of nested function declarations
+  --vars N             variables declared per scope
+  --expr-length N      terms in each generated expression
+  --statements N       statements in the main body
+  --array-dims N       dimensions of the generated array (every dimension has size 2)
+  --funparam-chain N   functions passing a function parameter along to the next one
+
+The same arguments (and --seed) always produce the same program.
+"""
+
+import argparse
+import random
+import sys
+
+DEFAULTS = {
+    "functions": 2,
+    "depth": 1,
+    "vars": 4,
+    "expr_length": 3,
+    "statements": 10,
+    "array_dims": 2,
+    "funparam_chain": 2,
+    "seed": 2020,
+}
+
+
+class Generator:
+
+    def __init__(self, functions, depth, vars, expr_length, statements, array_dims, funparam_chain, seed):
+        self.functions = functions
+        self.depth = depth
+        self.vars = max(vars, 1)
+        self.expr_length = max(expr_length, 1)
+        self.statements = statements
+        self.array_dims = max(array_dims, 1)
+        self.funparam_chain = funparam_chain
+        self.random = random.Random(seed)
+        self.out = []
+
+    def emit(self, indent, text):
+        self.out.append("  " * indent + text)
+
+    def variables(self, prefix):
+        return ["%s%d" % (prefix, i) for i in range(self.vars)]
+
+    def expression(self, names):
+        terms = []
+        for i in range(self.expr_length):
+            if self.random.random() < 0.3:
+                terms.append(str(self.random.randint(0, 9)))
+            else:
+                terms.append(self.random.choice(names))
+            if i < self.expr_length - 1:
+                terms.append(self.random.choice(["+", "-", "*"]))
+        return " ".join(terms)
+
+    def array_access(self, names):
+        indexes = "".join("[%s]" % self.random.choice(["0", "1"]) for _ in range(self.array_dims))
+        return "a" + indexes
+
+    def statement(self, indent, names, remaining_nesting=2):
+        kind = self.random.random()
+        target = self.random.choice(names)
+        if kind < 0.55 or remaining_nesting == 0:
+            self.emit(indent, "%s = %s;" % (target, self.expression(names)))
+        elif kind < 0.7:
+            self.emit(indent, "%s = %s;" % (self.array_access(names), self.expression(names)))
+        elif kind < 0.85:
+            self.emit(indent, "if (%s < %s) {" % (target, self.expression(names)))
+            self.statement(indent + 1, names, remaining_nesting - 1)
+            self.emit(indent, "} else {")
+            self.statement(indent + 1, names, remaining_nesting - 1)
+            self.emit(indent, "}")
+        else:
+            self.emit(indent, "while (%s > 0) {" % target)
+            self.statement(indent + 1, names, remaining_nesting - 1)
+            self.emit(indent + 1, "%s = %s - 1;" % (target, target))
+            self.emit(indent, "}")
+
+    def vars_section(self, indent, names):
+        self.emit(indent, "vars")
+        self.emit(indent + 1, "%s: integer;" % ", ".join(names))
+
+    def nested_function(self, name, level, indent):
+        """ Function 'name' declares a chain of nested functions down to the requested depth. """
+        names = self.variables("v")
+        self.emit(indent, "integer %s(x: integer)" % name)
+        self.vars_section(indent + 1, names)
+        child = None
+        if level < self.depth:
+            child = "%sn" % name
+            self.emit(indent + 1, "functions")
+            self.nested_function(child, level + 1, indent + 2)
+        self.emit(indent, "{")
+        for v in names:
+            self.emit(indent + 1, "%s = x;" % v)
+        if child is not None:
+            self.emit(indent + 1, "%s = %s(%s);" % (names[0], child, names[0]))
+        self.emit(indent + 1, "return %s;" % self.expression(names + ["x"]))
+        self.emit(indent, "}")
+
+    def funparam_chain_functions(self, indent):
+        self.emit(indent, "integer leaf(x: integer)")
+        self.emit(indent, "{ return x + 1; }")
+        for i in range(1, self.funparam_chain + 1):
+            callee = "leaf" if i == 1 else "chain%d" % (i - 1)
+            self.emit(indent, "integer chain%d(x: integer, integer p(y: integer))" % i)
+            if i == 1:
+                self.emit(indent, "{ return p(x); }")
+            else:
+                self.emit(indent, "{ return %s(x, p); }" % callee)
+
+    def program(self):
+        names = self.variables("g")
+        dims = "".join("[2]" for _ in range(self.array_dims))
+
+        self.emit(0, "void main()")
+        self.emit(1, "vars")
+        self.emit(2, "%s: integer;" % ", ".join(names))
+        self.emit(2, "a: integer%s;" % dims)
+        self.emit(1, "functions")
+        for f in range(self.functions):
+            self.nested_function("f%d" % f, 1, 2)
+        if self.funparam_chain > 0:
+            self.funparam_chain_functions(2)
+        self.emit(0, "{")
+        for v in names:
+            self.emit(1, "%s = %d;" % (v, self.random.randint(0, 9)))
+        for f in range(self.functions):
+            self.emit(1, "%s = f%d(%s);" % (self.random.choice(names), f, self.random.choice(names)))
+        if self.funparam_chain > 0:
+            self.emit(1, "%s = chain%d(%s, leaf);" % (names[0], self.funparam_chain, names[0]))
+        for _ in range(self.statements):
+            self.statement(1, names)
+        self.emit(1, "write(%s);" % names[0])
+        self.emit(0, "}")
+        return "\n".join(self.out) + "\n"
+
+
+def generate(**axes):
+    parameters = dict(DEFAULTS)
+    parameters.update(axes)
+    return Generator(**parameters).program()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generates a synthetic SL program on the standard output")
+    for axis, value in DEFAULTS.items():
+        parser.add_argument("--" + axis.replace("_", "-"), type=int, default=value)
+    arguments = parser.parse_args()
+    sys.stdout.write(generate(**vars(arguments)))
+
+
+if __name__ == "__main__":
+    main()
@@ -1,44 +1,151 @@
 #!/bin/bash
+#
+# Runs the tests of tests/sl: the generated code is compared with the reference code in tests/mep and the output of
+# its execution with tests/output. Without options, the control flow graphs of the programs of tests/cfg (--dump-cfg)
+# are also compared with the reference graphs next to them.
+#
+# Compiler options given as arguments (ex: ./runtests.sh -O2) change the generated code, so only the output and the
+# error messages are compared then, along with the generated code of the tests having a reference for those options in
+# tests/optimized (named after the test and the options without spaces, ex: pr49-floop-invariant-code-motion.mep).
+# --all-optimizations runs the tests at -O1 and -O2, with each optimization alone (-f<name>) and with each one disabled
+# at -O2 (-O2 -fno-<name>), reporting only the failing tests.
+#
+# The exit status is 1 when a test failed.
 
 RED='\033[0;31m'
 GREEN='\033[0;32m'
 NO_COLOR='\033[0m'
 
 buildDir="build/"
-testResultDir="${buildDir}tests/"
+failures=0
 
-mkdir -p $testResultDir
+runTests() {
+  local options="$*"
+  local testResultDir="${buildDir}tests/"
+  if [ -n "$options" ]
+  then
+    testResultDir="${buildDir}tests/${options// /}/"
+  fi
+  mkdir -p $testResultDir
+
+  local configurationFailures=$failures
+  for testFile in tests/sl/*; do
+
+    testNumber=$(echo $testFile | sed -e 's/[^0-9]//g')
+
+    resultProgram="${testResultDir}result$testNumber.mep"
+    resultFile="${testResultDir}result$testNumber.res"
+    inputFile="tests/input/data$testNumber.in"
 
-for testFile in tests/sl/*; do
+    ./build/main $options < $testFile > $resultProgram
 
-  testNumber=$(echo $testFile | sed -e 's/[^0-9]//g')
-  echo -n "Running test $testNumber"
+    expectedProgramPath=$(find tests/mep -regextype posix-egrep -regex ".*$testNumber.*")
+    if [ -z "$options" ]
+    then
+      echo -n "Running test $testNumber"
+      DIFF=$(diff -bBw $resultProgram $expectedProgramPath)
+      if [ "$DIFF" != "" ]
+      then
+        echo -e " | ${RED}FAILED${NO_COLOR}"
+        diff -b -y --color $resultProgram $expectedProgramPath
+        failures=$((failures+1))
+      else
+        echo -e " | ${GREEN}SUCCESS${NO_COLOR}"
+      fi
+    else
+      # the code emitted before an error differs, the error itself must not
+      DIFF=$(diff <(grep -i "error" $resultProgram) <(grep -i "error" $expectedProgramPath))
+      if [ "$DIFF" != "" ]
+      then
+        echo -e "Running test $testNumber with $options | ${RED}FAILED${NO_COLOR}"
+        echo "$DIFF"
+        failures=$((failures+1))
+      fi
 
-  resultProgram="${testResultDir}result$testNumber.mep"
-  resultFile="${testResultDir}result$testNumber.res"
-  inputFile="tests/input/data$testNumber.in"
+      optimizedProgramPath="tests/optimized/$(basename $testFile .sl)${options// /}.mep"
+      if [ -f $optimizedProgramPath ]
+      then
+        DIFF=$(diff -bBw $resultProgram $optimizedProgramPath)
+        if [ "$DIFF" != "" ]
+        then
+          echo -e "Running test $testNumber with $options | ${RED}FAILED${NO_COLOR}"
+          diff -b -y --color $resultProgram $optimizedProgramPath
+          failures=$((failures+1))
+        fi
+      fi
+    fi
 
-  ./build/main < $testFile > $resultProgram
+    expectedResponsePath=$(find tests/output -regextype posix-egrep -regex ".*$testNumber.*")
+    ./build/mepa/mepa.py --silent --limit 12000 --progfile $resultProgram < $inputFile > $resultFile
+    DIFF=$(diff $resultFile $expectedResponsePath)
+    if [ "$DIFF" != "" ]
+    then
+      if [ -n "$options" ]
+      then
+        echo -n "Running test $testNumber with $options"
+      fi
+      echo -e " | ${RED}FAILED${NO_COLOR}"
+      diff --color $resultFile $expectedResponsePath
+      failures=$((failures+1))
+    elif [ -z "$options" ]
+    then
+      echo -e " | ${GREEN}SUCCESS${NO_COLOR}"
+    fi
+  done
 
-  expectedResponsePath=$(find tests/mep -regextype posix-egrep -regex ".*$testNumber.*")
-  DIFF=$(diff -bBw $resultProgram $expectedResponsePath)
-  if [ "$DIFF" != "" ]
+  if [ -n "$options" ]
   then
-    echo -e " | ${RED}FAILED${NO_COLOR}"
-    diff -b -y --color $resultProgram $expectedResponsePath
-  else
-    echo -e " | ${GREEN}SUCCESS${NO_COLOR}"
+    if [ $failures -eq $configurationFailures ]
+    then
+      echo -e "Running tests with $options | ${GREEN}SUCCESS${NO_COLOR}"
+    else
+      echo -e "Running tests with $options | ${RED}FAILED${NO_COLOR}"
+    fi
   fi
+}
 
+runControlFlowTests() {
+  local testResultDir="${buildDir}tests/cfg/"
+  mkdir -p $testResultDir
 
-  expectedResponsePath=$(find tests/output -regextype posix-egrep -regex ".*$testNumber.*")
-  ./build/mepa/mepa.py --silent --limit 12000 --progfile $resultProgram < $inputFile > $resultFile
-  DIFF=$(diff $resultFile $expectedResponsePath)
-  if [ "$DIFF" != "" ]
+  for testFile in tests/cfg/*.sl; do
+    testName=$(basename $testFile .sl)
+    resultGraph="${testResultDir}$testName.dot"
+
+    ./build/main --dump-cfg < $testFile > $resultGraph
+
+    echo -n "Running control flow test $testName"
+    DIFF=$(diff $resultGraph tests/cfg/$testName.dot)
+    if [ "$DIFF" != "" ]
+    then
+      echo -e " | ${RED}FAILED${NO_COLOR}"
+      diff --color $resultGraph tests/cfg/$testName.dot
+      failures=$((failures+1))
+    else
+      echo -e " | ${GREEN}SUCCESS${NO_COLOR}"
+    fi
+  done
+}
+
+if [ "$1" == "--all-optimizations" ]
+then
+  # the optimizations listed by the compiler, in pipeline order
+  optimizations=$(./build/main --help 2>&1 | sed -n -e 's/^  -f\([a-z-]*\) .*/\1/p')
+
+  runTests -O1
+  runTests -O2
+  for optimization in $optimizations; do
+    runTests -f$optimization
+  done
+  for optimization in $optimizations; do
+    runTests -O2 -fno-$optimization
+  done
+else
+  runTests "$@"
+  if [ $# -eq 0 ]
   then
-    echo -e " | ${RED}FAILED${NO_COLOR}"
-  diff --color $resultFile $expectedResponsePath
-  else
-    echo -e " | ${GREEN}SUCCESS${NO_COLOR}"
+    runControlFlowTests
   fi
-done
\ No newline at end of file
+fi
+
+exit $((failures > 0))
@@ -0,0 +1,176 @@
+#include "activations.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    TreeNodePtr functionNode;
+    char* identifier;
+    /* Identifiers called by the function's body, the calls of its nested functions are their own */
+    Stack* calledIdentifiers;
+    bool passedAsArgument;
+    bool reached;
+} FunctionCalls, *FunctionCallsPtr;
+
+typedef struct {
+    Stack* functions;
+    /* The functions enclosing the node being visited, the innermost one on top */
+    Stack* enclosing;
+    /* Identifiers used as values and names of function parameters, anywhere in the program */
+    Stack* valueIdentifiers;
+    Stack* functionParameters;
+} CallGraphSearch;
+
+bool addCallGraphNode(TreeNodePtr node, void* context);
+void leaveCallGraphNode(TreeNodePtr node, void* context);
+bool reachesItself(Stack* functions, FunctionCallsPtr function, Stack* functionParameters);
+void addCallees(Stack* functions, Stack* pending, FunctionCallsPtr caller, Stack* functionParameters);
+bool isListedName(Stack* identifiers, char* identifier);
+bool byIdentifierName(void* data, void* secondParam);
+bool byFunctionNode(void* data, void* secondParam);
+
+static const bool callGraphFilter[NODE_CATEGORIES_COUNT] = {
+    [FUNCTION_NODE] = true,
+    [FUNCTION_CALL_NODE] = true,
+    [VALUE_NODE] = true,
+    [FUNCTION_PARAMETER_NODE] = true
+};
+
+Stack* findStaticFunctions(TreeNodePtr programNode) {
+    CallGraphSearch search = {
+        .functions = newStack(),
+        .enclosing = newStack(),
+        .valueIdentifiers = newStack(),
+        .functionParameters = newStack()
+    };
+    TreeVisitor visitor = {
+        .preVisit = addCallGraphNode,
+        .postVisit = leaveCallGraphNode,
+        .categoryFilter = callGraphFilter,
+        .context = &search
+    };
+    visitSubtree(programNode, &visitor);
+
+    for (LinkedNode* node = search.functions->top; node != NULL; node = node->next) {
+        FunctionCallsPtr function = node->data;
+        function->passedAsArgument = isListedName(search.valueIdentifiers, function->identifier);
+    }
+
+    Stack* staticFunctions = newStack();
+    for (LinkedNode* node = search.functions->top; node != NULL; node = node->next) {
+        FunctionCallsPtr function = node->data;
+        // the main function is never called, but its activation record keeps the static ones
+        if(function->functionNode != programNode && !function->passedAsArgument &&
+           !reachesItself(search.functions, function, search.functionParameters)) {
+            push(staticFunctions, function->functionNode);
+        }
+    }
+
+    while (search.functions->top != NULL) {
+        FunctionCallsPtr function = pop(search.functions);
+        while (pop(function->calledIdentifiers) != NULL);
+        free(function->calledIdentifiers);
+        free(function);
+    }
+    free(search.functions);
+    free(search.enclosing);
+    while (pop(search.valueIdentifiers) != NULL);
+    free(search.valueIdentifiers);
+    while (pop(search.functionParameters) != NULL);
+    free(search.functionParameters);
+    return staticFunctions;
+}
+
+bool addCallGraphNode(TreeNodePtr node, void* context) {
+    CallGraphSearch* search = (CallGraphSearch*) context;
+
+    switch (node->category) {
+        case FUNCTION_NODE: {
+            FunctionCallsPtr function = malloc(sizeof(FunctionCalls));
+            function->functionNode = node;
+            function->identifier = node->subtrees[0]->subtrees[1]->name;
+            function->calledIdentifiers = newStack();
+            function->passedAsArgument = false;
+            function->reached = false;
+            push(search->functions, function);
+            push(search->enclosing, function);
+            break;
+        }
+        case FUNCTION_CALL_NODE: {
+            FunctionCallsPtr caller = search->enclosing->top->data;
+            if(!isListedName(caller->calledIdentifiers, node->subtrees[0]->name)) {
+                push(caller->calledIdentifiers, node->subtrees[0]->name);
+            }
+            break;
+        }
+        case VALUE_NODE:
+            push(search->valueIdentifiers, node->subtrees[0]->name);
+            break;
+        case FUNCTION_PARAMETER_NODE:
+            push(search->functionParameters, node->subtrees[0]->subtrees[1]->name);
+            // the parameters of a function parameter are never called
+            return false;
+        default:
+            break;
+    }
+    return true;
+}
+
+void leaveCallGraphNode(TreeNodePtr node, void* context) {
+    CallGraphSearch* search = (CallGraphSearch*) context;
+    if(node->category == FUNCTION_NODE) {
+        pop(search->enclosing);
+    }
+}
+
+/* Searches the functions reachable from the function's calls, until the function itself is reached */
+bool reachesItself(Stack* functions, FunctionCallsPtr function, Stack* functionParameters) {
+    for (LinkedNode* node = functions->top; node != NULL; node = node->next) {
+        ((FunctionCallsPtr) node->data)->reached = false;
+    }
+
+    Stack* pending = newStack();
+    addCallees(functions, pending, function, functionParameters);
+    while (pending->top != NULL && !function->reached) {
+        addCallees(functions, pending, pop(pending), functionParameters);
+    }
+    while (pop(pending) != NULL);
+    free(pending);
+    return function->reached;
+}
+
+/* Adds the functions the caller's calls reach that weren't reached yet */
+void addCallees(Stack* functions, Stack* pending, FunctionCallsPtr caller, Stack* functionParameters) {
+    for (LinkedNode* call = caller->calledIdentifiers->top; call != NULL; call = call->next) {
+        bool throughParameter = isListedName(functionParameters, call->data);
+        for (LinkedNode* node = functions->top; node != NULL; node = node->next) {
+            FunctionCallsPtr callee = node->data;
+            if(!callee->reached &&
+               (strcmp(callee->identifier, call->data) == 0 || (throughParameter && callee->passedAsArgument))) {
+                callee->reached = true;
+                push(pending, callee);
+            }
+        }
+    }
+}
+
+bool isListedName(Stack* identifiers, char* identifier) {
+    return find(identifiers, identifier, byIdentifierName) != NULL;
+}
+
+bool byIdentifierName(void* data, void* secondParam) {
+    return strcmp((char*) data, (char*) secondParam) == 0;
+}
+
+bool isStaticFunction(Stack* staticFunctions, TreeNodePtr functionNode) {
+    return staticFunctions != NULL && find(staticFunctions, functionNode, byFunctionNode) != NULL;
+}
+
+bool byFunctionNode(void* data, void* secondParam) {
+    return data == secondParam;
+}
+
+void freeStaticFunctions(Stack* staticFunctions) {
+    while (pop(staticFunctions) != NULL);
+    free(staticFunctions);
+}
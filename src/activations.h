@@ -0,0 +1,26 @@
+/**
+ * This module finds the functions that are never active twice at the same time, so the code generator can keep their
+ * variables and temporaries in static positions of the main function's activation record instead of allocating them
+ * on each call
+ *
+ * The call graph is built on the whole program before it is compiled, calls are matched by name: a call reaches every
+ * function with the called name, and a call through a function parameter reaches every function passed as an argument
+ **/
+
+#ifndef ACTIVATIONS_HEADER
+#define ACTIVATIONS_HEADER
+
+#include "tree.h"
+
+/*
+ * Finds the functions of the program that can't be active twice: the ones not reaching themselves through the call
+ * graph (directly, through other functions or through function parameters) and never passed as arguments, the calls
+ * through a function parameter are taken as reaching any of the passed functions.
+ * Returns the function nodes found, they are looked up with isStaticFunction and released with freeStaticFunctions
+ */
+Stack* findStaticFunctions(TreeNodePtr programNode);
+
+bool isStaticFunction(Stack* staticFunctions, TreeNodePtr functionNode);
+void freeStaticFunctions(Stack* staticFunctions);
+
+#endif
@@ -0,0 +1,119 @@
+#include "callgraph.h"
+
+#include <stdlib.h>
+
+typedef struct _FunctionCode {
+    FunctionDescriptorPtr functionDescriptor;
+    struct _FunctionCode* enclosingFunction;
+    /* Range of its commands in the buffer, the last one excluded */
+    int firstCommand;
+    int lastCommand;
+    int bodyJumpCommand;
+    /* Functions it calls or passes as arguments */
+    Stack* references;
+    bool reachable;
+} FunctionCode, *FunctionCodePtr;
+
+void markReachable(FunctionCodePtr functionCode);
+bool removeUnreachableCode(void* data, void* secondParam);
+bool hasReachableNestedFunction(void* data, void* secondParam);
+bool byDescriptor(void* data, void* secondParam);
+bool bySameCode(void* data, void* secondParam);
+
+/* Every function compiled, the last one entered on top */
+Stack* functionCodes = NULL;
+/* Functions whose commands are being added, the innermost one on top */
+Stack* openFunctionCodes = NULL;
+
+void enterFunctionCode(FunctionDescriptorPtr functionDescriptor) {
+    if(functionCodes == NULL) {
+        functionCodes = newStack();
+        openFunctionCodes = newStack();
+    }
+
+    FunctionCodePtr functionCode = malloc(sizeof(FunctionCode));
+    functionCode->functionDescriptor = functionDescriptor;
+    functionCode->enclosingFunction = openFunctionCodes->top == NULL ? NULL : openFunctionCodes->top->data;
+    functionCode->firstCommand = nextCommandIndex();
+    functionCode->lastCommand = -1;
+    functionCode->bodyJumpCommand = -1;
+    functionCode->references = newStack();
+    functionCode->reachable = false;
+
+    push(functionCodes, functionCode);
+    push(openFunctionCodes, functionCode);
+}
+
+void leaveFunctionCode() {
+    FunctionCodePtr functionCode = pop(openFunctionCodes);
+    functionCode->lastCommand = nextCommandIndex();
+}
+
+void setBodyJumpCommand(int commandIndex) {
+    FunctionCodePtr functionCode = openFunctionCodes->top->data;
+    functionCode->bodyJumpCommand = commandIndex;
+}
+
+void addFunctionReference(FunctionDescriptorPtr functionDescriptor) {
+    FunctionCodePtr functionCode = openFunctionCodes->top->data;
+    // the referenced function was declared before, so it was entered already
+    FunctionCodePtr referencedCode = find(functionCodes, functionDescriptor, byDescriptor);
+    if(find(functionCode->references, referencedCode, bySameCode) == NULL) {
+        push(functionCode->references, referencedCode);
+    }
+}
+
+void removeUnreachableFunctions() {
+    if(functionCodes == NULL) {
+        return;
+    }
+
+    // the main function is the first one entered, at the bottom of the stack
+    LinkedNode* mainNode = functionCodes->top;
+    while (mainNode->next != NULL) {
+        mainNode = mainNode->next;
+    }
+    markReachable(mainNode->data);
+
+    find(functionCodes, NULL, removeUnreachableCode);
+}
+
+void markReachable(FunctionCodePtr functionCode) {
+    if(functionCode->reachable) {
+        return;
+    }
+
+    functionCode->reachable = true;
+    for (LinkedNode* node = functionCode->references->top; node != NULL; node = node->next) {
+        markReachable(node->data);
+    }
+}
+
+bool removeUnreachableCode(void* data, void* secondParam) {
+    FunctionCodePtr functionCode = (FunctionCodePtr) data;
+
+    if(!functionCode->reachable) {
+        // the nested functions' commands are removed along with it
+        removeCommands(functionCode->firstCommand, functionCode->lastCommand);
+    } else if(functionCode->bodyJumpCommand >= 0 &&
+              find(functionCodes, functionCode, hasReachableNestedFunction) == NULL) {
+        // the body follows the jump once the nested functions are removed
+        removeCommands(functionCode->bodyJumpCommand, functionCode->bodyJumpCommand + 1);
+    }
+    // every function is visited
+    return false;
+}
+
+bool hasReachableNestedFunction(void* data, void* secondParam) {
+    FunctionCodePtr functionCode = (FunctionCodePtr) data;
+    return functionCode->enclosingFunction == (FunctionCodePtr) secondParam && functionCode->reachable;
+}
+
+bool byDescriptor(void* data, void* secondParam) {
+    FunctionCodePtr functionCode = (FunctionCodePtr) data;
+    return functionCode->functionDescriptor == (FunctionDescriptorPtr) secondParam;
+}
+
+bool bySameCode(void* data, void* secondParam) {
+    return data == secondParam;
+}
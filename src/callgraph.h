@@ -0,0 +1,29 @@
+/**
+ * This module keeps the call graph of the compiled program, so the code generator can remove the functions the program
+ * never reaches
+ *
+ * The commands of each function are recorded as a range of the commands buffer, the ranges of nested functions are
+ * inside their enclosing function's one. Every function is still compiled, and so checked, the unreachable ones are
+ * only removed from the buffer once the whole program was compiled
+ **/
+
+#ifndef CALLGRAPH_HEADER
+#define CALLGRAPH_HEADER
+
+#include "symboltable.h"
+
+/* Starts the commands of a function, inside the function whose commands are being added (none for the main function) */
+void enterFunctionCode(FunctionDescriptorPtr functionDescriptor);
+/* Ends the commands of the function entered last */
+void leaveFunctionCode();
+
+/* The jump over the nested functions of the function entered last, it is removed if none of them is reachable */
+void setBodyJumpCommand(int commandIndex);
+
+/* The function entered last calls the given function or passes it as an argument */
+void addFunctionReference(FunctionDescriptorPtr functionDescriptor);
+
+/* Removes the commands of the functions not referenced by the main function nor by the functions it reaches */
+void removeUnreachableFunctions();
+
+#endif
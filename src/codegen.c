@@ -3,15 +3,30 @@
 #include "tree.h"
 #include "symboltable.h"
 #include "utils.h"
-
+#include "options.h"
+#include "loops.h"
+#include "inlining.h"
+#include "callgraph.h"
+#include "usage.h"
+#include "framelayout.h"
+#include "specialization.h"
+#include "activations.h"
+#include "controlflow.h"
+#include "subexpressions.h"
+#include "evaluation.h"
+
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 
 /**
  * Code gen functions Declaration
  **/
 
 void processMainFunction(TreeNodePtr node);
-void processFunction(TreeNodePtr node);
+void processFunction(TreeNodePtr node, TreeNodePtr enclosingBlockNode);
+void processFunctionDeclaration(TreeNodePtr node, SymbolTableEntryPtr entry);
 
 /** Function Header **/
 FunctionHeaderPtr processFunctionHeader(TreeNodePtr node);
@@ -26,16 +41,19 @@ ParameterPtr processFunctionParameter(TreeNodePtr node);
 
 /** Block **/
 void processBlock(TreeNodePtr node);
+void completeFrameAllocation(FunctionDescriptorPtr functionDescriptor);
+bool completeLabelEntry(void* data, void* secondParam);
 
 void processLabels(TreeNodePtr node);
 
 void processTypes(TreeNodePtr node);
 void processTypeDeclaration(TreeNodePtr node);
 
-void processVariables(TreeNodePtr node);
-void processVariableDeclaration(TreeNodePtr node);
+void processVariables(TreeNodePtr node, TreeNodePtr blockNode);
+void processVariableDeclaration(TreeNodePtr node, Stack* unusedVariables, Stack* liveRanges, char* returnedVariable,
+                                int localsStart);
 
-void processFunctions(TreeNodePtr node);
+void processFunctions(TreeNodePtr node, TreeNodePtr blockNode);
 
 TypeDescriptorPtr processIdentifierAsType(TreeNodePtr node);
 char* processIdentifier(TreeNodePtr node);
@@ -58,9 +76,12 @@ void processAssignment(TreeNodePtr node);
  * If it is an array, generates code to leave the address of it's indexed position on top of the stack will be generated
  */
 Value processValue(TreeNodePtr node);
+Value processArraySubscripts(TreeNodePtr node, TreeNodePtr end, Value value);
 void loadArrayBaseAddress(Value value);
-void processArrayIndexList(TreeNodePtr node, Value* variable);
+void processArrayIndexList(TreeNodePtr node, TreeNodePtr end, Value* variable);
 void processArrayIndex(TreeNodePtr node, Value* value);
+Value processFoldedArrayIndexList(TreeNodePtr node, TreeNodePtr end, Value value);
+TreeNodePtr skipSubscripts(TreeNodePtr node, int subscripts);
 
 TypeDescriptorPtr processFunctionCall(TreeNodePtr node);
 TypeDescriptorPtr processFunctionParameterCall(TreeNodePtr node, SymbolTableEntryPtr functionEntry);
@@ -69,8 +90,10 @@ TypeDescriptorPtr processPseudoFunctionCall(TreeNodePtr node, SymbolTableEntryPt
 void processReadFunctionCall(TreeNodePtr argumentNode);
 void processWriteFunctionCall(TreeNodePtr argumentNode);
 
-void processArgumentsList(TreeNodePtr node, ParameterDescriptorsListPtr parameters);
+void processArgumentsList(TreeNodePtr node, ParameterDescriptorsListPtr parameters, FunctionVersionPtr version);
 void processArgumentByValue(ParameterDescriptorPtr expectedParameter, TreeNodePtr node);
+void processArgumentByAddress(ParameterDescriptorPtr expectedParameter, TreeNodePtr node, TreeNodePtr argumentsNode,
+                              ParameterDescriptorsListPtr parameters);
 void processArgumentByReference(ParameterDescriptorPtr expectedParameter, TreeNodePtr node);
 void processArgumentByFunctionAsParameter(ParameterDescriptorPtr expectedParameter, TreeNodePtr node);
 void processDeclaredFunctionAsArgument(ParameterDescriptorPtr expectedParameter, SymbolTableEntryPtr valueEntry);
@@ -83,6 +106,9 @@ void processReturnWithValue(TreeNodePtr expressionNode, FunctionDescriptorPtr fu
 
 void processConditional(TreeNodePtr node);
 void processRepetitive(TreeNodePtr node);
+void processRotatedRepetitive(TreeNodePtr node, Stack* invariants, Stack* inductionVariables,
+                              CountedLoopPtr countedLoop);
+void processLoopCondition(TreeNodePtr conditionNode);
 
 void processCompound(TreeNodePtr node);
 void processUnlabeledStatementList(TreeNodePtr node);
@@ -108,6 +134,79 @@ TypeDescriptorPtr processMultiplicativeOperator(TreeNodePtr node);
 
 TreeNodePtr getValueExpression(TreeNodePtr node);
 
+/** Loop invariants **/
+void evaluateLoopInvariant(LoopInvariantPtr invariant);
+TypeDescriptorPtr processArrayPrefix(TreeNodePtr valueNode, int subscripts);
+TypeDescriptorPtr loadHoistedInvariant(TreeNodePtr node);
+void hoistInvariant(LoopInvariantPtr invariant);
+
+/** Induction variables **/
+void evaluateInductionAddress(InductionAddressPtr address);
+void updateInductionAddresses(InductionVariablePtr inductionVariable);
+
+/** Loop idioms **/
+bool processLoopIdiom(TreeNodePtr node, TreeNodePtr initNode);
+void processBlockCopy(TreeNodePtr node, CountedLoopPtr countedLoop, int words);
+void loadValueAddress(Value value);
+
+/** Loop unrolling **/
+void processUnrolledRepetitive(TreeNodePtr node, CountedLoopPtr countedLoop, int exitLabel);
+void processShiftedLoopCondition(TreeNodePtr conditionNode, int offset);
+void checkLoopCondition(TreeNodePtr conditionNode);
+
+/** Common subexpressions **/
+void beginStraightLineStatement(TreeNodePtr statementNode);
+void endStraightLineStatement(TreeNodePtr statementNode);
+void evaluateCommonSubexpression(CommonSubexpressionPtr subexpression);
+
+/** Pure calls **/
+bool processEvaluatedCall(TreeNodePtr node, SymbolTableEntryPtr functionEntry);
+bool evaluateConstantCall(TreeNodePtr node, SymbolTableEntryPtr functionEntry, int* result);
+
+/** Inlining **/
+TypeDescriptorPtr processInlinedCall(TreeNodePtr node, InlineCandidatePtr candidate);
+void processInlinedArguments(TreeNodePtr node, ParameterDescriptorsListPtr parameters, int* displacements);
+SymbolTableEntryPtr newInlinedLocal(SymbolTableEntryPtr entry, int displacement, ParameterPassage passage);
+void freeInlinedLocal(SymbolTableEntryPtr entry);
+void processInlinedReturn(TreeNodePtr node, InlineExpansionPtr expansion);
+
+/** Unreachable code **/
+void referenceFunction(FunctionDescriptorPtr functionDescriptor);
+bool isJump(TreeNodePtr unlabeledStatementNode);
+bool isLabeledStatement(TreeNodePtr statementNode);
+TreeNodePtr getUnlabeledStatement(TreeNodePtr statementNode);
+
+/** Tail calls **/
+bool hasSelfTailCall(TreeNodePtr functionNode, char* identifier);
+bool findSelfTailCall(TreeNodePtr node, void* context);
+TreeNodePtr getCallExpression(TreeNodePtr expressionNode);
+bool processSelfTailCall(TreeNodePtr expressionNode, FunctionDescriptorPtr functionDescriptor);
+bool referencesActivationRecord(TreeNodePtr argumentsNode, ParameterDescriptorsListPtr parameters);
+
+/** Copy elision **/
+void findReadOnlyParameters(TreeNodePtr functionNode, FunctionHeaderPtr functionHeader, TreeNodePtr enclosingBlockNode);
+bool isUnchangedByCall(TreeNodePtr valueNode, TreeNodePtr argumentsNode, ParameterDescriptorsListPtr parameters);
+bool isResultVariable(TreeNodePtr expressionNode, FunctionDescriptorPtr functionDescriptor);
+
+/** Function specialization **/
+Stack* processFunctionVersions(TreeNodePtr blockNode);
+void findConstantParameters(TreeNodePtr functionNode, FunctionHeaderPtr functionHeader);
+void processFunctionVersion(FunctionVersionPtr version, TreeNodePtr enclosingBlockNode);
+char* newVersionName(char* identifier, FunctionVersionPtr version, ParameterPtr constantParameters);
+FunctionVersionPtr findCalledVersion(TreeNodePtr callNode, SymbolTableEntryPtr functionEntry);
+bool processFoldedConstant(TreeNodePtr node);
+void processConstantConditional(TreeNodePtr node, bool condition);
+
+/** Static activation records **/
+void placeStaticLocals(FunctionDescriptorPtr functionDescriptor);
+void reserveStaticLocals(FunctionDescriptorPtr functionDescriptor);
+void placeStaticTemporaries(FunctionDescriptorPtr functionDescriptor);
+int allocatedLocalsSize(FunctionDescriptorPtr functionDescriptor);
+
+/** Constant expressions **/
+bool evaluateTerm(TreeNodePtr node, long long* result);
+bool evaluateConstantCondition(TreeNodePtr node, bool* result);
+
 
 /**
  * Semantic error treatment declarations
@@ -124,12 +223,83 @@ void UnexpectedChildNodeCategoryError(NodeCategory fatherNodeCategory, NodeCateg
 /**
  * Code gen functions Implementation
  **/
+
+/*
+ * Invariants evaluated before the loops being compiled by their nodes, and in the order they were evaluated (the
+ * innermost loop's ones on top) to release them when their loop ends
+ */
+Map* hoistedInvariants = NULL;
+Stack* hoistedOrder = NULL;
+/* Induction variables of the loops being compiled by their update nodes, their addresses are updated along with them */
+Map* activeInductionVariables = NULL;
+/* The unlabeled statement compiled right before the current one in its statement list, NULL after a label */
+TreeNodePtr precedingStatement = NULL;
+/* Straight-line run being compiled, its subexpressions evaluated so far and the first temporary they took */
+StraightLineRunPtr currentRun = NULL;
+Stack* commonSubexpressions = NULL;
+int runFirstTemporary = 0;
+/* Inlined calls being compiled, the innermost one on top */
+Stack* inlineExpansions = NULL;
+/* Set while compiling statements that can't be reached, their commands are discarded */
+bool unreachableStatements = false;
+/* Block of the function being compiled, its nested functions may write the variables passed by address */
+TreeNodePtr currentBlockNode = NULL;
+/* Version whose code is being compiled, the innermost one, NULL outside any version */
+FunctionVersionPtr compiledVersion = NULL;
+/* Constants bound by the versions being compiled, their expressions and conditions are folded while any is bound */
+int boundConstants = 0;
+/* Tree nodes the copies of the unrolled loops may still add to the program, see chooseUnrolledCopies */
+int unrollingBudget = 0;
+/* Functions whose local areas are static parts of the main function's one, see findStaticFunctions */
+Stack* staticFunctions = NULL;
+/* End of the static local areas placed so far in the main function's activation record */
+int staticLocalsEnd = 0;
+
 void processProgram(void *p) {
     TreeNodePtr treeRoot = (TreeNodePtr) p;
 
-    processMainFunction(treeRoot);
+    hoistedInvariants = newMap();
+    hoistedOrder = newStack();
+    activeInductionVariables = newMap();
+    unrollingBudget = initialUnrollingBudget(treeRoot);
+    inlineExpansions = newStack();
+    commonSubexpressions = newStack();
+    // temporaries are added to the activation records after their allocation was emitted
+    if(compilerOptions.optimizations[LOOP_INVARIANT_CODE_MOTION] ||
+       compilerOptions.optimizations[INDUCTION_VARIABLES] ||
+       compilerOptions.optimizations[LOOP_IDIOMS] ||
+       compilerOptions.optimizations[LOOP_UNROLLING] ||
+       compilerOptions.optimizations[COMMON_SUBEXPRESSION_ELIMINATION] ||
+       compilerOptions.optimizations[INLINE_FUNCTIONS] ||
+       compilerOptions.optimizations[UNREACHABLE_CODE_ELIMINATION] ||
+       compilerOptions.optimizations[DEAD_STORE_ELIMINATION] ||
+       compilerOptions.optimizations[COPY_ELISION] ||
+       compilerOptions.optimizations[FUNCTION_SPECIALIZATION] ||
+       compilerOptions.optimizations[STATIC_ACTIVATION_RECORDS] ||
+       compilerOptions.dumpCfg) {
+        enableCommandsBuffering();
+    }
+    if(compilerOptions.optimizations[STATIC_ACTIVATION_RECORDS]) {
+        staticFunctions = findStaticFunctions(treeRoot);
+    }
 
-    addCommand("END");
+    processMainFunction(treeRoot);
+    if(compilerOptions.optimizations[UNREACHABLE_CODE_ELIMINATION]) {
+        removeUnreachableFunctions();
+    }
+    if(compilerOptions.dumpCfg) {
+        // the graphs replace the code
+        Stack* graphs = buildControlFlowGraphs();
+        dumpControlFlowGraphs(graphs, stdout);
+        freeControlFlowGraphs(graphs);
+        removeCommands(0, nextCommandIndex());
+    } else {
+        addCommand("END");
+    }
+    flushCommands();
+    if(staticFunctions != NULL) {
+        freeStaticFunctions(staticFunctions);
+    }
 }
 
 void processMainFunction(TreeNodePtr node) {
@@ -142,41 +312,83 @@ void processMainFunction(TreeNodePtr node) {
     FunctionDescriptorPtr functionDescriptor = addMainFunction();
     freeFunctionHeader(functionHeader);
 
+    if(compilerOptions.optimizations[UNREACHABLE_CODE_ELIMINATION]) {
+        enterFunctionCode(functionDescriptor);
+    }
     addCommand("MAIN");
 
     processBlock(node->subtrees[1]);
+    completeFrameAllocation(functionDescriptor);
 
     if(functionDescriptor->variablesDisplacement > 0) {
         addCommand("DLOC %d", functionDescriptor->variablesDisplacement);
     }
     addCommand("STOP");
+    if(compilerOptions.optimizations[UNREACHABLE_CODE_ELIMINATION]) {
+        leaveFunctionCode();
+    }
 }
 
-void processFunction(TreeNodePtr node) {
+void processFunction(TreeNodePtr node, TreeNodePtr enclosingBlockNode) {
 
     if(node->category != FUNCTION_NODE) {
         UnexpectedNodeCategoryError(FUNCTION_NODE, node->category);
     }
 
     FunctionHeaderPtr functionHeader = processFunctionHeader(node->subtrees[0]);
+    if(compilerOptions.optimizations[COPY_ELISION]) {
+        findReadOnlyParameters(node, functionHeader, enclosingBlockNode);
+    }
+    if(compilerOptions.optimizations[FUNCTION_SPECIALIZATION]) {
+        findConstantParameters(node, functionHeader);
+    }
     SymbolTableEntryPtr entry = addFunction(functionHeader);
     freeFunctionHeader(functionHeader);
+
+    processFunctionDeclaration(node, entry);
+
+    if(compilerOptions.optimizations[PURE_CALL_EVALUATION]) {
+        selectPureFunction(node, entry);
+    }
+    if(compilerOptions.optimizations[INLINE_FUNCTIONS]) {
+        selectInlineCandidate(node, entry);
+    }
+    endFunctionLevel();
+}
+
+/* Compiles a function added to the symbol table, the identifier of its entry may differ from the declared one */
+void processFunctionDeclaration(TreeNodePtr node, SymbolTableEntryPtr entry) {
     FunctionDescriptorPtr functionDescriptor = entry->description.functionDescriptor;
+    if(isStaticFunction(staticFunctions, node)) {
+        placeStaticLocals(functionDescriptor);
+    }
 
+    if(compilerOptions.optimizations[UNREACHABLE_CODE_ELIMINATION]) {
+        enterFunctionCode(functionDescriptor);
+    }
     addCommand("L%d: ENFN %d  \t%s",
                functionDescriptor->headerMepaLabel,
                entry->level,
                entry->identifier);
 
+    // the tail calls jump to the body, after the activation record is allocated
+    char* declaredIdentifier = node->subtrees[0]->subtrees[1]->name;
+    if(compilerOptions.optimizations[TAIL_CALL_ELIMINATION] && hasSelfTailCall(node, declaredIdentifier)) {
+        functionDescriptor->bodyMepaLabel = nextMEPALabel();
+    }
+
     processBlock(node->subtrees[1]);
+    completeFrameAllocation(functionDescriptor);
+    reserveStaticLocals(functionDescriptor);
 
     addCommand("L%d: NOOP", functionDescriptor->returnMepaLabel);
-    if(functionDescriptor->variablesDisplacement > 0) {
-        addCommand("DLOC %d", functionDescriptor->variablesDisplacement);
+    if(allocatedLocalsSize(functionDescriptor) > 0) {
+        addCommand("DLOC %d", allocatedLocalsSize(functionDescriptor));
     }
     addCommand("RTRN %d  \tend function", functionDescriptor->parametersSize);
-
-    endFunctionLevel();
+    if(compilerOptions.optimizations[UNREACHABLE_CODE_ELIMINATION]) {
+        leaveFunctionCode();
+    }
 }
 
 FunctionHeaderPtr processFunctionHeader(TreeNodePtr node) {
@@ -201,28 +413,41 @@ TypeDescriptorPtr processFunctionReturnType(TreeNodePtr node) {
 }
 
 ParameterPtr processFormalParameter(TreeNodePtr node) {
-    if(node == NULL) {
-        return NULL;
-    }
+    ParameterPtr parameters = NULL;
+    // the last parameter of the list, so each parameter group is appended without walking the list again
+    ParameterPtr lastParameter = NULL;
 
-    ParameterPtr parameters;
-    switch (node->category) {
-        case EXPRESSION_PARAMETER_BY_REFERENCE_NODE:
-            parameters = processParameterByReference(node);
-            break;
-        case EXPRESSION_PARAMETER_BY_VALUE_NODE:
-            parameters = processParameterByValue(node);
-            break;
-        case FUNCTION_PARAMETER_NODE:
-            parameters = processFunctionParameter(node);
-            break;
-        default:
-            UnexpectedChildNodeCategoryError(FUNCTION_HEADER_NODE, node->category);
-    }
+    TreeNodePtr currentNode = node;
+    while (currentNode != NULL) {
+        ParameterPtr groupParameters;
+        switch (currentNode->category) {
+            case EXPRESSION_PARAMETER_BY_REFERENCE_NODE:
+                groupParameters = processParameterByReference(currentNode);
+                break;
+            case EXPRESSION_PARAMETER_BY_VALUE_NODE:
+                groupParameters = processParameterByValue(currentNode);
+                break;
+            case FUNCTION_PARAMETER_NODE:
+                groupParameters = processFunctionParameter(currentNode);
+                break;
+            default:
+                UnexpectedChildNodeCategoryError(FUNCTION_HEADER_NODE, currentNode->category);
+        }
+
+        if(lastParameter == NULL) {
+            parameters = groupParameters;
+        } else {
+            lastParameter->next = groupParameters;
+        }
+        lastParameter = groupParameters;
+        while (lastParameter->next != NULL) {
+            lastParameter = lastParameter->next;
+        }
 
-    ParameterPtr nextParameters = processFormalParameter(node->next);
+        currentNode = currentNode->next;
+    }
 
-    return concatenateParameters(parameters, nextParameters);
+    return parameters;
 }
 
 ParameterPtr processParameterByReference(TreeNodePtr node) {
@@ -255,6 +480,8 @@ ParameterPtr processParameter(TreeNodePtr node, ParameterPassage passage) {
         parameter->name = processIdentifier(identifierNode);
         parameter->passage = passage;
         parameter->type = type;
+        parameter->byAddress = false;
+        parameter->readOnly = false;
         parameter->next = NULL;
 
         // keeps the head of the list
@@ -286,6 +513,8 @@ ParameterPtr processFunctionParameter(TreeNodePtr node) {
     parameter->name = functionHeader->name;
     parameter->passage = FUNCTION_PARAMETER;
     parameter->type = newFunctionType(functionHeader);
+    parameter->byAddress = false;
+    parameter->readOnly = false;
     parameter->next = NULL;
 
     freeFunctionHeader(functionHeader);
@@ -298,15 +527,22 @@ void processBlock(TreeNodePtr node) {
         UnexpectedNodeCategoryError(BLOCK_NODE, node->category);
     }
 
+    TreeNodePtr enclosingBlockNode = currentBlockNode;
+    currentBlockNode = node;
+
     processLabels(node->subtrees[0]);
 
     processTypes(node->subtrees[1]);
 
-    processVariables(node->subtrees[2]);
+    processVariables(node->subtrees[2], node);
 
     FunctionDescriptorPtr functionDescriptor = findCurrentFunctionDescriptor();
-    if(functionDescriptor->variablesDisplacement > 0) {
-        addCommand("ALOC %d", functionDescriptor->variablesDisplacement);
+    reserveStaticLocals(functionDescriptor);
+    if(commandsBuffered()) {
+        // the body may still add temporaries to the activation record, see completeFrameAllocation
+        functionDescriptor->frameAllocationCommand = addPlaceholderCommand();
+    } else if(allocatedLocalsSize(functionDescriptor) > 0) {
+        addCommand("ALOC %d", allocatedLocalsSize(functionDescriptor));
     }
 
     TreeNodePtr functionsNode = node->subtrees[3];
@@ -315,16 +551,62 @@ void processBlock(TreeNodePtr node) {
         if(functionDescriptor->bodyMepaLabel <= 0) {
             functionDescriptor->bodyMepaLabel = nextMEPALabel();
         }
+        if(compilerOptions.optimizations[UNREACHABLE_CODE_ELIMINATION]) {
+            setBodyJumpCommand(nextCommandIndex());
+        }
         addCommand("JUMP L%d", functionDescriptor->bodyMepaLabel);
     }
-    processFunctions(functionsNode);
+    processFunctions(functionsNode, node);
+    // the versions are only called by the body and by each other
+    Stack* versions = NULL;
+    if(compilerOptions.optimizations[FUNCTION_SPECIALIZATION] && functionsNode != NULL) {
+        versions = processFunctionVersions(node);
+    }
 
 
-    if(functionsNode != NULL) {
+    placeStaticTemporaries(functionDescriptor);
+
+    if(functionDescriptor->bodyMepaLabel > 0) {
         addCommand("L%d: NOOP  \tbody", functionDescriptor->bodyMepaLabel);
     }
     processBody(node->subtrees[4]);
 
+    if(versions != NULL) {
+        removeUncalledVersions(versions);
+        releaseFunctionVersions(versions);
+    }
+    currentBlockNode = enclosingBlockNode;
+}
+
+/*
+ * Fills the buffered commands depending on the activation record size, once the function's body was compiled: the
+ * allocation of the local area and the label entries (ENLB restores the stack to the end of the local area)
+ */
+void completeFrameAllocation(FunctionDescriptorPtr functionDescriptor) {
+    if(!commandsBuffered()) {
+        return;
+    }
+
+    if(allocatedLocalsSize(functionDescriptor) > 0) {
+        replaceCommand(functionDescriptor->frameAllocationCommand, "ALOC %d", allocatedLocalsSize(functionDescriptor));
+    }
+    find(getSymbolTable()->stack, functionDescriptor, completeLabelEntry);
+}
+
+bool completeLabelEntry(void* data, void* secondParam) {
+    SymbolTableEntryPtr entry = (SymbolTableEntryPtr) data;
+    FunctionDescriptorPtr functionDescriptor = (FunctionDescriptorPtr) secondParam;
+
+    if(entry->category == LABEL_SYMBOL && entry->level == getFunctionLevel() &&
+       entry->description.labelDescriptor->commandIndex >= 0) {
+        replaceCommand(entry->description.labelDescriptor->commandIndex, "L%d: ENLB %d,%d  \t%s:",
+                       entry->description.labelDescriptor->mepaLabel,
+                       entry->level,
+                       allocatedLocalsSize(functionDescriptor),
+                       entry->identifier);
+    }
+    // every label of the function is visited
+    return false;
 }
 
 void processLabels(TreeNodePtr node) {
@@ -374,7 +656,10 @@ void processTypeDeclaration(TreeNodePtr node) {
     addType(identifier, type);
 }
 
-void processVariables(TreeNodePtr node) {
+/*
+ * The block is searched for the uses of the variables, see findUnusedVariables, findLiveRanges and findReturnedVariable
+ */
+void processVariables(TreeNodePtr node, TreeNodePtr blockNode) {
     if(node == NULL) {
         return;
     }
@@ -383,31 +668,57 @@ void processVariables(TreeNodePtr node) {
         UnexpectedNodeCategoryError(VARIABLES_NODE, node->category);
     }
 
+    Stack* unusedVariables = compilerOptions.optimizations[DEAD_STORE_ELIMINATION] ?
+                             findUnusedVariables(blockNode) : newStack();
+    Stack* liveRanges = compilerOptions.optimizations[STACK_SLOT_SHARING] ? findLiveRanges(blockNode) : NULL;
+    char* returnedVariable = NULL;
+    if(compilerOptions.optimizations[COPY_ELISION] && findCurrentFunctionDescriptor()->returnType != NULL) {
+        returnedVariable = findReturnedVariable(blockNode);
+    }
+    // a static local area starts after the ones placed before it, see placeStaticLocals
+    int localsStart = findCurrentFunctionDescriptor()->variablesDisplacement;
+
     TreeNodePtr variableDeclarationNode = node->subtrees[0];
     while (variableDeclarationNode != NULL) {
 
-        processVariableDeclaration(variableDeclarationNode);
+        processVariableDeclaration(variableDeclarationNode, unusedVariables, liveRanges, returnedVariable, localsStart);
 
         variableDeclarationNode = variableDeclarationNode->next;
     }
+    freeIdentifiers(unusedVariables);
+    if(liveRanges != NULL) {
+        freeLiveRanges(liveRanges);
+    }
 }
 
-void processVariableDeclaration(TreeNodePtr node) {
+void processVariableDeclaration(TreeNodePtr node, Stack* unusedVariables, Stack* liveRanges, char* returnedVariable,
+                                int localsStart) {
     if(node->category != DECLARATION_NODE) {
         UnexpectedNodeCategoryError(DECLARATION_NODE, node->category);
     }
 
     TypeDescriptorPtr type = processType(node->subtrees[1]);
+    FunctionDescriptorPtr functionDescriptor = findCurrentFunctionDescriptor();
 
     TreeNodePtr identifierNode = node->subtrees[0];
     while(identifierNode != NULL) {
         char* identifier = processIdentifier(identifierNode);
-        addVariable(identifier, type);
+        if(isListedIdentifier(unusedVariables, identifier)) {
+            addUnusedVariable(identifier, type);
+        } else if(returnedVariable != NULL && strcmp(identifier, returnedVariable) == 0 &&
+                  equivalentTypes(type, functionDescriptor->returnType)) {
+            // the variable lives in the result's position, so the returns need no copy, see isResultVariable
+            addVariableAt(identifier, type, functionDescriptor->returnDisplacement);
+        } else if(liveRanges != NULL) {
+            addVariableAt(identifier, type, localsStart + placeVariable(liveRanges, identifier, type->size));
+        } else {
+            addVariable(identifier, type);
+        }
         identifierNode = identifierNode->next;
     }
 }
 
-void processFunctions(TreeNodePtr node) {
+void processFunctions(TreeNodePtr node, TreeNodePtr blockNode) {
     if(node == NULL) {
         return;
     }
@@ -418,7 +729,7 @@ void processFunctions(TreeNodePtr node) {
 
     TreeNodePtr functionNode = node->subtrees[0];
     while (functionNode != NULL) {
-        processFunction(functionNode);
+        processFunction(functionNode, blockNode);
         functionNode = functionNode->next;
     }
 }
@@ -486,8 +797,25 @@ void processBody(TreeNodePtr node) {
     }
 
     TreeNodePtr statementNode = node->subtrees[0];
+    TreeNodePtr previousStatementNode = NULL;
     while (statementNode != NULL) {
+        precedingStatement = previousStatementNode != NULL && !isLabeledStatement(statementNode) ?
+                             getUnlabeledStatement(previousStatementNode) : NULL;
         processStatement(statementNode);
+
+        if(compilerOptions.optimizations[UNREACHABLE_CODE_ELIMINATION] && !unreachableStatements &&
+           isJump(getUnlabeledStatement(statementNode))) {
+            // only a goto reaches the statements following a jump, so they are unreachable up to the next label
+            int firstCommand = nextCommandIndex();
+            unreachableStatements = true;
+            while (statementNode->next != NULL && !isLabeledStatement(statementNode->next)) {
+                statementNode = statementNode->next;
+                processStatement(statementNode);
+            }
+            unreachableStatements = false;
+            removeCommands(firstCommand, nextCommandIndex());
+        }
+        previousStatementNode = statementNode;
         statementNode = statementNode->next;
     }
 }
@@ -505,7 +833,9 @@ void processStatement(TreeNodePtr node) {
     }
 
     processLabel(labelNode);
+    beginStraightLineStatement(node);
     processUnlabeledStatement(unlabeledStatementNode);
+    endStraightLineStatement(node);
 
 }
 
@@ -536,12 +866,24 @@ void processLabel(TreeNodePtr node) {
     LabelDescriptorPtr labelDescriptor = symbolTableEntry->description.labelDescriptor;
     labelDescriptor->defined = true;
 
+    // the nested functions were compiled before the body, so all the gotos from them are known: the other gotos are
+    // statements of this function, where the stack already ends at the local area
+    if(compilerOptions.optimizations[LOCAL_LABELS] && !labelDescriptor->nonLocalGoto) {
+        addCommand("L%d: NOOP  \t%s:", labelDescriptor->mepaLabel, identifier);
+        return;
+    }
+
+    if(commandsBuffered()) {
+        labelDescriptor->commandIndex = addPlaceholderCommand();
+        return;
+    }
+
     // current activation record displacement = its allocated variables displacement
     FunctionDescriptorPtr functionDescriptor = findCurrentFunctionDescriptor();
     addCommand("L%d: ENLB %d,%d  \t%s:",
                labelDescriptor->mepaLabel,
                symbolTableEntry->level,
-               functionDescriptor->variablesDisplacement,
+               allocatedLocalsSize(functionDescriptor),
                identifier);
 }
 
@@ -582,13 +924,22 @@ void processAssignment(TreeNodePtr node) {
         UnexpectedNodeCategoryError(ASSIGNMENT_NODE, node->category);
     }
 
+    // the store is dead and the value has no side effects, the assignment is only compiled for its checks
+    bool deadStore = compilerOptions.optimizations[DEAD_STORE_ELIMINATION] &&
+                     isUnusedVariable(findIdentifier(node->subtrees[0]->subtrees[0]->name));
+    discardCommands(deadStore);
     Value value = processValue(node->subtrees[0]);
     TypeDescriptorPtr exprType = processExpression(node->subtrees[1]);
+    discardCommands(false);
 
     if(!equivalentTypes(exprType, value.type)) {
         throwSemanticError("Trying to assign value to variable of incompatible type");
     }
 
+    if(deadStore) {
+        return;
+    }
+
     switch (value.category) {
         case ARRAY_VALUE:
         case ARRAY_REFERENCE:
@@ -604,6 +955,11 @@ void processAssignment(TreeNodePtr node) {
             throwSemanticError("Constants can't be assigned");
             break;
     }
+
+    InductionVariablePtr inductionVariable = findInductionUpdate(activeInductionVariables, node);
+    if(inductionVariable != NULL) {
+        updateInductionAddresses(inductionVariable);
+    }
 }
 
 Value processValue(TreeNodePtr node) {
@@ -626,16 +982,50 @@ Value processValue(TreeNodePtr node) {
         }
         case ARRAY_VALUE:
         case ARRAY_REFERENCE: {
-            loadArrayBaseAddress(value);
-
             TreeNodePtr arrayIndexNode = node->subtrees[1];
-            processArrayIndexList(arrayIndexNode, &value);
 
-            return value;
+            CommonSubexpressionPtr subexpression = findCommonSubexpression(commonSubexpressions, node,
+                                                                           COMMON_ADDRESS);
+            if(subexpression != NULL) {
+                // the element's address is kept by a temporary, like an array by reference without subscripts
+                value.category = ARRAY_REFERENCE;
+                value.level = getLocalsLevel();
+                value.content.displacement = subexpression->displacement;
+                value.type = subexpression->type;
+                return processArraySubscripts(NULL, NULL, value);
+            }
+
+            LoopInvariantPtr invariant = findHoistedInvariant(hoistedInvariants, node);
+            if(invariant != NULL) {
+                // the address selected by the leading (or all the) subscripts is kept by a temporary, like an array by
+                // reference
+                value.category = ARRAY_REFERENCE;
+                value.level = getLocalsLevel();
+                value.content.displacement = invariant->displacement;
+                value.type = invariant->type;
+                arrayIndexNode = skipSubscripts(arrayIndexNode, invariant->subscripts);
+            }
+
+            return processArraySubscripts(arrayIndexNode, NULL, value);
         }
     }
 }
 
+/*
+ * Leaves on top of the stack the address of the element selected by the subscripts from node until end (exclusive)
+ */
+Value processArraySubscripts(TreeNodePtr node, TreeNodePtr end, Value value) {
+    if(compilerOptions.optimizations[FOLD_CONSTANT_INDICES] ||
+       compilerOptions.optimizations[LINEARIZE_ARRAY_ADDRESSING]) {
+        return processFoldedArrayIndexList(node, end, value);
+    }
+
+    loadArrayBaseAddress(value);
+    processArrayIndexList(node, end, &value);
+
+    return value;
+}
+
 void loadArrayBaseAddress(Value value) {
     switch (value.category) {
         case ARRAY_VALUE:
@@ -649,13 +1039,13 @@ void loadArrayBaseAddress(Value value) {
     }
 }
 
-void processArrayIndexList(TreeNodePtr node, Value* value) {
+void processArrayIndexList(TreeNodePtr node, TreeNodePtr end, Value* value) {
     if(node == NULL) {
         return;
     }
 
     TreeNodePtr currentIndexNode = node;
-    while (currentIndexNode != NULL) {
+    while (currentIndexNode != end) {
         processArrayIndex(currentIndexNode, value);
         currentIndexNode = currentIndexNode->next;
     }
@@ -682,6 +1072,134 @@ void processArrayIndex(TreeNodePtr node, Value* value) {
     value->type = arrayElementType;
 }
 
+/*
+ * The parts of the subscripts known at compile time are added up into a single displacement instead of being indexed
+ * one by one: an element of a local array with only constant subscripts is accessed directly at "base + offset", like
+ * a simple variable, otherwise the constant offset is added to the base address (by LADR for local arrays and by one
+ * "LDCT offset; INDX 1" after the variable subscripts for arrays passed by reference).
+ * The element address is linear on the subscripts (base + sum of subscript * stride), so each variable subscript is
+ * still indexed by its stride with INDX, which already is MEPA's multiply-add instruction. With
+ * -flinearize-array-addressing a subscript like "i + c" or "i - c" also contributes its constant term to the offset
+ * and only "i" is indexed.
+ */
+Value processFoldedArrayIndexList(TreeNodePtr node, TreeNodePtr end, Value value) {
+    TypeDescriptorPtr arrayType = value.type;
+    bool splitSubscripts = compilerOptions.optimizations[LINEARIZE_ARRAY_ADDRESSING];
+
+    int constantOffset = 0;
+    bool allConstant = true;
+    int subscript = 0;
+    for (TreeNodePtr indexNode = node; indexNode != end; indexNode = indexNode->next, subscript++) {
+        if(indexNode->category != ARRAY_INDEX_NODE) {
+            UnexpectedNodeCategoryError(ARRAY_INDEX_NODE, indexNode->category);
+        }
+        if(arrayType->category != ARRAY_TYPE || subscript >= arrayType->description.arrayDescriptor->subscripts) {
+            throwSemanticError("Expected array type to process array index");
+        }
+
+        int stride = arrayType->description.arrayDescriptor->strides[subscript];
+        int constant;
+        TreeNodePtr variablePart = splitSubscript(indexNode->subtrees[0], splitSubscripts, &constant);
+        constantOffset += constant * stride;
+        if(variablePart != NULL) {
+            allConstant = false;
+        }
+        value.type = value.type->description.arrayDescriptor->elementType;
+    }
+
+    if(value.category == ARRAY_VALUE && allConstant && value.type->category != ARRAY_TYPE) {
+        value.category = VALUE;
+        value.content.displacement += constantOffset;
+        return value;
+    }
+
+    if(value.category == ARRAY_VALUE) {
+        addCommand("LADR %d,%d", value.level, value.content.displacement + constantOffset);
+    } else {
+        addCommand("LDVL %d,%d", value.level, value.content.displacement);
+    }
+
+    subscript = 0;
+    for (TreeNodePtr indexNode = node; indexNode != end; indexNode = indexNode->next, subscript++) {
+        int constant;
+        TreeNodePtr variablePart = splitSubscript(indexNode->subtrees[0], splitSubscripts, &constant);
+        if(variablePart == NULL) {
+            continue;
+        }
+
+        TypeDescriptorPtr variablePartType;
+        switch (variablePart->category) {
+            case EXPRESSION_NODE:
+                variablePartType = processExpression(variablePart);
+                break;
+            case BINARY_OPERATOR_EXPRESSION_NODE:
+                variablePartType = processBinaryOpExpression(variablePart);
+                break;
+            default:
+                variablePartType = processTerm(variablePart);
+        }
+        if(!equivalentTypes(variablePartType, getSymbolTable()->integerTypeDescriptor)) {
+            throwSemanticError("Index should be an integer");
+        }
+        addCommand("INDX %d", arrayType->description.arrayDescriptor->strides[subscript]);
+    }
+
+    if(value.category == ARRAY_REFERENCE && constantOffset != 0) {
+        addCommand("LDCT %d", constantOffset);
+        addCommand("INDX 1");
+    }
+
+    return value;
+}
+
+TreeNodePtr skipSubscripts(TreeNodePtr node, int subscripts) {
+    TreeNodePtr indexNode = node;
+    for (int i = 0; i < subscripts; i++) {
+        indexNode = indexNode->next;
+    }
+    return indexNode;
+}
+
+/*
+ * Splits a subscript in a part evaluated at runtime and a constant, returns the node of the runtime part (an
+ * expression, binary operator expression or term node) or NULL for constant subscripts. Only "e + c", "c + e" and
+ * "e - c" are split when splitConstantTerms is set, the other subscripts are either constant or runtime as a whole.
+ */
+TreeNodePtr splitSubscript(TreeNodePtr expressionNode, bool splitConstantTerms, int* constant) {
+    if(evaluateConstantExpression(expressionNode, constant)) {
+        return NULL;
+    }
+
+    *constant = 0;
+    TreeNodePtr binaryOpNode = expressionNode->subtrees[0];
+    if(!splitConstantTerms || expressionNode->subtrees[1] != NULL ||
+       binaryOpNode->category != BINARY_OPERATOR_EXPRESSION_NODE || binaryOpNode->subtrees[1] == NULL) {
+        return expressionNode;
+    }
+
+    // the binary operator expression is "term operator rest"
+    TreeNodePtr termNode = binaryOpNode->subtrees[0];
+    NodeCategory operator = binaryOpNode->subtrees[1]->subtrees[0]->category;
+    TreeNodePtr restNode = binaryOpNode->subtrees[2];
+
+    long long term;
+    long long rest;
+    if(operator == PLUS_NODE && evaluateTerm(termNode, &term)) {
+        *constant = (int) term;
+        return restNode;
+    }
+    if(operator == PLUS_NODE && restNode->subtrees[1] == NULL && evaluateTerm(restNode->subtrees[0], &rest)) {
+        *constant = (int) rest;
+        return termNode;
+    }
+    if(operator == MINUS_NODE && restNode->subtrees[1] == NULL && evaluateTerm(restNode->subtrees[0], &rest) &&
+       rest != INT_MIN) {
+        *constant = (int) -rest;
+        return termNode;
+    }
+    return expressionNode;
+}
+
 TypeDescriptorPtr processFunctionCall(TreeNodePtr node) {
     if(node->category != FUNCTION_CALL_NODE) {
         UnexpectedNodeCategoryError(FUNCTION_CALL_NODE, node->category);
@@ -714,6 +1232,10 @@ TypeDescriptorPtr processFunctionParameterCall(TreeNodePtr node, SymbolTableEntr
         throwSemanticError("Expected function as parameter");
     }
 
+    if(parameterDescriptor->boundFunction != NULL) {
+        return processRegularFunctionCall(node, parameterDescriptor->boundFunction);
+    }
+
     TypeDescriptorPtr returnType = parameterType->description.functionTypeDescriptor->returnType;
     if(returnType!= NULL && returnType->size > 0) {
         addCommand("ALOC %d  \tresult", returnType->size);
@@ -721,7 +1243,7 @@ TypeDescriptorPtr processFunctionParameterCall(TreeNodePtr node, SymbolTableEntr
 
     ParameterDescriptorsListPtr expectedParameters =
             parameterType->description.functionTypeDescriptor->parameters;
-    processArgumentsList(node->subtrees[1], expectedParameters);
+    processArgumentsList(node->subtrees[1], expectedParameters, NULL);
 
     addCommand("CPFN %d,%d,%d",
                functionEntry->level,
@@ -734,13 +1256,36 @@ TypeDescriptorPtr processFunctionParameterCall(TreeNodePtr node, SymbolTableEntr
 TypeDescriptorPtr processRegularFunctionCall(TreeNodePtr node, SymbolTableEntryPtr functionEntry) {
     FunctionDescriptorPtr functionDescriptor = functionEntry->description.functionDescriptor;
 
+    if(compilerOptions.optimizations[PURE_CALL_EVALUATION] && processEvaluatedCall(node, functionEntry)) {
+        return functionDescriptor->returnType;
+    }
+
+    if(compilerOptions.optimizations[INLINE_FUNCTIONS]) {
+        InlineCandidatePtr candidate = findInlineCandidate(functionDescriptor);
+        if(candidate != NULL) {
+            return processInlinedCall(node, candidate);
+        }
+    }
+
     TypeDescriptorPtr returnType = functionDescriptor->returnType;
     if(returnType!= NULL && returnType->size > 0) {
         addCommand("ALOC %d  \tresult", returnType->size);
     }
 
-    processArgumentsList(node->subtrees[1], functionDescriptor->parameters);
-    addCommand("CFUN L%d,%d", functionDescriptor->headerMepaLabel, getFunctionLevel());
+    // a version receives no arguments for its bound parameters, the other ones are passed like to the function
+    FunctionVersionPtr version = findCalledVersion(node, functionEntry);
+    FunctionDescriptorPtr calledDescriptor = version != NULL ? version->descriptor : functionDescriptor;
+
+    // the copies of the arguments passed by address are only needed during the call
+    FunctionDescriptorPtr callerDescriptor = findCurrentFunctionDescriptor();
+    int firstTemporary = callerDescriptor->temporariesDisplacement;
+    processArgumentsList(node->subtrees[1], functionDescriptor->parameters, version);
+    addCommand("CFUN L%d,%d", calledDescriptor->headerMepaLabel, getFunctionLevel());
+    referenceFunction(calledDescriptor);
+    if(version != NULL && !unreachableStatements) {
+        addVersionCall(version, compiledVersion);
+    }
+    releaseTemporaries(callerDescriptor, firstTemporary);
 
     return functionDescriptor->returnType;
 }
@@ -763,59 +1308,71 @@ TypeDescriptorPtr processPseudoFunctionCall(TreeNodePtr node, SymbolTableEntryPt
 }
 
 void processReadFunctionCall(TreeNodePtr argumentNode) {
-    if(argumentNode == NULL) {
-        return;
-    }
+    TreeNodePtr currentNode = argumentNode;
+    while (currentNode != NULL) {
 
-    addCommand("READ");
+        // We can only read a value from stdin into a variable/parameter
+        TreeNodePtr valueNode = getValueExpression(currentNode);
+        Value value = processValue(valueNode);
 
-    // We can only read a value from stdin into a variable/parameter
-    TreeNodePtr valueNode = getValueExpression(argumentNode);
-    Value value = processValue(valueNode);
+        if(value.type->size > 1) {
+            throwSemanticError("Can't read multiple values at a time");
+        }
 
-    if(value.type->size > 1) {
-        throwSemanticError("Can't read multiple values at a time");
-    }
+        // for array elements the address computed by processValue must be below the read value
+        addCommand("READ");
 
-    switch (value.category) {
-        case ARRAY_VALUE:
-        case ARRAY_REFERENCE:
-            addCommand("STMV 1");
-            break;
-        case REFERENCE:
-            addCommand("STVI %d,%d", value.level, value.content.displacement);
-            break;
-        case VALUE:
-            addCommand("STVL %d,%d", value.level, value.content.displacement);
-            break;
-        case CONSTANT:
-            throwSemanticError("Can't read boolean value");
-            break;
-    }
+        switch (value.category) {
+            case ARRAY_VALUE:
+            case ARRAY_REFERENCE:
+                addCommand("STMV 1");
+                break;
+            case REFERENCE:
+                addCommand("STVI %d,%d", value.level, value.content.displacement);
+                break;
+            case VALUE:
+                addCommand("STVL %d,%d", value.level, value.content.displacement);
+                break;
+            case CONSTANT:
+                throwSemanticError("Can't read boolean value");
+                break;
+        }
 
-    processReadFunctionCall(argumentNode->next);
+        currentNode = currentNode->next;
+    }
 }
 
 void processWriteFunctionCall(TreeNodePtr argumentNode) {
-    if(argumentNode == NULL) {
-        return;
-    }
-
-    processExpression(argumentNode);
-    addCommand("PRNT");
+    TreeNodePtr currentNode = argumentNode;
+    while (currentNode != NULL) {
+        processExpression(currentNode);
+        addCommand("PRNT");
 
-    processWriteFunctionCall(argumentNode->next);
+        currentNode = currentNode->next;
+    }
 }
 
-void processArgumentsList(TreeNodePtr node, ParameterDescriptorsListPtr parameters) {
+/*
+ * The arguments for the function parameters and the bound constants are left out when a version is called, the version
+ * matched them already (see findCallVersion)
+ */
+void processArgumentsList(TreeNodePtr node, ParameterDescriptorsListPtr parameters, FunctionVersionPtr version) {
 
     TreeNodePtr currentNode = node;
     ParameterDescriptorsListPtr currentParameter = parameters;
+    int position = 0;
     while (currentParameter != NULL && currentNode != NULL) {
 
         switch (currentParameter->descriptor->parameterPassage) {
             case VALUE_PARAMETER: {
-                processArgumentByValue(currentParameter->descriptor, currentNode);
+                if(version != NULL && bindsConstant(version, position)) {
+                    break;
+                }
+                if(currentParameter->descriptor->byAddress) {
+                    processArgumentByAddress(currentParameter->descriptor, currentNode, node, parameters);
+                } else {
+                    processArgumentByValue(currentParameter->descriptor, currentNode);
+                }
                 break;
             }
             case VARIABLE_PARAMETER: {
@@ -823,13 +1380,16 @@ void processArgumentsList(TreeNodePtr node, ParameterDescriptorsListPtr paramete
                 break;
             }
             case FUNCTION_PARAMETER: {
-                processArgumentByFunctionAsParameter(currentParameter->descriptor, currentNode);
+                if(version == NULL) {
+                    processArgumentByFunctionAsParameter(currentParameter->descriptor, currentNode);
+                }
                 break;
             }
         }
 
         currentParameter = currentParameter->next;
         currentNode = currentNode->next;
+        position++;
     }
 
     if(currentParameter != NULL) {
@@ -849,6 +1409,30 @@ void processArgumentByValue(ParameterDescriptorPtr expectedParameter, TreeNodePt
     }
 }
 
+/*
+ * An array the callee never writes is passed by address: the argument's own address when nothing writes it during the
+ * call, otherwise the address of a copy in a temporary
+ */
+void processArgumentByAddress(ParameterDescriptorPtr expectedParameter, TreeNodePtr node, TreeNodePtr argumentsNode,
+                              ParameterDescriptorsListPtr parameters) {
+    TreeNodePtr valueNode = getSingleValueNode(node);
+    if(valueNode != NULL && isUnchangedByCall(valueNode, argumentsNode, parameters)) {
+        // process value already left the address on top of the stack
+        Value value = processValue(valueNode);
+        if(!equivalentTypes(expectedParameter->type, value.type)) {
+            throwSemanticError("Wrong parameter type on function");
+        }
+        return;
+    }
+
+    int size = expectedParameter->type->size;
+    int displacement = allocateTemporary(findCurrentFunctionDescriptor(), size);
+    addCommand("LADR %d,%d", getLocalsLevel(), displacement);
+    processArgumentByValue(expectedParameter, node);
+    addCommand("STMV %d", size);
+    addCommand("LADR %d,%d", getLocalsLevel(), displacement);
+}
+
 void processArgumentByReference(ParameterDescriptorPtr expectedParameter, TreeNodePtr node) {
     // Arguments by reference can only be a value, it cannot be any expression
     TreeNodePtr valueNode = getValueExpression(node);
@@ -911,6 +1495,7 @@ void processDeclaredFunctionAsArgument(ParameterDescriptorPtr expectedParameter,
     addCommand("LGAD L%d,%d",
                valueEntry->description.functionDescriptor->headerMepaLabel,
                valueEntry->level - 1);
+    referenceFunction(valueEntry->description.functionDescriptor);
 }
 
 void processFunctionParameterAsArgument(ParameterDescriptorPtr expectedParameter, SymbolTableEntryPtr valueEntry) {
@@ -921,17 +1506,22 @@ void processFunctionParameterAsArgument(ParameterDescriptorPtr expectedParameter
         throwSemanticError("Expected function as parameter");
     }
 
+    if(argumentDescriptor->boundFunction != NULL) {
+        processDeclaredFunctionAsArgument(expectedParameter, argumentDescriptor->boundFunction);
+        return;
+    }
+
     if(!equivalentTypes(expectedParameter->type, argumentDescriptor->type)) {
         throwSemanticError("Wrong parameter type on function");
     }
 
     // generalized address is already on the stack as the current function parameter
     // MEPA address
-    addCommand("LDVL %s,%d", valueEntry->level, argumentDescriptor->displacement);
+    addCommand("LDVL %d,%d", valueEntry->level, argumentDescriptor->displacement);
     // base register D[k]
-    addCommand("LDVL %s,%d", valueEntry->level, argumentDescriptor->displacement + 1);
+    addCommand("LDVL %d,%d", valueEntry->level, argumentDescriptor->displacement + 1);
     // level k
-    addCommand("LDVL %s,%d", valueEntry->level, argumentDescriptor->displacement + 2);
+    addCommand("LDVL %d,%d", valueEntry->level, argumentDescriptor->displacement + 2);
 }
 
 void processGoto(TreeNodePtr node) {
@@ -945,6 +1535,9 @@ void processGoto(TreeNodePtr node) {
     if(labelEntry->category != LABEL_SYMBOL) {
         UnexpectedSymbolEntryCategoryError01(LABEL_SYMBOL, labelEntry->category);
     }
+    if(labelEntry->level < getFunctionLevel()) {
+        labelEntry->description.labelDescriptor->nonLocalGoto = true;
+    }
 
     addCommand("JUMP L%d  \tgoto %s",
                labelEntry->description.labelDescriptor->mepaLabel,
@@ -956,6 +1549,11 @@ void processReturn(TreeNodePtr node) {
         UnexpectedNodeCategoryError(RETURN_NODE, node->category);
     }
 
+    if(inlineExpansions->size > 0) {
+        processInlinedReturn(node, (InlineExpansionPtr) inlineExpansions->top->data);
+        return;
+    }
+
     FunctionDescriptorPtr functionDescriptor = findCurrentFunctionDescriptor();
 
     TreeNodePtr expressionNode = node->subtrees[0];
@@ -971,6 +1569,15 @@ void processReturn(TreeNodePtr node) {
 }
 
 void processReturnWithValue(TreeNodePtr expressionNode, FunctionDescriptorPtr functionDescriptor) {
+    if(compilerOptions.optimizations[TAIL_CALL_ELIMINATION] && functionDescriptor->bodyMepaLabel > 0 &&
+       processSelfTailCall(expressionNode, functionDescriptor)) {
+        return;
+    }
+    if(compilerOptions.optimizations[COPY_ELISION] && isResultVariable(expressionNode, functionDescriptor)) {
+        addCommand("JUMP L%d", functionDescriptor->returnMepaLabel);
+        return;
+    }
+
     // the returned array address must be loaded before the values to be stored on the return displacement
     if(functionDescriptor->returnType->size > 1) {
         addCommand("LADR %d,%d", getFunctionLevel(), functionDescriptor->returnDisplacement);
@@ -984,7 +1591,7 @@ void processReturnWithValue(TreeNodePtr expressionNode, FunctionDescriptorPtr fu
     if(expressionType->size == 1) {
         addCommand("STVL %d,%d", getFunctionLevel(), functionDescriptor->returnDisplacement);
     } else {
-        addCommand("STMV %d,%d", getFunctionLevel(), functionDescriptor->returnDisplacement);
+        addCommand("STMV %d", expressionType->size);
     }
     addCommand("JUMP L%d", functionDescriptor->returnMepaLabel);
 }
@@ -998,6 +1605,12 @@ void processConditional(TreeNodePtr node) {
     TreeNodePtr ifCompound = node->subtrees[1];
     TreeNodePtr elseCompound = node->subtrees[2];
 
+    bool condition;
+    if(boundConstants > 0 && evaluateConstantCondition(conditionNode, &condition)) {
+        processConstantConditional(node, condition);
+        return;
+    }
+
     int elseLabel = nextMEPALabel();
     int elseExitLabel = nextMEPALabel();
 
@@ -1010,7 +1623,9 @@ void processConditional(TreeNodePtr node) {
     processCompound(ifCompound);
 
     if(elseCompound != NULL) {
-        addCommand("JUMP L%d", elseExitLabel);
+        if(!compilerOptions.optimizations[UNREACHABLE_CODE_ELIMINATION] || !isJump(ifCompound)) {
+            addCommand("JUMP L%d", elseExitLabel);
+        }
 
         addCommand("L%d: NOOP  \telse", elseLabel);
         processCompound(elseCompound);
@@ -1026,6 +1641,32 @@ void processRepetitive(TreeNodePtr node) {
         UnexpectedNodeCategoryError(WHILE_NODE, node->category);
     }
 
+    TreeNodePtr initNode = precedingStatement;
+    if(compilerOptions.optimizations[LOOP_IDIOMS] && processLoopIdiom(node, initNode)) {
+        return;
+    }
+
+    if(compilerOptions.optimizations[LOOP_INVARIANT_CODE_MOTION] ||
+       compilerOptions.optimizations[INDUCTION_VARIABLES] ||
+       compilerOptions.optimizations[LOOP_UNROLLING]) {
+        Stack* inductionVariables = compilerOptions.optimizations[INDUCTION_VARIABLES] ?
+                                    findInductionVariables(node, hoistedInvariants) : newStack();
+        Stack* invariants = compilerOptions.optimizations[LOOP_INVARIANT_CODE_MOTION] ?
+                            findLoopInvariants(node, hoistedInvariants, inductionVariables) : newStack();
+        CountedLoopPtr countedLoop = compilerOptions.optimizations[LOOP_UNROLLING] ?
+                                     findCountedLoop(node, initNode, hoistedInvariants) : NULL;
+        if(countedLoop != NULL && !chooseUnrolledCopies(countedLoop, &unrollingBudget)) {
+            free(countedLoop);
+            countedLoop = NULL;
+        }
+        if(invariants->size > 0 || inductionVariables->size > 0 || countedLoop != NULL) {
+            processRotatedRepetitive(node, invariants, inductionVariables, countedLoop);
+            return;
+        }
+        free(invariants);
+        free(inductionVariables);
+    }
+
     TreeNodePtr conditionNode = node->subtrees[0];
     TreeNodePtr compoundNode = node->subtrees[1];
 
@@ -1033,10 +1674,7 @@ void processRepetitive(TreeNodePtr node) {
     int exitLabel = nextMEPALabel();
 
     addCommand("L%d: NOOP  \twhile", conditionLabel);
-    TypeDescriptorPtr expressionType = processExpression(conditionNode);
-    if(!equivalentTypes(expressionType, getSymbolTable()->booleanTypeDescriptor)) {
-        throwSemanticError("Expected boolean expression");
-    }
+    processLoopCondition(conditionNode);
     addCommand("JMPF L%d", exitLabel);
 
     processCompound(compoundNode);
@@ -1046,35 +1684,136 @@ void processRepetitive(TreeNodePtr node) {
 
 }
 
-void processCompound(TreeNodePtr node) {
-    if(node->category != COMPOUND_NODE) {
-        UnexpectedNodeCategoryError(COMPOUND_NODE, node->category);
-        return;
-    }
+/*
+ * The loop is rotated to evaluate its invariants only if it runs at least once: the condition is tested once before
+ * the loop, then the invariants and the addresses of the induction variables are kept in temporaries and the condition
+ * is tested again after each iteration.
+ * An iteration runs as many instructions as in the regular loop, minus the ones replaced by the temporaries, plus the
+ * updates of the induction variable addresses.
+ * An unrolled loop (countedLoop isn't NULL) tests the condition before the temporaries only if it has any and its trip
+ * count isn't known, see processUnrolledRepetitive
+ */
+void processRotatedRepetitive(TreeNodePtr node, Stack* invariants, Stack* inductionVariables,
+                              CountedLoopPtr countedLoop) {
+    TreeNodePtr conditionNode = node->subtrees[0];
+    TreeNodePtr compoundNode = node->subtrees[1];
 
-    TreeNodePtr unlabeledStatementNodeList = node->subtrees[0];
-    processUnlabeledStatementList(unlabeledStatementNodeList);
-}
+    FunctionDescriptorPtr functionDescriptor = findCurrentFunctionDescriptor();
+    int firstTemporary = functionDescriptor->temporariesDisplacement;
+    int hoistedBefore = hoistedOrder->size;
 
-void processUnlabeledStatementList(TreeNodePtr node) {
-    TreeNodePtr current = node;
-    while (current != NULL) {
-        processUnlabeledStatement(current);
-        current = current->next;
-    }
-}
+    int bodyLabel = nextMEPALabel();
+    int exitLabel = nextMEPALabel();
 
-TypeDescriptorPtr processExpression(TreeNodePtr node) {
-    if(node->category != EXPRESSION_NODE) {
-        UnexpectedNodeCategoryError(EXPRESSION_NODE, node->category);
+    if(countedLoop == NULL ||
+       (!countedLoop->constantTripCount && (invariants->size > 0 || inductionVariables->size > 0))) {
+        processLoopCondition(conditionNode);
+        addCommand("JMPF L%d  \twhile", exitLabel);
     }
 
-    TreeNodePtr firstExprNode = node->subtrees[0];
-    TreeNodePtr relationalOperatorNode = node->subtrees[1];
-    TreeNodePtr binaryOpExprNode = node->subtrees[2];
+    LoopInvariantPtr invariant;
+    while ((invariant = pop(invariants)) != NULL) {
+        evaluateLoopInvariant(invariant);
+    }
+    free(invariants);
 
-    if(relationalOperatorNode == NULL) {
-        return routeExpressionSubtree(firstExprNode);
+    for (LinkedNode* current = inductionVariables->top; current != NULL; current = current->next) {
+        InductionVariablePtr inductionVariable = (InductionVariablePtr) current->data;
+        for (LinkedNode* address = inductionVariable->addresses->top; address != NULL; address = address->next) {
+            evaluateInductionAddress((InductionAddressPtr) address->data);
+        }
+        activateInductionVariable(activeInductionVariables, inductionVariable, true);
+    }
+
+    if(countedLoop != NULL) {
+        processUnrolledRepetitive(node, countedLoop, exitLabel);
+        free(countedLoop);
+    } else {
+        addCommand("L%d: NOOP  \twhile body", bodyLabel);
+        processCompound(compoundNode);
+
+        processLoopCondition(conditionNode);
+        addCommand("JMPF L%d", exitLabel);
+        addCommand("JUMP L%d", bodyLabel);
+    }
+
+    addCommand("L%d: NOOP  \tend while", exitLabel);
+
+    while (hoistedOrder->size > hoistedBefore) {
+        LoopInvariantPtr invariant = pop(hoistedOrder);
+        mapPut(hoistedInvariants, invariant->node, NULL);
+        free(invariant);
+    }
+    while (inductionVariables->size > 0) {
+        InductionVariablePtr inductionVariable = pop(inductionVariables);
+        activateInductionVariable(activeInductionVariables, inductionVariable, false);
+        freeInductionVariable(inductionVariable);
+    }
+    free(inductionVariables);
+    releaseTemporaries(functionDescriptor, firstTemporary);
+}
+
+void processLoopCondition(TreeNodePtr conditionNode) {
+    TypeDescriptorPtr expressionType = processExpression(conditionNode);
+    if(!equivalentTypes(expressionType, getSymbolTable()->booleanTypeDescriptor)) {
+        throwSemanticError("Expected boolean expression");
+    }
+}
+
+void processCompound(TreeNodePtr node) {
+    if(node->category != COMPOUND_NODE) {
+        UnexpectedNodeCategoryError(COMPOUND_NODE, node->category);
+        return;
+    }
+
+    TreeNodePtr unlabeledStatementNodeList = node->subtrees[0];
+    processUnlabeledStatementList(unlabeledStatementNodeList);
+}
+
+void processUnlabeledStatementList(TreeNodePtr node) {
+    TreeNodePtr current = node;
+    TreeNodePtr previous = NULL;
+    while (current != NULL) {
+        precedingStatement = previous;
+        beginStraightLineStatement(current);
+        processUnlabeledStatement(current);
+        endStraightLineStatement(current);
+
+        if(compilerOptions.optimizations[UNREACHABLE_CODE_ELIMINATION] && !unreachableStatements &&
+           current->next != NULL && isJump(current)) {
+            // labels are only declared in the function's body, so nothing reaches the rest of the list
+            int firstCommand = nextCommandIndex();
+            unreachableStatements = true;
+            processUnlabeledStatementList(current->next);
+            unreachableStatements = false;
+            removeCommands(firstCommand, nextCommandIndex());
+            return;
+        }
+        previous = current;
+        current = current->next;
+    }
+}
+
+TypeDescriptorPtr processExpression(TreeNodePtr node) {
+    if(node->category != EXPRESSION_NODE) {
+        UnexpectedNodeCategoryError(EXPRESSION_NODE, node->category);
+    }
+
+    if(boundConstants > 0 && processFoldedConstant(node)) {
+        return getSymbolTable()->integerTypeDescriptor;
+    }
+
+    TypeDescriptorPtr hoistedType = loadHoistedInvariant(node);
+    if(hoistedType != NULL) {
+        return hoistedType;
+    }
+
+    TreeNodePtr firstExprNode = node->subtrees[0];
+    TreeNodePtr relationalOperatorNode = node->subtrees[1];
+    TreeNodePtr binaryOpExprNode = node->subtrees[2];
+
+    if(relationalOperatorNode == NULL) {
+        return routeExpressionSubtree(firstExprNode);
     }
 
     TypeDescriptorPtr firstExprType = routeExpressionSubtree(firstExprNode);
@@ -1104,6 +1843,15 @@ TypeDescriptorPtr processBinaryOpExpression(TreeNodePtr node) {
         UnexpectedNodeCategoryError(BINARY_OPERATOR_EXPRESSION_NODE, node->category);
     }
 
+    if(boundConstants > 0 && processFoldedConstant(node)) {
+        return getSymbolTable()->integerTypeDescriptor;
+    }
+
+    TypeDescriptorPtr hoistedType = loadHoistedInvariant(node);
+    if(hoistedType != NULL) {
+        return hoistedType;
+    }
+
     TreeNodePtr termNode = node->subtrees[0];
     TreeNodePtr operatorNode = node->subtrees[1];
     TreeNodePtr binaryOpExpressionNode = node->subtrees[2];
@@ -1130,6 +1878,11 @@ TypeDescriptorPtr processUnopExpression(TreeNodePtr node) {
         UnexpectedNodeCategoryError(UNARY_OPERATOR_EXPRESSION_NODE, node->category);
     }
 
+    TypeDescriptorPtr hoistedType = loadHoistedInvariant(node);
+    if(hoistedType != NULL) {
+        return hoistedType;
+    }
+
     TreeNodePtr unaryOperatorNode = node->subtrees[0];
     TreeNodePtr termNode = node->subtrees[1];
     TreeNodePtr additiveOperatorNode = node->subtrees[2];
@@ -1167,6 +1920,15 @@ TypeDescriptorPtr processTerm(TreeNodePtr node) {
         UnexpectedNodeCategoryError(TERM_NODE, node->category);
     }
 
+    if(boundConstants > 0 && processFoldedConstant(node)) {
+        return getSymbolTable()->integerTypeDescriptor;
+    }
+
+    TypeDescriptorPtr hoistedType = loadHoistedInvariant(node);
+    if(hoistedType != NULL) {
+        return hoistedType;
+    }
+
     TreeNodePtr factorNode = node->subtrees[0];
     TreeNodePtr multiplicativeOperatorNode = node->subtrees[1];
     TreeNodePtr termNode = node->subtrees[2];
@@ -1192,6 +1954,11 @@ TypeDescriptorPtr processFactor(TreeNodePtr node) {
         UnexpectedNodeCategoryError(FACTOR_NODE, node->category);
     }
 
+    TypeDescriptorPtr hoistedType = loadHoistedInvariant(node);
+    if(hoistedType != NULL) {
+        return hoistedType;
+    }
+
     TreeNodePtr specificFactorNode = node->subtrees[0];
     switch (specificFactorNode->category) {
         case VALUE_NODE: {
@@ -1211,6 +1978,12 @@ TypeDescriptorPtr processFactor(TreeNodePtr node) {
 }
 
 TypeDescriptorPtr processValueFactor(TreeNodePtr node) {
+    CommonSubexpressionPtr subexpression = findCommonSubexpression(commonSubexpressions, node, COMMON_VALUE);
+    if(subexpression != NULL) {
+        addCommand("LDVL %d,%d", getLocalsLevel(), subexpression->displacement);
+        return subexpression->type;
+    }
+
     Value value = processValue(node);
     switch (value.category) {
         case ARRAY_VALUE:
@@ -1222,7 +1995,7 @@ TypeDescriptorPtr processValueFactor(TreeNodePtr node) {
             }
             break;
         case REFERENCE:
-            addCommand("LVLI %d, %d", value.level, value.content.displacement);
+            addCommand("LVLI %d,%d", value.level, value.content.displacement);
             break;
         case VALUE:
             addCommand("LDVL %d,%d", value.level, value.content.displacement);
@@ -1403,6 +2176,1236 @@ TreeNodePtr getValueExpression(TreeNodePtr node) {
     return valueNode;
 }
 
+/**
+ * Loop invariants
+ **/
+
+/* Evaluates the invariant before the loop and keeps it in a temporary until the loop is compiled */
+void evaluateLoopInvariant(LoopInvariantPtr invariant) {
+    switch (invariant->category) {
+        case INVARIANT_VALUE:
+            switch (invariant->node->category) {
+                case EXPRESSION_NODE:
+                    invariant->type = processExpression(invariant->node);
+                    break;
+                case BINARY_OPERATOR_EXPRESSION_NODE:
+                    invariant->type = processBinaryOpExpression(invariant->node);
+                    break;
+                case UNARY_OPERATOR_EXPRESSION_NODE:
+                    invariant->type = processUnopExpression(invariant->node);
+                    break;
+                case TERM_NODE:
+                    invariant->type = processTerm(invariant->node);
+                    break;
+                default:
+                    invariant->type = processFactor(invariant->node);
+            }
+            break;
+        case INVARIANT_ARRAY_PREFIX:
+        case INDUCTION_ARRAY_ADDRESS:
+            invariant->type = processArrayPrefix(invariant->node, invariant->subscripts);
+            break;
+    }
+
+    invariant->displacement = allocateTemporary(findCurrentFunctionDescriptor(), 1);
+    addCommand("STVL %d,%d", getLocalsLevel(), invariant->displacement);
+
+    hoistInvariant(invariant);
+}
+
+/* Leaves the address selected by the leading subscripts of an array value on top of the stack */
+TypeDescriptorPtr processArrayPrefix(TreeNodePtr valueNode, int subscripts) {
+    char* identifier = processIdentifier(valueNode->subtrees[0]);
+    SymbolTableEntryPtr entry = findIdentifier(identifier);
+    if(entry == NULL) {
+        throwSemanticError("Unknown identifier");
+    }
+
+    Value value = valueFromEntry(entry);
+    TreeNodePtr arrayIndexNode = valueNode->subtrees[1];
+    value = processArraySubscripts(arrayIndexNode, skipSubscripts(arrayIndexNode, subscripts), value);
+
+    return value.type;
+}
+
+/* Loads the temporary of a hoisted invariant value, returns NULL if the node isn't one */
+TypeDescriptorPtr loadHoistedInvariant(TreeNodePtr node) {
+    LoopInvariantPtr invariant = findHoistedInvariant(hoistedInvariants, node);
+    if(invariant == NULL) {
+        return NULL;
+    }
+
+    addCommand("LDVL %d,%d", getLocalsLevel(), invariant->displacement);
+    return invariant->type;
+}
+
+/* Makes the loads of the invariant's node use its temporary until the current loop ends */
+void hoistInvariant(LoopInvariantPtr invariant) {
+    push(hoistedOrder, invariant);
+    mapPut(hoistedInvariants, invariant->node, invariant);
+}
+
+/**
+ * Induction variables
+ **/
+
+/*
+ * Evaluates the address before the loop, its uses then load it from the temporary, like the hoisted array prefixes
+ */
+void evaluateInductionAddress(InductionAddressPtr address) {
+    TypeDescriptorPtr type = processArrayPrefix(address->firstUse, address->subscripts);
+
+    address->displacement = allocateTemporary(findCurrentFunctionDescriptor(), 1);
+    addCommand("STVL %d,%d", getLocalsLevel(), address->displacement);
+
+    for (LinkedNode* current = address->uses->top; current != NULL; current = current->next) {
+        LoopInvariantPtr use = malloc(sizeof(LoopInvariant));
+        use->category = INDUCTION_ARRAY_ADDRESS;
+        use->node = (TreeNodePtr) current->data;
+        use->subscripts = address->subscripts;
+        use->displacement = address->displacement;
+        use->type = type;
+        hoistInvariant(use);
+    }
+}
+
+/* Moves the addresses of the induction variable by the same number of elements the variable was just moved */
+void updateInductionAddresses(InductionVariablePtr inductionVariable) {
+    for (LinkedNode* current = inductionVariable->addresses->top; current != NULL; current = current->next) {
+        InductionAddressPtr address = (InductionAddressPtr) current->data;
+        addCommand("LDVL %d,%d", getLocalsLevel(), address->displacement);
+        addCommand("LDCT %d", address->delta);
+        addCommand("INDX 1");
+        addCommand("STVL %d,%d", getLocalsLevel(), address->displacement);
+    }
+}
+
+/**
+ * Loop idioms
+ **/
+
+/* Compiles the loop as a single operation if it is one, returns false if it isn't */
+bool processLoopIdiom(TreeNodePtr node, TreeNodePtr initNode) {
+    CountedLoopPtr countedLoop = findCountedLoop(node, initNode, hoistedInvariants);
+    if(countedLoop == NULL) {
+        return false;
+    }
+
+    int words;
+    TreeNodePtr targetNode = node->subtrees[1]->subtrees[0]->subtrees[0];
+    // the temporaries of the induction variables of enclosing loops are bumped by the counter's update
+    bool blockCopy = isBlockCopy(node, countedLoop, hoistedInvariants, &words) &&
+                     findInductionUpdate(activeInductionVariables, countedLoop->updateNode) == NULL &&
+                     !(compilerOptions.optimizations[DEAD_STORE_ELIMINATION] &&
+                       isUnusedVariable(findIdentifier(targetNode->subtrees[0]->name)));
+    if(blockCopy) {
+        processBlockCopy(node, countedLoop, words);
+    }
+    free(countedLoop);
+    return blockCopy;
+}
+
+/*
+ * The loop was entered right after the counter got its initial value, so the addresses of the first elements are
+ * computed by the value nodes of the assignment. The elements are all loaded before any of them is stored, which
+ * copies the same values as the loop since the arrays don't overlap. The counter is then given its final value
+ */
+void processBlockCopy(TreeNodePtr node, CountedLoopPtr countedLoop, int words) {
+    TreeNodePtr conditionNode = node->subtrees[0];
+    TreeNodePtr compoundNode = node->subtrees[1];
+    TreeNodePtr assignmentNode = compoundNode->subtrees[0];
+
+    // the loop is only compiled for its semantic errors
+    int firstCommand = nextCommandIndex();
+    processLoopCondition(conditionNode);
+    processCompound(compoundNode);
+    removeCommands(firstCommand, nextCommandIndex());
+
+    loadValueAddress(processValue(assignmentNode->subtrees[0]));
+    loadValueAddress(processValue(getSingleValueNode(assignmentNode->subtrees[1])));
+    addCommand("LDMV %d  \tblock copy", words);
+    addCommand("STMV %d", words);
+
+    Value counter = processValue(countedLoop->updateNode->subtrees[0]);
+    addCommand("LDCT %d", countedLoop->initialValue + countedLoop->tripCount * countedLoop->step);
+    addCommand("STVL %d,%d", counter.level, counter.content.displacement);
+}
+
+/* Leaves the address of the variable or array element on top of the stack */
+void loadValueAddress(Value value) {
+    switch (value.category) {
+        case ARRAY_VALUE:
+        case ARRAY_REFERENCE:
+            // process value already left the address on top of the stack
+            break;
+        case REFERENCE:
+            addCommand("LDVL %d,%d", value.level, value.content.displacement);
+            break;
+        case VALUE:
+            addCommand("LADR %d,%d", value.level, value.content.displacement);
+            break;
+        case CONSTANT:
+            break;
+    }
+}
+
+/**
+ * Loop unrolling
+ **/
+
+/*
+ * A fully unrolled loop is replaced by copies of its body. Otherwise, the unrolled loop runs the copies while the
+ * condition holds for the counter moved by all of them but the last, and the remainder loop runs the last iterations
+ * one at a time, or as copies of the body when the trip count is known:
+ *      L1: NOOP          (unrolled while)
+ *          i + (copies-1)*step < E
+ *          JMPF L2
+ *          body copies
+ *          JUMP L1
+ *      L2: NOOP          (while remainder)
+ *          i < E
+ *          JMPF exit
+ *          body
+ *          JUMP L2
+ * The counter is only updated by the last statement of the body, so each copy sees it as the regular loop would
+ */
+void processUnrolledRepetitive(TreeNodePtr node, CountedLoopPtr countedLoop, int exitLabel) {
+    TreeNodePtr conditionNode = node->subtrees[0];
+    TreeNodePtr compoundNode = node->subtrees[1];
+
+    if(countedLoop->fullyUnrolled) {
+        checkLoopCondition(conditionNode);
+        for (int copy = 0; copy < countedLoop->copies; copy++) {
+            processCompound(compoundNode);
+        }
+        return;
+    }
+
+    int unrolledLabel = nextMEPALabel();
+    int remainderLabel = nextMEPALabel();
+
+    addCommand("L%d: NOOP  \tunrolled while", unrolledLabel);
+    processShiftedLoopCondition(conditionNode, (countedLoop->copies - 1) * countedLoop->step);
+    addCommand("JMPF L%d", remainderLabel);
+    for (int copy = 0; copy < countedLoop->copies; copy++) {
+        processCompound(compoundNode);
+    }
+    addCommand("JUMP L%d", unrolledLabel);
+
+    addCommand("L%d: NOOP  \twhile remainder", remainderLabel);
+    if(countedLoop->constantTripCount) {
+        checkLoopCondition(conditionNode);
+        for (int copy = 0; copy < countedLoop->tripCount % countedLoop->copies; copy++) {
+            processCompound(compoundNode);
+        }
+    } else {
+        processLoopCondition(conditionNode);
+        addCommand("JMPF L%d", exitLabel);
+        processCompound(compoundNode);
+        addCommand("JUMP L%d", remainderLabel);
+    }
+}
+
+/* Evaluates the condition "i < E" of a counted loop as "i + offset < E" */
+void processShiftedLoopCondition(TreeNodePtr conditionNode, int offset) {
+    routeExpressionSubtree(conditionNode->subtrees[0]);
+    addCommand("LDCT %d", offset);
+    addCommand("ADDD");
+    processBinaryOpExpression(conditionNode->subtrees[2]);
+    processRelationalOperator(conditionNode->subtrees[1]);
+}
+
+/* Compiles a condition the unrolled loop doesn't need to test, only to report its semantic errors */
+void checkLoopCondition(TreeNodePtr conditionNode) {
+    int firstCommand = nextCommandIndex();
+    processLoopCondition(conditionNode);
+    removeCommands(firstCommand, nextCommandIndex());
+}
+
+/**
+ * Common subexpressions
+ **/
+
+/*
+ * Starts the straight-line run of the statement if none is being compiled, then evaluates the subexpressions first
+ * used by the statement: its label, if any, was already compiled, so a goto to it still evaluates them
+ */
+void beginStraightLineStatement(TreeNodePtr statementNode) {
+    if(!compilerOptions.optimizations[COMMON_SUBEXPRESSION_ELIMINATION]) {
+        return;
+    }
+
+    if(currentRun == NULL) {
+        currentRun = findStraightLineRun(statementNode, hoistedInvariants);
+        if(currentRun == NULL) {
+            return;
+        }
+        runFirstTemporary = findCurrentFunctionDescriptor()->temporariesDisplacement;
+    }
+
+    // the values of the statement may be loaded from the addresses it keeps
+    for (LinkedNode* current = currentRun->subexpressions->top; current != NULL; current = current->next) {
+        CommonSubexpressionPtr subexpression = (CommonSubexpressionPtr) current->data;
+        if(subexpression->firstStatement == statementNode && subexpression->category == COMMON_ADDRESS) {
+            evaluateCommonSubexpression(subexpression);
+        }
+    }
+    for (LinkedNode* current = currentRun->subexpressions->top; current != NULL; current = current->next) {
+        CommonSubexpressionPtr subexpression = (CommonSubexpressionPtr) current->data;
+        if(subexpression->firstStatement == statementNode && subexpression->category == COMMON_VALUE) {
+            evaluateCommonSubexpression(subexpression);
+        }
+    }
+}
+
+/* Releases the temporaries of the run once its last statement was compiled */
+void endStraightLineStatement(TreeNodePtr statementNode) {
+    if(currentRun == NULL || currentRun->lastStatement != statementNode) {
+        return;
+    }
+
+    while (pop(commonSubexpressions) != NULL);
+    releaseTemporaries(findCurrentFunctionDescriptor(), runFirstTemporary);
+    freeStraightLineRun(currentRun);
+    currentRun = NULL;
+}
+
+/*
+ * Nothing the subexpression depends on is assigned before the statement using it first ends, so it is evaluated right
+ * before the statement
+ */
+void evaluateCommonSubexpression(CommonSubexpressionPtr subexpression) {
+    Value value = processValue(subexpression->firstUse);
+    if(subexpression->category == COMMON_VALUE) {
+        addCommand("CONT");
+    }
+    subexpression->type = value.type;
+
+    subexpression->displacement = allocateTemporary(findCurrentFunctionDescriptor(), 1);
+    addCommand("STVL %d,%d", getLocalsLevel(), subexpression->displacement);
+    push(commonSubexpressions, subexpression);
+}
+
+/**
+ * Pure calls
+ **/
+
+/*
+ * Compiles a call to a pure function whose arguments are all constant as the value it returns, returns false, emitting
+ * nothing, if the call can't be evaluated. The value takes the place of the result the call would leave on the stack
+ */
+bool processEvaluatedCall(TreeNodePtr node, SymbolTableEntryPtr functionEntry) {
+    int result;
+    if(!evaluateConstantCall(node, functionEntry, &result)) {
+        return false;
+    }
+    addCommand("LDCT %d", result);
+    return true;
+}
+
+/*
+ * Evaluates a call whose arguments are constant expressions (see evaluateConstantExpression) or calls to pure functions
+ * evaluated the same way (ex: "pow2(fact(3))"). Only integer arguments are accepted, the pure functions' parameters
+ * are integers, so the arguments the call skips compiling would not raise a semantic error
+ */
+bool evaluateConstantCall(TreeNodePtr node, SymbolTableEntryPtr functionEntry, int* result) {
+    PureFunctionPtr function = findPureFunction(functionEntry->description.functionDescriptor);
+    if(function == NULL) {
+        return false;
+    }
+
+    int* arguments = malloc((function->parametersCount + 1) * sizeof(int));
+    int count = 0;
+    bool evaluated = true;
+    for (TreeNodePtr argumentNode = node->subtrees[1]; argumentNode != NULL && evaluated;
+         argumentNode = argumentNode->next) {
+        TreeNodePtr callNode = getCallExpression(argumentNode);
+        if(count == function->parametersCount) {
+            evaluated = false;
+        } else if(callNode == NULL) {
+            evaluated = evaluateConstantExpression(argumentNode, &arguments[count]);
+        } else {
+            SymbolTableEntryPtr argumentEntry = findIdentifier(callNode->subtrees[0]->name);
+            evaluated = argumentEntry != NULL && argumentEntry->category == FUNCTION_SYMBOL &&
+                        evaluateConstantCall(callNode, argumentEntry, &arguments[count]);
+        }
+        count++;
+    }
+
+    evaluated = evaluated && count == function->parametersCount && evaluatePureCall(function, arguments, result);
+    free(arguments);
+    return evaluated;
+}
+
+/**
+ * Inlining
+ **/
+
+/*
+ * Compiles the body of the called function in place of the call. Its parameters and variables are kept in temporaries
+ * of the caller's activation record, returns leave the result in a temporary and jump to the end of the body, except
+ * a return ending the body which simply falls through: if it is the only one, its value is left on the stack.
+ * The function's body was already compiled where it was declared, so only the arguments are checked here
+ */
+TypeDescriptorPtr processInlinedCall(TreeNodePtr node, InlineCandidatePtr candidate) {
+    FunctionDescriptorPtr calleeDescriptor = candidate->functionEntry->description.functionDescriptor;
+    FunctionDescriptorPtr functionDescriptor = findCurrentFunctionDescriptor();
+    int firstTemporary = functionDescriptor->temporariesDisplacement;
+
+    int parametersCount = 0;
+    for (ParameterDescriptorsListPtr parameter = calleeDescriptor->parameters; parameter != NULL;
+         parameter = parameter->next) {
+        parametersCount++;
+    }
+    int* parameterDisplacements = malloc(parametersCount * sizeof(int));
+    processInlinedArguments(node->subtrees[1], calleeDescriptor->parameters, parameterDisplacements);
+
+    // the arguments are evaluated in the caller's scope, the body in the function's one
+    Stack* locals = newStack();
+    for (LinkedNode* current = candidate->scope->top; current != NULL; current = current->next) {
+        SymbolTableEntryPtr entry = (SymbolTableEntryPtr) current->data;
+        if(!isInlinedLocal(candidate, entry)) {
+            addInlinedSymbol(entry);
+            continue;
+        }
+
+        SymbolTableEntryPtr local;
+        if(entry->category == VARIABLE_SYMBOL) {
+            int displacement = allocateTemporary(functionDescriptor, entry->description.variableDescriptor->type->size);
+            local = newInlinedLocal(entry, displacement, VALUE_PARAMETER);
+        } else {
+            int index = 0;
+            ParameterDescriptorsListPtr parameter = calleeDescriptor->parameters;
+            while (parameter->descriptor != entry->description.parameterDescriptor) {
+                parameter = parameter->next;
+                index++;
+            }
+            local = newInlinedLocal(entry, parameterDisplacements[index], parameter->descriptor->parameterPassage);
+        }
+        addInlinedSymbol(local);
+        push(locals, local);
+    }
+    free(parameterDisplacements);
+
+    InlineExpansion expansion;
+    expansion.candidate = candidate;
+    expansion.resultDisplacement = -1;
+    expansion.exitLabel = -1;
+    bool finalReturnOnly = candidate->finalReturn != NULL && candidate->returns == 1;
+    if(calleeDescriptor->returnType != NULL && !finalReturnOnly) {
+        expansion.resultDisplacement = allocateTemporary(functionDescriptor, 1);
+    }
+    if(candidate->returns > (candidate->finalReturn != NULL ? 1 : 0)) {
+        expansion.exitLabel = nextMEPALabel();
+    }
+
+    push(inlineExpansions, &expansion);
+    processBody(candidate->bodyNode);
+    pop(inlineExpansions);
+
+    if(expansion.exitLabel >= 0) {
+        addCommand("L%d: NOOP  \tend %s", expansion.exitLabel, candidate->functionEntry->identifier);
+    }
+    if(expansion.resultDisplacement >= 0) {
+        addCommand("LDVL %d,%d", getLocalsLevel(), expansion.resultDisplacement);
+    }
+
+    removeInlinedSymbols(candidate->scope->size);
+    while (locals->size > 0) {
+        freeInlinedLocal(pop(locals));
+    }
+    free(locals);
+    releaseTemporaries(functionDescriptor, firstTemporary);
+
+    return calleeDescriptor->returnType;
+}
+
+/* Stores each argument in a temporary taking the place of its parameter, like processArgumentsList pushes them */
+void processInlinedArguments(TreeNodePtr node, ParameterDescriptorsListPtr parameters, int* displacements) {
+    FunctionDescriptorPtr functionDescriptor = findCurrentFunctionDescriptor();
+
+    TreeNodePtr currentNode = node;
+    ParameterDescriptorsListPtr currentParameter = parameters;
+    int index = 0;
+    while (currentParameter != NULL && currentNode != NULL) {
+        ParameterDescriptorPtr descriptor = currentParameter->descriptor;
+        if(descriptor->parameterPassage == VALUE_PARAMETER) {
+            int size = descriptor->type->size;
+            displacements[index] = allocateTemporary(functionDescriptor, size);
+            if(size > 1) {
+                addCommand("LADR %d,%d", getLocalsLevel(), displacements[index]);
+                processArgumentByValue(descriptor, currentNode);
+                addCommand("STMV %d", size);
+            } else {
+                processArgumentByValue(descriptor, currentNode);
+                addCommand("STVL %d,%d", getLocalsLevel(), displacements[index]);
+            }
+        } else {
+            // the inlined functions have no function parameters
+            displacements[index] = allocateTemporary(functionDescriptor, 1);
+            processArgumentByReference(descriptor, currentNode);
+            addCommand("STVL %d,%d", getLocalsLevel(), displacements[index]);
+        }
+
+        currentParameter = currentParameter->next;
+        currentNode = currentNode->next;
+        index++;
+    }
+
+    if(currentParameter != NULL) {
+        throwSemanticError("Missing parameters for function call");
+    }
+
+    if(currentNode != NULL) {
+        throwSemanticError("Too many parameters for function call");
+    }
+}
+
+/*
+ * A copy of a parameter or variable of the inlined function kept in a temporary of the current activation record:
+ * a variable for the variables and parameters by value, a parameter by reference keeping the address for the other ones
+ */
+SymbolTableEntryPtr newInlinedLocal(SymbolTableEntryPtr entry, int displacement, ParameterPassage passage) {
+    SymbolTableEntryPtr local = malloc(sizeof(SymbolTableEntry));
+    local->identifier = entry->identifier;
+    local->level = getFunctionLevel();
+
+    TypeDescriptorPtr type = entry->category == VARIABLE_SYMBOL ?
+                             entry->description.variableDescriptor->type :
+                             entry->description.parameterDescriptor->type;
+    if(passage == VALUE_PARAMETER) {
+        local->category = VARIABLE_SYMBOL;
+        local->description.variableDescriptor = malloc(sizeof(VariableDescriptor));
+        local->description.variableDescriptor->displacement = displacement;
+        local->description.variableDescriptor->type = type;
+        local->description.variableDescriptor->level = getLocalsLevel();
+    } else {
+        // the address is kept by a temporary too, parameters are loaded from the entry's level
+        local->level = getLocalsLevel();
+        local->category = PARAMETER_SYMBOL;
+        local->description.parameterDescriptor = malloc(sizeof(ParameterDescriptor));
+        local->description.parameterDescriptor->displacement = displacement;
+        local->description.parameterDescriptor->type = type;
+        local->description.parameterDescriptor->parameterPassage = passage;
+        local->description.parameterDescriptor->byAddress = false;
+        local->description.parameterDescriptor->readOnly = false;
+        local->description.parameterDescriptor->boundFunction = NULL;
+    }
+    return local;
+}
+
+void freeInlinedLocal(SymbolTableEntryPtr entry) {
+    if(entry->category == VARIABLE_SYMBOL) {
+        free(entry->description.variableDescriptor);
+    } else {
+        free(entry->description.parameterDescriptor);
+    }
+    free(entry);
+}
+
+void processInlinedReturn(TreeNodePtr node, InlineExpansionPtr expansion) {
+    TreeNodePtr expressionNode = node->subtrees[0];
+    if(expressionNode != NULL) {
+        processExpression(expressionNode);
+        if(expansion->resultDisplacement >= 0) {
+            addCommand("STVL %d,%d", getLocalsLevel(), expansion->resultDisplacement);
+        }
+    }
+
+    if(node != expansion->candidate->finalReturn) {
+        addCommand("JUMP L%d", expansion->exitLabel);
+    }
+}
+
+/**
+ * Unreachable code
+ **/
+
+/* Records a call or a function passed as argument for the call graph, unless the command is discarded */
+void referenceFunction(FunctionDescriptorPtr functionDescriptor) {
+    if(compilerOptions.optimizations[UNREACHABLE_CODE_ELIMINATION] && !unreachableStatements) {
+        addFunctionReference(functionDescriptor);
+    }
+}
+
+/*
+ * Checks if a statement never continues to the next one: a goto, a return, a conditional whose branches both jump or
+ * a compound statement with a jump (the statements following it are unreachable)
+ */
+bool isJump(TreeNodePtr unlabeledStatementNode) {
+    if(unlabeledStatementNode == NULL) {
+        return false;
+    }
+
+    switch (unlabeledStatementNode->category) {
+        case GOTO_NODE:
+        case RETURN_NODE:
+            return true;
+        case IF_NODE:
+            return unlabeledStatementNode->subtrees[2] != NULL &&
+                   isJump(unlabeledStatementNode->subtrees[1]) && isJump(unlabeledStatementNode->subtrees[2]);
+        case COMPOUND_NODE:
+            for (TreeNodePtr current = unlabeledStatementNode->subtrees[0]; current != NULL; current = current->next) {
+                if(isJump(current)) {
+                    return true;
+                }
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+bool isLabeledStatement(TreeNodePtr statementNode) {
+    return statementNode->subtrees[0]->category == LABEL_NODE;
+}
+
+TreeNodePtr getUnlabeledStatement(TreeNodePtr statementNode) {
+    return isLabeledStatement(statementNode) ? statementNode->subtrees[1] : statementNode->subtrees[0];
+}
+
+/**
+ * Tail calls
+ **/
+
+typedef struct {
+    char* identifier;
+    bool found;
+} TailCallSearch;
+
+static const bool returnsFilter[NODE_CATEGORIES_COUNT] = {
+    [RETURN_NODE] = true
+};
+
+/*
+ * Checks if the function's body returns a call by its name, whether the name is the function's own one is only known
+ * when the call is compiled (a nested function may have the same name)
+ */
+bool hasSelfTailCall(TreeNodePtr functionNode, char* identifier) {
+    TailCallSearch search = {
+        .identifier = identifier,
+        .found = false
+    };
+    TreeVisitor visitor = {
+        .preVisit = findSelfTailCall,
+        .postVisit = NULL,
+        .categoryFilter = returnsFilter,
+        .context = &search
+    };
+    // the body only, the nested functions have their own returns
+    visitSubtree(functionNode->subtrees[1]->subtrees[4], &visitor);
+    return search.found;
+}
+
+bool findSelfTailCall(TreeNodePtr node, void* context) {
+    TailCallSearch* search = (TailCallSearch*) context;
+    TreeNodePtr callNode = node->subtrees[0] == NULL ? NULL : getCallExpression(node->subtrees[0]);
+    if(callNode != NULL && strcmp(callNode->subtrees[0]->name, search->identifier) == 0) {
+        search->found = true;
+    }
+    return false;
+}
+
+/* The function call an expression is made of (ex: "f(n-1, n*acc)"), NULL for other expressions */
+TreeNodePtr getCallExpression(TreeNodePtr expressionNode) {
+    TreeNodePtr node = expressionNode;
+    while (node->category == EXPRESSION_NODE || node->category == BINARY_OPERATOR_EXPRESSION_NODE ||
+           node->category == TERM_NODE) {
+        if(node->subtrees[1] != NULL) {
+            return NULL;
+        }
+        node = node->subtrees[0];
+        if(node->category == FACTOR_NODE) {
+            node = node->subtrees[0];
+        }
+    }
+    return node->category == FUNCTION_CALL_NODE ? node : NULL;
+}
+
+/*
+ * Compiles "return f(...)" in f itself as a jump to its body, reusing the activation record: the arguments are pushed
+ * as for a call, then popped into the parameters, so they are all evaluated before any parameter changes.
+ * Returns false, emitting nothing, if the expression isn't a call to the function, an argument is an array by value,
+ * which would take a store per element instead of a single copy, or an argument depends on the activation record
+ * being reused (see referencesActivationRecord)
+ */
+bool processSelfTailCall(TreeNodePtr expressionNode, FunctionDescriptorPtr functionDescriptor) {
+    TreeNodePtr callNode = getCallExpression(expressionNode);
+    if(callNode == NULL) {
+        return false;
+    }
+
+    SymbolTableEntryPtr functionEntry = findIdentifier(processIdentifier(callNode->subtrees[0]));
+    if(functionEntry == NULL || functionEntry->category != FUNCTION_SYMBOL) {
+        return false;
+    }
+    // a version calls itself when the call passes its own functions and constants
+    FunctionVersionPtr version = findCalledVersion(callNode, functionEntry);
+    FunctionDescriptorPtr calledDescriptor = version != NULL ? version->descriptor :
+                                             functionEntry->description.functionDescriptor;
+    if(calledDescriptor != functionDescriptor) {
+        return false;
+    }
+    for (ParameterDescriptorsListPtr parameter = functionDescriptor->parameters; parameter != NULL;
+         parameter = parameter->next) {
+        ParameterDescriptorPtr descriptor = parameter->descriptor;
+        if(descriptor->parameterPassage == VALUE_PARAMETER && descriptor->type->size > 1) {
+            return false;
+        }
+    }
+
+    ParameterDescriptorsListPtr parameters = functionEntry->description.functionDescriptor->parameters;
+    if(referencesActivationRecord(callNode->subtrees[1], parameters)) {
+        return false;
+    }
+
+    processArgumentsList(callNode->subtrees[1], parameters, version);
+
+    // the parameters are stored from the last word of the last parameter, the function parameters take three words
+    for (int offset = functionDescriptor->parametersSize - 1; offset >= 0; offset--) {
+        addCommand("STVL %d,%d", getFunctionLevel(), functionDescriptor->parameters->descriptor->displacement + offset);
+    }
+    addCommand("JUMP L%d  \ttail call", functionDescriptor->bodyMepaLabel);
+    return true;
+}
+
+/*
+ * Checks if an argument by reference is a variable or a parameter by value of the current function, or one of their
+ * elements, or if a function argument is nested in the current function: the jump reuses the activation record, so the
+ * address, or the static link of the nested function, would point to the new values of the locals
+ */
+bool referencesActivationRecord(TreeNodePtr argumentsNode, ParameterDescriptorsListPtr parameters) {
+    ParameterDescriptorsListPtr parameter = parameters;
+    for (TreeNodePtr argumentNode = argumentsNode; argumentNode != NULL && parameter != NULL;
+         argumentNode = argumentNode->next, parameter = parameter->next) {
+        ParameterPassage passage = parameter->descriptor->parameterPassage;
+        if(passage != VARIABLE_PARAMETER && passage != FUNCTION_PARAMETER) {
+            continue;
+        }
+        SymbolTableEntryPtr entry = findNodeIdentifier(getSingleValueNode(argumentNode));
+        if(entry == NULL) {
+            continue;
+        }
+        if(passage == VARIABLE_PARAMETER ? isLocalEntry(entry) :
+           entry->category == FUNCTION_SYMBOL && entry->level > getFunctionLevel()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Copy elision
+ **/
+
+/*
+ * Marks the arrays by value the function never writes to be passed by address. A function passed as an argument keeps
+ * the copies, the calls through a function parameter only know the declared parameters
+ */
+void findReadOnlyParameters(TreeNodePtr functionNode, FunctionHeaderPtr functionHeader, TreeNodePtr enclosingBlockNode) {
+    if(isPassedAsArgument(enclosingBlockNode, functionHeader->name)) {
+        return;
+    }
+
+    for (ParameterPtr parameter = functionHeader->parameters; parameter != NULL; parameter = parameter->next) {
+        parameter->byAddress = parameter->passage == VALUE_PARAMETER && parameter->type->category == ARRAY_TYPE &&
+                               parameter->type->size > 1 &&
+                               isReadOnlyParameter(functionNode, functionHeader, parameter->name);
+    }
+}
+
+/*
+ * Checks if nothing can write the array selected by an argument while the call runs: a parameter received by address
+ * (the caller of its function already checked it), or a variable of the current function that its nested functions
+ * never write and no other argument passes by reference. The callee only sees the variable through those nested
+ * functions, itself or the functions passed as arguments
+ */
+bool isUnchangedByCall(TreeNodePtr valueNode, TreeNodePtr argumentsNode, ParameterDescriptorsListPtr parameters) {
+    char* identifier = valueNode->subtrees[0]->name;
+    SymbolTableEntryPtr entry = findIdentifier(identifier);
+    if(entry == NULL) {
+        return false;
+    }
+    if(entry->category == PARAMETER_SYMBOL) {
+        return entry->description.parameterDescriptor->byAddress;
+    }
+    // the variables of an inlined body are copies in the temporaries of the current function
+    if(entry->category != VARIABLE_SYMBOL || entry->level != getFunctionLevel() || inlineExpansions->size > 0 ||
+       isWrittenByNestedFunctions(currentBlockNode, identifier)) {
+        return false;
+    }
+
+    TreeNodePtr argumentNode = argumentsNode;
+    for (ParameterDescriptorsListPtr parameter = parameters; parameter != NULL && argumentNode != NULL;
+         parameter = parameter->next) {
+        TreeNodePtr argumentValueNode = getSingleValueNode(argumentNode);
+        if(parameter->descriptor->parameterPassage == VARIABLE_PARAMETER && argumentValueNode != NULL &&
+           strcmp(argumentValueNode->subtrees[0]->name, identifier) == 0) {
+            return false;
+        }
+        argumentNode = argumentNode->next;
+    }
+    return true;
+}
+
+/* Checks if the returned expression is the variable kept in the result's position, see processVariableDeclaration */
+bool isResultVariable(TreeNodePtr expressionNode, FunctionDescriptorPtr functionDescriptor) {
+    TreeNodePtr valueNode = getSingleValueNode(expressionNode);
+    if(valueNode == NULL || valueNode->subtrees[1] != NULL) {
+        return false;
+    }
+
+    SymbolTableEntryPtr entry = findIdentifier(valueNode->subtrees[0]->name);
+    return entry != NULL && entry->category == VARIABLE_SYMBOL && entry->level == getFunctionLevel() &&
+           entry->description.variableDescriptor->displacement == functionDescriptor->returnDisplacement;
+}
+
+/**
+ * Function specialization
+ **/
+
+/* Compiles the versions of the block's functions its body calls, once all the functions were compiled */
+Stack* processFunctionVersions(TreeNodePtr blockNode) {
+    Stack* versions = findFunctionVersions(blockNode);
+    for (LinkedNode* node = versions->top; node != NULL; node = node->next) {
+        processFunctionVersion(node->data, blockNode);
+    }
+    return versions;
+}
+
+/*
+ * Marks the integer parameters by value the function never writes, its versions may bind them to the constants passed
+ * by their calls (see findFunctionVersions)
+ */
+void findConstantParameters(TreeNodePtr functionNode, FunctionHeaderPtr functionHeader) {
+    for (ParameterPtr parameter = functionHeader->parameters; parameter != NULL; parameter = parameter->next) {
+        parameter->readOnly = parameter->passage == VALUE_PARAMETER &&
+                              equivalentTypes(parameter->type, getSymbolTable()->integerTypeDescriptor) &&
+                              isReadOnlyParameter(functionNode, functionHeader, parameter->name);
+    }
+}
+
+/*
+ * Compiles a version like its function, with only the parameters it doesn't bind: the function parameters are added
+ * bound to the version's functions, so their calls go straight to them, and the bound integer parameters are added as
+ * constants, so the expressions and conditions using them are folded
+ */
+void processFunctionVersion(FunctionVersionPtr version, TreeNodePtr enclosingBlockNode) {
+    TreeNodePtr node = version->functionNode;
+    FunctionHeaderPtr functionHeader = processFunctionHeader(node->subtrees[0]);
+    if(compilerOptions.optimizations[COPY_ELISION]) {
+        findReadOnlyParameters(node, functionHeader, enclosingBlockNode);
+    }
+
+    ParameterPtr functionParameters = NULL;
+    ParameterPtr lastFunctionParameter = NULL;
+    ParameterPtr constantParameters = NULL;
+    ParameterPtr lastConstantParameter = NULL;
+    ParameterPtr* link = &functionHeader->parameters;
+    int position = 0;
+    while (*link != NULL) {
+        ParameterPtr parameter = *link;
+        bool boundFunction = parameter->passage == FUNCTION_PARAMETER;
+        if(!boundFunction && !bindsConstant(version, position)) {
+            link = &parameter->next;
+            position++;
+            continue;
+        }
+
+        *link = parameter->next;
+        parameter->next = NULL;
+        ParameterPtr* last = boundFunction ? &lastFunctionParameter : &lastConstantParameter;
+        if(*last == NULL) {
+            if(boundFunction) {
+                functionParameters = parameter;
+            } else {
+                constantParameters = parameter;
+            }
+        } else {
+            (*last)->next = parameter;
+        }
+        *last = parameter;
+        position++;
+    }
+    functionHeader->name = newVersionName(functionHeader->name, version, constantParameters);
+
+    SymbolTableEntryPtr entry = addFunction(functionHeader);
+    freeFunctionHeader(functionHeader);
+    // set before the body is compiled, so the recursive calls passing the same functions call the version itself
+    version->descriptor = entry->description.functionDescriptor;
+
+    int target = 0;
+    while (functionParameters != NULL) {
+        ParameterPtr parameter = functionParameters;
+        addBoundFunctionParameter(parameter->name, parameter->type, version->targets[target]);
+        target++;
+        functionParameters = parameter->next;
+        free(parameter);
+    }
+    int constant = 0;
+    while (constantParameters != NULL) {
+        ParameterPtr parameter = constantParameters;
+        addBoundValueParameter(parameter->name, parameter->type, version->constants[constant]);
+        constant++;
+        constantParameters = parameter->next;
+        free(parameter);
+    }
+
+    FunctionVersionPtr enclosingVersion = compiledVersion;
+    compiledVersion = version;
+    boundConstants += version->constantsCount;
+    version->firstCommand = nextCommandIndex();
+    processFunctionDeclaration(node, entry);
+    version->lastCommand = nextCommandIndex();
+    boundConstants -= version->constantsCount;
+    compiledVersion = enclosingVersion;
+    endFunctionLevel();
+}
+
+/*
+ * The name of a version, only shown by the generated code: the function's name, its functions and its constants (ex:
+ * "f[h,g]" or "f[h,n=3]")
+ */
+char* newVersionName(char* identifier, FunctionVersionPtr version, ParameterPtr constantParameters) {
+    char value[16];
+    size_t length = strlen(identifier) + 2;
+    for (int i = 0; i < version->targetsCount; i++) {
+        length += strlen(version->targets[i]->identifier) + 1;
+    }
+    int constant = 0;
+    for (ParameterPtr parameter = constantParameters; parameter != NULL; parameter = parameter->next) {
+        length += strlen(parameter->name) + sprintf(value, "=%d", version->constants[constant++]) + 1;
+    }
+
+    char* name = malloc(length);
+    strcpy(name, identifier);
+    bool first = true;
+    for (int i = 0; i < version->targetsCount; i++) {
+        strcat(name, first ? "[" : ",");
+        strcat(name, version->targets[i]->identifier);
+        first = false;
+    }
+    constant = 0;
+    for (ParameterPtr parameter = constantParameters; parameter != NULL; parameter = parameter->next) {
+        strcat(name, first ? "[" : ",");
+        strcat(name, parameter->name);
+        sprintf(value, "=%d", version->constants[constant++]);
+        strcat(name, value);
+        first = false;
+    }
+    strcat(name, "]");
+    return name;
+}
+
+/* The version a call runs, matching the functions and constants it passes, NULL if it runs the function itself */
+FunctionVersionPtr findCalledVersion(TreeNodePtr callNode, SymbolTableEntryPtr functionEntry) {
+    if(compilerOptions.optimizations[FUNCTION_SPECIALIZATION]) {
+        return findCallVersion(callNode, functionEntry);
+    }
+    return NULL;
+}
+
+/*
+ * Loads an expression, binary operator expression or term the bound constants make constant (see boundConstants),
+ * returns false, emitting nothing, for the other ones
+ */
+bool processFoldedConstant(TreeNodePtr node) {
+    long long value;
+    bool constant;
+    switch (node->category) {
+        case EXPRESSION_NODE: {
+            int expressionValue;
+            constant = evaluateConstantExpression(node, &expressionValue);
+            value = expressionValue;
+            break;
+        }
+        case BINARY_OPERATOR_EXPRESSION_NODE:
+            constant = evaluateBinaryOpExpression(node, &value);
+            break;
+        case TERM_NODE:
+            constant = evaluateTerm(node, &value);
+            break;
+        default:
+            return false;
+    }
+
+    if(!constant) {
+        return false;
+    }
+    addCommand("LDCT %d", (int) value);
+    return true;
+}
+
+/*
+ * Compiles a conditional whose condition the bound constants decide: only the branch taken is kept, the other one is
+ * compiled to report its semantic errors and discarded like unreachable statements
+ */
+void processConstantConditional(TreeNodePtr node, bool condition) {
+    TreeNodePtr takenCompound = condition ? node->subtrees[1] : node->subtrees[2];
+    TreeNodePtr discardedCompound = condition ? node->subtrees[2] : node->subtrees[1];
+
+    if(takenCompound != NULL) {
+        processCompound(takenCompound);
+    }
+    if(discardedCompound != NULL) {
+        int firstCommand = nextCommandIndex();
+        bool unreachable = unreachableStatements;
+        unreachableStatements = true;
+        processCompound(discardedCompound);
+        unreachableStatements = unreachable;
+        removeCommands(firstCommand, nextCommandIndex());
+    }
+}
+
+/**
+ * Static activation records
+ **/
+
+/*
+ * Starts the local area of a function never active twice after the static areas placed so far, its variables and
+ * temporaries are addressed at the main function's level from then on
+ */
+void placeStaticLocals(FunctionDescriptorPtr functionDescriptor) {
+    FunctionDescriptorPtr mainFunctionDescriptor = getSymbolTable()->mainFunctionDescriptor;
+    int displacement = staticLocalsEnd > mainFunctionDescriptor->variablesDisplacement ?
+                       staticLocalsEnd : mainFunctionDescriptor->variablesDisplacement;
+
+    functionDescriptor->localsLevel = 0;
+    functionDescriptor->variablesDisplacement = displacement;
+    functionDescriptor->temporariesDisplacement = displacement;
+}
+
+/* Keeps the areas placed afterwards out of the local area of the main function or of a static function */
+void reserveStaticLocals(FunctionDescriptorPtr functionDescriptor) {
+    if(functionDescriptor->localsLevel == 0 && functionDescriptor->variablesDisplacement > staticLocalsEnd) {
+        staticLocalsEnd = functionDescriptor->variablesDisplacement;
+    }
+}
+
+/*
+ * The temporaries of the main function and of the static functions follow the static areas of their nested functions,
+ * once the nested functions were compiled
+ */
+void placeStaticTemporaries(FunctionDescriptorPtr functionDescriptor) {
+    if(functionDescriptor->localsLevel == 0 && staticLocalsEnd > functionDescriptor->variablesDisplacement) {
+        functionDescriptor->variablesDisplacement = staticLocalsEnd;
+        functionDescriptor->temporariesDisplacement = staticLocalsEnd;
+    }
+}
+
+/* Size of the local area allocated by the function's activation record, the main function allocates the static ones */
+int allocatedLocalsSize(FunctionDescriptorPtr functionDescriptor) {
+    if(functionDescriptor->localsLevel == 0 && functionDescriptor != getSymbolTable()->mainFunctionDescriptor) {
+        return 0;
+    }
+    return functionDescriptor->variablesDisplacement;
+}
+
+/**
+ * Constant expressions
+ **/
+
+bool evaluateBinaryOpExpression(TreeNodePtr node, long long* result);
+bool evaluateUnopExpression(TreeNodePtr node, long long* result);
+bool evaluateFactor(TreeNodePtr node, long long* result);
+
+/*
+ * Evaluates integer expressions made only of integer literals, integer constants (the parameters bound by a version,
+ * see addBoundValueParameter) and the arithmetic operators, returns false for any other expression (variables, function
+ * calls, boolean operators...), for a division by zero and when the result does not fit in an int. The operators are
+ * applied in the same order as the generated code applies them, so the result is the same value MEPA would compute
+ * (DIVI rounds towards minus infinity).
+ */
+bool evaluateConstantExpression(TreeNodePtr node, int* result) {
+    if(node->category != EXPRESSION_NODE || node->subtrees[1] != NULL) {
+        return false;
+    }
+
+    long long value;
+    TreeNodePtr expressionNode = node->subtrees[0];
+    bool constant;
+    switch (expressionNode->category) {
+        case BINARY_OPERATOR_EXPRESSION_NODE:
+            constant = evaluateBinaryOpExpression(expressionNode, &value);
+            break;
+        case UNARY_OPERATOR_EXPRESSION_NODE:
+            constant = evaluateUnopExpression(expressionNode, &value);
+            break;
+        default:
+            return false;
+    }
+
+    if(!constant || value < INT_MIN || value > INT_MAX) {
+        return false;
+    }
+
+    *result = (int) value;
+    return true;
+}
+
+bool evaluateBinaryOpExpression(TreeNodePtr node, long long* result) {
+    long long term;
+    if(!evaluateTerm(node->subtrees[0], &term)) {
+        return false;
+    }
+
+    TreeNodePtr operatorNode = node->subtrees[1];
+    if(operatorNode == NULL) {
+        *result = term;
+        return true;
+    }
+
+    long long rest;
+    if(!evaluateBinaryOpExpression(node->subtrees[2], &rest)) {
+        return false;
+    }
+    return applyConstantOperator(operatorNode->subtrees[0]->category, term, rest, result);
+}
+
+bool evaluateUnopExpression(TreeNodePtr node, long long* result) {
+    long long term;
+    if(!evaluateTerm(node->subtrees[1], &term)) {
+        return false;
+    }
+
+    switch (node->subtrees[0]->subtrees[0]->category) {
+        case PLUS_NODE:
+            break;
+        case MINUS_NODE:
+            term = -term;
+            break;
+        default:
+            return false;
+    }
+
+    TreeNodePtr additiveOperatorNode = node->subtrees[2];
+    if(additiveOperatorNode == NULL) {
+        *result = term;
+        return true;
+    }
+
+    long long rest;
+    if(!evaluateBinaryOpExpression(node->subtrees[3], &rest)) {
+        return false;
+    }
+    return applyConstantOperator(additiveOperatorNode->subtrees[0]->category, term, rest, result);
+}
+
+bool evaluateTerm(TreeNodePtr node, long long* result) {
+    long long factor;
+    if(!evaluateFactor(node->subtrees[0], &factor)) {
+        return false;
+    }
+
+    TreeNodePtr operatorNode = node->subtrees[1];
+    if(operatorNode == NULL) {
+        *result = factor;
+        return true;
+    }
+
+    long long rest;
+    if(!evaluateTerm(node->subtrees[2], &rest)) {
+        return false;
+    }
+    return applyConstantOperator(operatorNode->subtrees[0]->category, factor, rest, result);
+}
+
+bool evaluateFactor(TreeNodePtr node, long long* result) {
+    TreeNodePtr specificFactorNode = node->subtrees[0];
+    switch (specificFactorNode->category) {
+        case INTEGER_NODE:
+            *result = processInteger(specificFactorNode);
+            return true;
+        case EXPRESSION_NODE: {
+            int value;
+            if(!evaluateConstantExpression(specificFactorNode, &value)) {
+                return false;
+            }
+            *result = value;
+            return true;
+        }
+        case VALUE_NODE: {
+            SymbolTableEntryPtr entry = specificFactorNode->subtrees[1] == NULL ?
+                                        findIdentifier(specificFactorNode->subtrees[0]->name) : NULL;
+            if(entry == NULL || entry->category != CONSTANT_SYMBOL ||
+               !equivalentTypes(entry->description.constantDescriptor->type, getSymbolTable()->integerTypeDescriptor)) {
+                return false;
+            }
+            *result = entry->description.constantDescriptor->value;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+/* Evaluates the comparison of two constant expressions (see evaluateConstantExpression) */
+bool evaluateConstantCondition(TreeNodePtr node, bool* result) {
+    TreeNodePtr relationalOperatorNode = node->subtrees[1];
+    if(node->category != EXPRESSION_NODE || relationalOperatorNode == NULL) {
+        return false;
+    }
+
+    long long left;
+    long long right;
+    TreeNodePtr firstExprNode = node->subtrees[0];
+    bool constant = firstExprNode->category == BINARY_OPERATOR_EXPRESSION_NODE ?
+                    evaluateBinaryOpExpression(firstExprNode, &left) : evaluateUnopExpression(firstExprNode, &left);
+    if(!constant || !evaluateBinaryOpExpression(node->subtrees[2], &right)) {
+        return false;
+    }
+
+    switch (relationalOperatorNode->subtrees[0]->category) {
+        case LESS_OR_EQUAL_NODE:
+            *result = left <= right;
+            return true;
+        case LESS_NODE:
+            *result = left < right;
+            return true;
+        case EQUAL_NODE:
+            *result = left == right;
+            return true;
+        case DIFFERENT_NODE:
+            *result = left != right;
+            return true;
+        case GREATER_OR_EQUAL_NODE:
+            *result = left >= right;
+            return true;
+        case GREATER_NODE:
+            *result = left > right;
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool applyConstantOperator(NodeCategory operator, long long left, long long right, long long* result) {
+    // every intermediate result is kept in the int range, so these operations can't overflow a long long
+    switch (operator) {
+        case PLUS_NODE:
+            *result = left + right;
+            break;
+        case MINUS_NODE:
+            *result = left - right;
+            break;
+        case MULTIPLY_NODE:
+            *result = left * right;
+            break;
+        case DIV_NODE:
+            if(right == 0) {
+                return false;
+            }
+            *result = left / right;
+            if((left % right != 0) && ((left < 0) != (right < 0))) {
+                (*result)--;
+            }
+            break;
+        default:
+            return false;
+    }
+    return *result >= INT_MIN && *result <= INT_MAX;
+}
+
 /**
  * Semantic error treatment implementation
  **/
@@ -1 +1,17 @@
-void processProgram(void *p);
\ No newline at end of file
+#ifndef CODEGEN_HEADER
+#define CODEGEN_HEADER
+
+#include "tree.h"
+
+void processProgram(void *p);
+
+/*
+ * Compile time evaluation of subscripts, also used by the loop analyses
+ */
+bool evaluateConstantExpression(TreeNodePtr node, int* result);
+bool evaluateBinaryOpExpression(TreeNodePtr node, long long* result);
+/* Applies an arithmetic operator like MEPA, returns false for a division by zero or a result outside the int range */
+bool applyConstantOperator(NodeCategory operator, long long left, long long right, long long* result);
+TreeNodePtr splitSubscript(TreeNodePtr expressionNode, bool splitConstantTerms, int* constant);
+
+#endif
@@ -0,0 +1,547 @@
+#include "controlflow.h"
+#include "symboltable.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/* The block each label starts and its graph, indexed by label */
+typedef struct {
+    ControlFlowGraphPtr* graphs;
+    BasicBlockPtr* blocks;
+} LabelMap;
+
+ControlFlowGraphPtr newControlFlowGraph(const char* command);
+bool parseInstruction(const char* command, MepaInstructionPtr instruction);
+const char* skipSpaces(const char* text);
+bool isMnemonic(MepaInstructionPtr instruction, const char* mnemonic);
+bool isBranch(MepaInstructionPtr instruction);
+void splitBlocks(ControlFlowGraphPtr graph);
+LabelMap mapLabels(Stack* graphs);
+void addEdges(ControlFlowGraphPtr graph, LabelMap labels);
+void addEdge(BasicBlockPtr block, BasicBlockPtr successor);
+void addStackEffects(ControlFlowGraphPtr graph, LabelMap labels);
+int fixedStackEffect(MepaInstructionPtr instruction);
+void findDominators(ControlFlowGraphPtr graph);
+void findImmediateDominators(ControlFlowGraphPtr graph);
+void dumpBlock(BasicBlockPtr block, ControlFlowGraphPtr graph, int graphIndex, FILE* output);
+int findGraphIndex(Stack* graphs, ControlFlowGraphPtr graph);
+void freeControlFlowGraph(ControlFlowGraphPtr graph);
+
+Stack* buildControlFlowGraphs() {
+    int commandsCount = nextCommandIndex();
+    ControlFlowGraphPtr* owners = malloc((commandsCount + 1) * sizeof(ControlFlowGraphPtr));
+    Stack* graphs = newStack();
+    Stack* open = newStack();
+
+    // the graphs are pushed as they are entered, so the main function's one ends at the bottom
+    MepaInstruction instruction;
+    for (int command = 0; command < commandsCount; command++) {
+        owners[command] = NULL;
+        if (!parseInstruction(getCommand(command), &instruction)) {
+            continue;
+        }
+        if (isMnemonic(&instruction, "MAIN") || isMnemonic(&instruction, "ENFN")) {
+            ControlFlowGraphPtr graph = newControlFlowGraph(getCommand(command));
+            push(graphs, graph);
+            push(open, graph);
+        }
+        if (open->top == NULL) {
+            // the END command follows the main function
+            continue;
+        }
+
+        ControlFlowGraphPtr graph = open->top->data;
+        owners[command] = graph;
+        graph->instructionsCount++;
+        if (isMnemonic(&instruction, "RTRN") || isMnemonic(&instruction, "STOP")) {
+            pop(open);
+        }
+    }
+    while (pop(open) != NULL);
+    free(open);
+
+    for (LinkedNode* node = graphs->top; node != NULL; node = node->next) {
+        ControlFlowGraphPtr graph = node->data;
+        graph->instructions = malloc(graph->instructionsCount * sizeof(MepaInstruction));
+        graph->instructionsCount = 0;
+    }
+    for (int command = 0; command < commandsCount; command++) {
+        if (owners[command] != NULL) {
+            ControlFlowGraphPtr graph = owners[command];
+            parseInstruction(getCommand(command), &graph->instructions[graph->instructionsCount++]);
+            graph->instructions[graph->instructionsCount - 1].command = command;
+        }
+    }
+    free(owners);
+
+    for (LinkedNode* node = graphs->top; node != NULL; node = node->next) {
+        splitBlocks(node->data);
+    }
+    LabelMap labels = mapLabels(graphs);
+    for (LinkedNode* node = graphs->top; node != NULL; node = node->next) {
+        addEdges(node->data, labels);
+    }
+    for (LinkedNode* node = graphs->top; node != NULL; node = node->next) {
+        addStackEffects(node->data, labels);
+        findDominators(node->data);
+        findImmediateDominators(node->data);
+    }
+    free(labels.graphs);
+    free(labels.blocks);
+    return graphs;
+}
+
+ControlFlowGraphPtr newControlFlowGraph(const char* command) {
+    ControlFlowGraphPtr graph = malloc(sizeof(ControlFlowGraph));
+    // the ENFN commands are commented with the function's name
+    const char* comment = strchr(command, '\t');
+    const char* name = comment != NULL ? skipSpaces(comment) : "main";
+    graph->name = malloc(strlen(name) + 1);
+    strcpy(graph->name, name);
+    graph->instructions = NULL;
+    graph->instructionsCount = 0;
+    graph->blocks = NULL;
+    graph->blocksCount = 0;
+    return graph;
+}
+
+/**
+ * Instructions
+ **/
+
+/*
+ * Parses a buffered command: an optional label definition ("L3: "), the mnemonic, its operands separated by commas and
+ * an optional comment after a tab. Returns false for the removed and placeholder commands
+ */
+bool parseInstruction(const char* command, MepaInstructionPtr instruction) {
+    if (command == NULL) {
+        return false;
+    }
+
+    instruction->command = -1;
+    instruction->label = -1;
+    instruction->operandsCount = 0;
+    instruction->stackEffect = 0;
+
+    const char* current = skipSpaces(command);
+    if (current[0] == 'L' && isdigit((unsigned char) current[1])) {
+        char* end;
+        int label = (int) strtol(current + 1, &end, 10);
+        if (*end == ':') {
+            instruction->label = label;
+            current = skipSpaces(end + 1);
+        }
+    }
+
+    int length = 0;
+    while (isupper((unsigned char) current[length]) && length < 4) {
+        instruction->mnemonic[length] = current[length];
+        length++;
+    }
+    instruction->mnemonic[length] = '\0';
+    current = skipSpaces(current + length);
+
+    while (*current != '\0' && *current != '\t' && instruction->operandsCount < MAX_MEPA_OPERANDS) {
+        if (*current == 'L') {
+            current++;
+        }
+        char* end;
+        instruction->operands[instruction->operandsCount++] = (int) strtol(current, &end, 10);
+        current = *end == ',' ? end + 1 : end;
+        if (current == end) {
+            break;
+        }
+    }
+    return length > 0;
+}
+
+const char* skipSpaces(const char* text) {
+    while (*text == ' ' || *text == '\t') {
+        text++;
+    }
+    return text;
+}
+
+bool isMnemonic(MepaInstructionPtr instruction, const char* mnemonic) {
+    return strcmp(instruction->mnemonic, mnemonic) == 0;
+}
+
+/* Instructions after which the next one isn't necessarily run */
+bool isBranch(MepaInstructionPtr instruction) {
+    return isMnemonic(instruction, "JUMP") || isMnemonic(instruction, "JMPF") ||
+           isMnemonic(instruction, "RTRN") || isMnemonic(instruction, "STOP");
+}
+
+/**
+ * Blocks and edges
+ **/
+
+/* A block starts at the first instruction, at every label definition and after every branch */
+void splitBlocks(ControlFlowGraphPtr graph) {
+    graph->blocks = malloc(graph->instructionsCount * sizeof(BasicBlockPtr));
+    for (int i = 0; i < graph->instructionsCount; i++) {
+        bool leader = i == 0 || graph->instructions[i].label >= 0 || isBranch(&graph->instructions[i - 1]);
+        if (!leader) {
+            graph->blocks[graph->blocksCount - 1]->lastInstruction = i;
+            continue;
+        }
+
+        BasicBlockPtr block = malloc(sizeof(BasicBlock));
+        block->index = graph->blocksCount;
+        block->firstInstruction = i;
+        block->lastInstruction = i;
+        block->successors = newStack();
+        block->predecessors = newStack();
+        block->stackEffect = 0;
+        block->stackReset = false;
+        block->unknownStackEffect = false;
+        block->externalEntry = false;
+        block->externalExit = false;
+        block->reachable = false;
+        block->dominators = NULL;
+        block->immediateDominator = -1;
+        graph->blocks[graph->blocksCount++] = block;
+    }
+}
+
+/* Labels are unique in the whole program, the gotos of nested functions jump to the enclosing functions' ones */
+LabelMap mapLabels(Stack* graphs) {
+    int labelsCount = allocatedMEPALabels() + 1;
+    LabelMap labels = {
+        .graphs = calloc(labelsCount, sizeof(ControlFlowGraphPtr)),
+        .blocks = calloc(labelsCount, sizeof(BasicBlockPtr))
+    };
+    for (LinkedNode* node = graphs->top; node != NULL; node = node->next) {
+        ControlFlowGraphPtr graph = node->data;
+        for (int b = 0; b < graph->blocksCount; b++) {
+            int label = graph->instructions[graph->blocks[b]->firstInstruction].label;
+            if (label >= 0 && label < labelsCount) {
+                labels.graphs[label] = graph;
+                labels.blocks[label] = graph->blocks[b];
+            }
+        }
+    }
+    return labels;
+}
+
+void addEdges(ControlFlowGraphPtr graph, LabelMap labels) {
+    int labelsCount = allocatedMEPALabels() + 1;
+    for (int b = 0; b < graph->blocksCount; b++) {
+        BasicBlockPtr block = graph->blocks[b];
+        MepaInstructionPtr last = &graph->instructions[block->lastInstruction];
+
+        if (isMnemonic(last, "JUMP") || isMnemonic(last, "JMPF")) {
+            int label = last->operands[0];
+            if (label >= 0 && label < labelsCount && labels.graphs[label] == graph) {
+                addEdge(block, labels.blocks[label]);
+            } else if (label >= 0 && label < labelsCount && labels.blocks[label] != NULL) {
+                block->externalExit = true;
+                labels.blocks[label]->externalEntry = true;
+            }
+        }
+        bool fallsThrough = !isMnemonic(last, "JUMP") && !isMnemonic(last, "RTRN") && !isMnemonic(last, "STOP");
+        if (fallsThrough && b + 1 < graph->blocksCount) {
+            addEdge(block, graph->blocks[b + 1]);
+        }
+    }
+}
+
+bool bySameBlock(void* data, void* secondParam) {
+    return data == secondParam;
+}
+
+void addEdge(BasicBlockPtr block, BasicBlockPtr successor) {
+    // a conditional jump to the next block is a single edge
+    if (find(block->successors, successor, bySameBlock) == NULL) {
+        push(block->successors, successor);
+        push(successor->predecessors, block);
+    }
+}
+
+/**
+ * Stack effects
+ **/
+
+void addStackEffects(ControlFlowGraphPtr graph, LabelMap labels) {
+    int labelsCount = allocatedMEPALabels() + 1;
+    for (int b = 0; b < graph->blocksCount; b++) {
+        BasicBlockPtr block = graph->blocks[b];
+        for (int i = block->firstInstruction; i <= block->lastInstruction; i++) {
+            MepaInstructionPtr instruction = &graph->instructions[i];
+
+            if (isMnemonic(instruction, "ENLB")) {
+                block->stackReset = true;
+                block->stackEffect = 0;
+                continue;
+            }
+            if (isMnemonic(instruction, "CPFN")) {
+                block->unknownStackEffect = true;
+                continue;
+            }
+            if (isMnemonic(instruction, "CFUN")) {
+                // the called function's RTRN pops its arguments, along with the words pushed by CFUN and ENFN
+                int label = instruction->operands[0];
+                ControlFlowGraphPtr called = label >= 0 && label < labelsCount ? labels.graphs[label] : NULL;
+                if (called == NULL) {
+                    block->unknownStackEffect = true;
+                    continue;
+                }
+                instruction->stackEffect = -called->instructions[called->instructionsCount - 1].operands[0];
+            } else {
+                instruction->stackEffect = fixedStackEffect(instruction);
+            }
+            block->stackEffect += instruction->stackEffect;
+        }
+    }
+}
+
+/* The effect of the instructions whose effect depends on their own operands only */
+int fixedStackEffect(MepaInstructionPtr instruction) {
+    static const char* const pushingOne[] = {
+        "LDCT", "LDVL", "LADR", "LVLI", "READ", "ENFN", NULL
+    };
+    static const char* const poppingOne[] = {
+        "ADDD", "SUBT", "MULT", "DIVI", "LAND", "LORR", "LESS", "GRTR", "EQUA", "DIFF", "LEQU", "GEQU",
+        "STVL", "STVI", "PRNT", "JMPF", "INDX", NULL
+    };
+
+    for (int i = 0; pushingOne[i] != NULL; i++) {
+        if (isMnemonic(instruction, pushingOne[i])) {
+            return 1;
+        }
+    }
+    for (int i = 0; poppingOne[i] != NULL; i++) {
+        if (isMnemonic(instruction, poppingOne[i])) {
+            return -1;
+        }
+    }
+
+    int operand = instruction->operandsCount > 0 ? instruction->operands[0] : 0;
+    if (isMnemonic(instruction, "ALOC")) {
+        return operand;
+    } else if (isMnemonic(instruction, "DLOC")) {
+        return -operand;
+    } else if (isMnemonic(instruction, "LDMV")) {
+        return operand - 1;
+    } else if (isMnemonic(instruction, "STMV")) {
+        return -(operand + 1);
+    } else if (isMnemonic(instruction, "RTRN")) {
+        // the arguments, the static link and the three words of the call
+        return -(operand + 4);
+    } else if (isMnemonic(instruction, "LGAD")) {
+        return 3;
+    }
+    // NEGT, LNOT, CONT, NOOP, JUMP, MAIN, STOP, DUMP
+    return 0;
+}
+
+/**
+ * Dominators
+ **/
+
+/*
+ * Iterates dom(b) = {b} + the intersection of dom(p) for the reachable predecessors p of b until nothing changes, over
+ * the blocks reached from a root: the entry block and the blocks entered by gotos of nested functions. A block no root
+ * reaches (ex: dead code after a jump) is only dominated by itself and doesn't take part in the other blocks' sets
+ */
+void findDominators(ControlFlowGraphPtr graph) {
+    int count = graph->blocksCount;
+    for (int b = 0; b < count; b++) {
+        graph->blocks[b]->reachable = false;
+    }
+    Stack* pending = newStack();
+    for (int b = 0; b < count; b++) {
+        BasicBlockPtr block = graph->blocks[b];
+        if (b == 0 || block->externalEntry) {
+            block->reachable = true;
+            push(pending, block);
+        }
+    }
+    BasicBlockPtr block;
+    while ((block = pop(pending)) != NULL) {
+        for (LinkedNode* node = block->successors->top; node != NULL; node = node->next) {
+            BasicBlockPtr successor = node->data;
+            if (!successor->reachable) {
+                successor->reachable = true;
+                push(pending, successor);
+            }
+        }
+    }
+    free(pending);
+
+    for (int b = 0; b < count; b++) {
+        block = graph->blocks[b];
+        bool root = b == 0 || block->externalEntry || !block->reachable;
+        block->dominators = malloc(count * sizeof(bool));
+        for (int d = 0; d < count; d++) {
+            block->dominators[d] = root ? d == b : graph->blocks[d]->reachable;
+        }
+    }
+
+    bool* intersection = malloc(count * sizeof(bool));
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int b = 1; b < count; b++) {
+            block = graph->blocks[b];
+            if (block->externalEntry || !block->reachable) {
+                continue;
+            }
+
+            for (int d = 0; d < count; d++) {
+                intersection[d] = true;
+            }
+            for (LinkedNode* node = block->predecessors->top; node != NULL; node = node->next) {
+                BasicBlockPtr predecessor = node->data;
+                if (!predecessor->reachable) {
+                    continue;
+                }
+                for (int d = 0; d < count; d++) {
+                    intersection[d] = intersection[d] && predecessor->dominators[d];
+                }
+            }
+            intersection[b] = true;
+
+            for (int d = 0; d < count; d++) {
+                if (block->dominators[d] != intersection[d]) {
+                    block->dominators[d] = intersection[d];
+                    changed = true;
+                }
+            }
+        }
+    }
+    free(intersection);
+}
+
+/* The immediate dominator is the strict dominator dominated by all the other ones, the one with most dominators */
+void findImmediateDominators(ControlFlowGraphPtr graph) {
+    for (int b = 0; b < graph->blocksCount; b++) {
+        BasicBlockPtr block = graph->blocks[b];
+        int mostDominators = 0;
+        for (int d = 0; d < graph->blocksCount; d++) {
+            if (d == b || !block->dominators[d]) {
+                continue;
+            }
+
+            int dominatorsCount = 0;
+            for (int i = 0; i < graph->blocksCount; i++) {
+                dominatorsCount += graph->blocks[d]->dominators[i] ? 1 : 0;
+            }
+            if (dominatorsCount > mostDominators) {
+                mostDominators = dominatorsCount;
+                block->immediateDominator = d;
+            }
+        }
+    }
+}
+
+/**
+ * DOT dump
+ **/
+
+void dumpControlFlowGraphs(Stack* graphs, FILE* output) {
+    fprintf(output, "digraph program {\n");
+    fprintf(output, "    node [shape=box, fontname=\"monospace\"];\n");
+
+    // the clusters are numbered from the main function's one, in the order the functions were entered
+    int graphIndex = graphs->size - 1;
+    for (LinkedNode* node = graphs->top; node != NULL; node = node->next) {
+        ControlFlowGraphPtr graph = node->data;
+        fprintf(output, "    subgraph cluster_%d {\n", graphIndex);
+        fprintf(output, "        label=\"%s\";\n", graph->name);
+        for (int b = 0; b < graph->blocksCount; b++) {
+            dumpBlock(graph->blocks[b], graph, graphIndex, output);
+        }
+        fprintf(output, "    }\n");
+        graphIndex--;
+    }
+
+    // the gotos of nested functions, between the clusters
+    LabelMap labels = mapLabels(graphs);
+    int labelsCount = allocatedMEPALabels() + 1;
+    graphIndex = graphs->size - 1;
+    for (LinkedNode* node = graphs->top; node != NULL; node = node->next) {
+        ControlFlowGraphPtr graph = node->data;
+        for (int b = 0; b < graph->blocksCount; b++) {
+            BasicBlockPtr block = graph->blocks[b];
+            int label = graph->instructions[block->lastInstruction].operands[0];
+            if (block->externalExit && label >= 0 && label < labelsCount && labels.graphs[label] != NULL) {
+                fprintf(output, "    F%dB%d -> F%dB%d [style=dashed];\n", graphIndex, b,
+                        findGraphIndex(graphs, labels.graphs[label]), labels.blocks[label]->index);
+            }
+        }
+        graphIndex--;
+    }
+    free(labels.graphs);
+    free(labels.blocks);
+
+    fprintf(output, "}\n");
+}
+
+void dumpBlock(BasicBlockPtr block, ControlFlowGraphPtr graph, int graphIndex, FILE* output) {
+    fprintf(output, "        F%dB%d [label=\"B%d", graphIndex, block->index, block->index);
+    if (block->immediateDominator >= 0) {
+        fprintf(output, "  idom B%d", block->immediateDominator);
+    }
+    if (block->unknownStackEffect) {
+        fprintf(output, "  stack ?");
+    } else {
+        fprintf(output, "  stack %s%+d", block->stackReset ? "= " : "", block->stackEffect);
+    }
+    fprintf(output, "\\l");
+
+    // the commands without their comments
+    for (int i = block->firstInstruction; i <= block->lastInstruction; i++) {
+        const char* command = getCommand(graph->instructions[i].command);
+        int length = (int) strcspn(command, "\t");
+        while (length > 0 && command[length - 1] == ' ') {
+            length--;
+        }
+        fprintf(output, "%.*s\\l", length, command);
+    }
+    fprintf(output, "\"];\n");
+
+    for (LinkedNode* node = block->successors->top; node != NULL; node = node->next) {
+        fprintf(output, "        F%dB%d -> F%dB%d;\n", graphIndex, block->index, graphIndex,
+                ((BasicBlockPtr) node->data)->index);
+    }
+}
+
+int findGraphIndex(Stack* graphs, ControlFlowGraphPtr graph) {
+    int graphIndex = graphs->size - 1;
+    for (LinkedNode* node = graphs->top; node != NULL; node = node->next) {
+        if (node->data == graph) {
+            return graphIndex;
+        }
+        graphIndex--;
+    }
+    return -1;
+}
+
+/**
+ * Release
+ **/
+
+void freeControlFlowGraphs(Stack* graphs) {
+    while (graphs->top != NULL) {
+        freeControlFlowGraph(pop(graphs));
+    }
+    free(graphs);
+}
+
+void freeControlFlowGraph(ControlFlowGraphPtr graph) {
+    for (int b = 0; b < graph->blocksCount; b++) {
+        BasicBlockPtr block = graph->blocks[b];
+        while (pop(block->successors) != NULL);
+        free(block->successors);
+        while (pop(block->predecessors) != NULL);
+        free(block->predecessors);
+        free(block->dominators);
+        free(block);
+    }
+    free(graph->blocks);
+    free(graph->instructions);
+    free(graph->name);
+    free(graph);
+}
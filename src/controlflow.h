@@ -0,0 +1,82 @@
+/**
+ * This module builds the control flow graphs of the buffered MEPA code, one per function, so analyses of the generated
+ * code can work on basic blocks instead of the command text
+ *
+ * The code of a nested function is emitted inside its enclosing function's one, between the jump to the enclosing
+ * body and the body itself: the instructions of a function are the ones from its ENFN (MAIN for the main function) to
+ * its RTRN (STOP), without the nested functions' ones. Calls don't end basic blocks, they return to the next
+ * instruction
+ **/
+
+#ifndef CONTROL_FLOW_HEADER
+#define CONTROL_FLOW_HEADER
+
+#include <stdio.h>
+#include "utils.h"
+
+#define MAX_MEPA_OPERANDS 3
+
+typedef struct {
+    /* Index of the instruction's command in the commands buffer */
+    int command;
+    /* Label defined by the instruction, -1 if it has none */
+    int label;
+    char mnemonic[5];
+    /* The operands, a label operand (ex: JUMP L3) is kept as the label number */
+    int operands[MAX_MEPA_OPERANDS];
+    int operandsCount;
+    /*
+     * Words the instruction pushes (positive) or pops (negative), a call is taken as returning: it pops the arguments
+     * of the called function
+     */
+    int stackEffect;
+} MepaInstruction, *MepaInstructionPtr;
+
+typedef struct _BasicBlock {
+    int index;
+    /* Range of the block's instructions in its graph, the last one included */
+    int firstInstruction;
+    int lastInstruction;
+    /* Blocks of the same graph, BasicBlockPtr */
+    Stack* successors;
+    Stack* predecessors;
+    /*
+     * Net stack effect of the block's instructions. ENLB sets the stack to the end of the local area, the effect is
+     * then counted from there on (stackReset), and a call through a function parameter pops an unknown number of
+     * arguments (unknownStackEffect)
+     */
+    int stackEffect;
+    bool stackReset;
+    bool unknownStackEffect;
+    /* Entered by a goto of a nested function, or leaving to a label of an enclosing function */
+    bool externalEntry;
+    bool externalExit;
+    /* Reached from the entry block or a block entered by a goto of a nested function */
+    bool reachable;
+    /* Indexed by block index, the blocks every path from an entry of the function to this block goes through */
+    bool* dominators;
+    /* -1 for the entries of the function and the blocks no entry reaches */
+    int immediateDominator;
+} BasicBlock, *BasicBlockPtr;
+
+typedef struct {
+    /* The name the ENFN command is commented with, "main" for the main function */
+    char* name;
+    MepaInstructionPtr instructions;
+    int instructionsCount;
+    /* In the order of their instructions, the entry block first */
+    BasicBlockPtr* blocks;
+    int blocksCount;
+} ControlFlowGraph, *ControlFlowGraphPtr;
+
+/*
+ * Builds the graphs of the functions in the commands buffer, the graph of the main function at the bottom of the
+ * stack, with the edges and dominators of their blocks. The buffer must not change while the graphs are used
+ */
+Stack* buildControlFlowGraphs();
+void freeControlFlowGraphs(Stack* graphs);
+
+/* Writes the graphs in the DOT language, one cluster per function */
+void dumpControlFlowGraphs(Stack* graphs, FILE* output);
+
+#endif
@@ -0,0 +1,578 @@
+#include "evaluation.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "codegen.h"
+
+/*
+ * Most tree nodes evaluated by a call, the nested calls included: enough for short loops and recursions (ex: a
+ * factorial or a power of two), while a call running for too long is left to MEPA instead of slowing the compilation
+ */
+#define EVALUATION_STEPS_LIMIT 100000
+
+/* Most calls active at the same time, the evaluator recurses on the C stack */
+#define EVALUATION_DEPTH_LIMIT 256
+
+typedef struct {
+    PureFunctionPtr function;
+    bool rejected;
+} PuritySearch;
+
+typedef struct {
+    int steps;
+    int depth;
+} Evaluation;
+
+typedef struct {
+    PureFunctionPtr function;
+    int* values;
+    bool* assigned;
+    bool returned;
+    int result;
+    Evaluation* evaluation;
+} Activation;
+
+bool addLocals(PureFunctionPtr function, TreeNodePtr headerNode, TreeNodePtr variablesNode);
+void addLocal(PureFunctionPtr function, char* identifier);
+bool isScalarLocal(SymbolTableEntryPtr entry, bool parameter);
+bool inspectPureBody(TreeNodePtr node, void* context);
+int findLocal(PureFunctionPtr function, char* identifier);
+SymbolTableEntryPtr findScopeSymbol(PureFunctionPtr function, char* identifier);
+void freePureFunction(PureFunctionPtr function);
+bool byPureFunctionDescriptor(void* data, void* secondParam);
+bool byScopeIdentifier(void* data, void* secondParam);
+
+bool callPureFunction(PureFunctionPtr function, int* arguments, Evaluation* evaluation, int* result);
+bool executeStatements(TreeNodePtr statementNode, Activation* activation);
+bool executeStatement(TreeNodePtr node, Activation* activation);
+bool executeWhile(TreeNodePtr node, Activation* activation);
+bool evaluateNode(TreeNodePtr node, Activation* activation, int* value);
+bool evaluateExpressionNode(TreeNodePtr node, Activation* activation, int* value);
+bool evaluateBinaryOpNode(TreeNodePtr node, Activation* activation, int* value);
+bool evaluateUnopNode(TreeNodePtr node, Activation* activation, int* value);
+bool evaluateTermNode(TreeNodePtr node, Activation* activation, int* value);
+bool evaluateFactorNode(TreeNodePtr node, Activation* activation, int* value);
+bool evaluateValueNode(TreeNodePtr node, Activation* activation, int* value);
+bool evaluateCallNode(TreeNodePtr node, Activation* activation, int* value);
+bool applyOperator(NodeCategory operator, int left, int right, int* value);
+bool countStep(Activation* activation);
+
+/* The selected functions, the last one declared on top */
+Stack* pureFunctions = NULL;
+
+/**
+ * Purity
+ **/
+
+void selectPureFunction(TreeNodePtr functionNode, SymbolTableEntryPtr functionEntry) {
+    FunctionDescriptorPtr functionDescriptor = functionEntry->description.functionDescriptor;
+    TypeDescriptorPtr returnType = functionDescriptor->returnType;
+    TreeNodePtr blockNode = functionNode->subtrees[1];
+    if(returnType == NULL || returnType->category != PREDEFINED_TYPE || blockNode->subtrees[0] != NULL ||
+       blockNode->subtrees[3] != NULL) {
+        return;
+    }
+
+    PureFunctionPtr function = malloc(sizeof(PureFunction));
+    function->functionEntry = functionEntry;
+    function->bodyNode = blockNode->subtrees[4];
+    function->locals = NULL;
+    function->parametersCount = 0;
+    function->localsCount = 0;
+    function->scope = newStack();
+    if(!addLocals(function, functionNode->subtrees[0], blockNode->subtrees[2])) {
+        freePureFunction(function);
+        return;
+    }
+
+    PuritySearch search = {
+        .function = function,
+        .rejected = false
+    };
+    TreeVisitor visitor = {
+        .preVisit = inspectPureBody,
+        .postVisit = NULL,
+        .categoryFilter = NULL,
+        .context = &search
+    };
+    visitSubtree(function->bodyNode, &visitor);
+
+    if(search.rejected) {
+        freePureFunction(function);
+        return;
+    }
+
+    if(pureFunctions == NULL) {
+        pureFunctions = newStack();
+    }
+    push(pureFunctions, function);
+}
+
+PureFunctionPtr findPureFunction(FunctionDescriptorPtr functionDescriptor) {
+    if(pureFunctions == NULL) {
+        return NULL;
+    }
+    return (PureFunctionPtr) find(pureFunctions, functionDescriptor, byPureFunctionDescriptor);
+}
+
+/* Adds the parameters and variables of the function, returns false if one of them isn't a scalar */
+bool addLocals(PureFunctionPtr function, TreeNodePtr headerNode, TreeNodePtr variablesNode) {
+    for (TreeNodePtr parameterNode = headerNode->subtrees[2]; parameterNode != NULL;
+         parameterNode = parameterNode->next) {
+        if(parameterNode->category != EXPRESSION_PARAMETER_BY_VALUE_NODE) {
+            return false;
+        }
+        for (TreeNodePtr identifierNode = parameterNode->subtrees[0]; identifierNode != NULL;
+             identifierNode = identifierNode->next) {
+            if(!isScalarLocal(findIdentifier(identifierNode->name), true)) {
+                return false;
+            }
+            addLocal(function, identifierNode->name);
+            function->parametersCount++;
+        }
+    }
+
+    if(variablesNode == NULL) {
+        return true;
+    }
+    for (TreeNodePtr declarationNode = variablesNode->subtrees[0]; declarationNode != NULL;
+         declarationNode = declarationNode->next) {
+        for (TreeNodePtr identifierNode = declarationNode->subtrees[0]; identifierNode != NULL;
+             identifierNode = identifierNode->next) {
+            if(!isScalarLocal(findIdentifier(identifierNode->name), false)) {
+                return false;
+            }
+            addLocal(function, identifierNode->name);
+        }
+    }
+    return true;
+}
+
+void addLocal(PureFunctionPtr function, char* identifier) {
+    function->locals = realloc(function->locals, (function->localsCount + 1) * sizeof(char*));
+    function->locals[function->localsCount++] = identifier;
+}
+
+/*
+ * Parameters must be integers, the only constants the code generator evaluates, the variables may be booleans too.
+ * Their entries are the function's own ones, since its level didn't end yet
+ */
+bool isScalarLocal(SymbolTableEntryPtr entry, bool parameter) {
+    if(entry == NULL) {
+        return false;
+    }
+    TypeDescriptorPtr integerType = getSymbolTable()->integerTypeDescriptor;
+    if(parameter) {
+        return entry->category == PARAMETER_SYMBOL &&
+               equivalentTypes(entry->description.parameterDescriptor->type, integerType);
+    }
+    return entry->category == VARIABLE_SYMBOL &&
+           entry->description.variableDescriptor->type->category == PREDEFINED_TYPE;
+}
+
+bool inspectPureBody(TreeNodePtr node, void* context) {
+    PuritySearch* search = (PuritySearch*) context;
+    PureFunctionPtr function = search->function;
+
+    switch (node->category) {
+        case VALUE_NODE: {
+            char* identifier = node->subtrees[0]->name;
+            if(node->subtrees[1] != NULL) {
+                search->rejected = true;
+            } else if(findLocal(function, identifier) < 0) {
+                SymbolTableEntryPtr entry = findIdentifier(identifier);
+                search->rejected = entry == NULL || entry->category != CONSTANT_SYMBOL;
+                if(!search->rejected && findScopeSymbol(function, identifier) == NULL) {
+                    push(function->scope, entry);
+                }
+            }
+            break;
+        }
+        case FUNCTION_CALL_NODE: {
+            char* identifier = node->subtrees[0]->name;
+            SymbolTableEntryPtr entry = findIdentifier(identifier);
+            // a function can only call itself or the functions declared before it, already selected or not
+            search->rejected = entry == NULL || entry->category != FUNCTION_SYMBOL ||
+                               (entry != function->functionEntry &&
+                                findPureFunction(entry->description.functionDescriptor) == NULL);
+            if(!search->rejected && findScopeSymbol(function, identifier) == NULL) {
+                push(function->scope, entry);
+            }
+            break;
+        }
+        case GOTO_NODE:
+        case LABEL_NODE:
+            search->rejected = true;
+            break;
+        default:
+            break;
+    }
+    return !search->rejected;
+}
+
+int findLocal(PureFunctionPtr function, char* identifier) {
+    for (int i = 0; i < function->localsCount; i++) {
+        if(strcmp(function->locals[i], identifier) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+SymbolTableEntryPtr findScopeSymbol(PureFunctionPtr function, char* identifier) {
+    return (SymbolTableEntryPtr) find(function->scope, identifier, byScopeIdentifier);
+}
+
+void freePureFunction(PureFunctionPtr function) {
+    while (pop(function->scope) != NULL);
+    free(function->scope);
+    free(function->locals);
+    free(function);
+}
+
+bool byPureFunctionDescriptor(void* data, void* secondParam) {
+    PureFunctionPtr function = (PureFunctionPtr) data;
+    return function->functionEntry->description.functionDescriptor == (FunctionDescriptorPtr) secondParam;
+}
+
+bool byScopeIdentifier(void* data, void* secondParam) {
+    SymbolTableEntryPtr entry = (SymbolTableEntryPtr) data;
+    return strcmp(entry->identifier, (char*) secondParam) == 0;
+}
+
+/**
+ * Evaluation
+ **/
+
+bool evaluatePureCall(PureFunctionPtr function, int* arguments, int* result) {
+    Evaluation evaluation = {
+        .steps = 0,
+        .depth = 0
+    };
+    return callPureFunction(function, arguments, &evaluation, result);
+}
+
+bool callPureFunction(PureFunctionPtr function, int* arguments, Evaluation* evaluation, int* result) {
+    if(evaluation->depth >= EVALUATION_DEPTH_LIMIT) {
+        return false;
+    }
+
+    Activation activation = {
+        .function = function,
+        .values = calloc(function->localsCount + 1, sizeof(int)),
+        .assigned = calloc(function->localsCount + 1, sizeof(bool)),
+        .returned = false,
+        .result = 0,
+        .evaluation = evaluation
+    };
+    for (int i = 0; i < function->parametersCount; i++) {
+        activation.values[i] = arguments[i];
+        activation.assigned[i] = true;
+    }
+
+    evaluation->depth++;
+    bool evaluated = executeStatements(function->bodyNode->subtrees[0], &activation);
+    evaluation->depth--;
+
+    free(activation.values);
+    free(activation.assigned);
+    // a function ending without a return leaves its result undefined
+    if(!evaluated || !activation.returned) {
+        return false;
+    }
+    *result = activation.result;
+    return true;
+}
+
+/* Runs a sequence of statements until one returns, the body's statement nodes or the unlabeled ones of a compound */
+bool executeStatements(TreeNodePtr statementNode, Activation* activation) {
+    for (TreeNodePtr node = statementNode; node != NULL && !activation->returned; node = node->next) {
+        // pure functions have no labels, so the statements of the body are unlabeled
+        TreeNodePtr unlabeledStatementNode = node->category == STATEMENT_NODE ? node->subtrees[0] : node;
+        if(!executeStatement(unlabeledStatementNode, activation)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool executeStatement(TreeNodePtr node, Activation* activation) {
+    if(node == NULL) {
+        return true;
+    }
+    if(!countStep(activation)) {
+        return false;
+    }
+
+    int value;
+    switch (node->category) {
+        case ASSIGNMENT_NODE: {
+            if(!evaluateExpressionNode(node->subtrees[1], activation, &value)) {
+                return false;
+            }
+            int local = findLocal(activation->function, node->subtrees[0]->subtrees[0]->name);
+            if(local < 0) {
+                return false;
+            }
+            activation->values[local] = value;
+            activation->assigned[local] = true;
+            return true;
+        }
+        case FUNCTION_CALL_NODE:
+            return evaluateCallNode(node, activation, &value);
+        case RETURN_NODE:
+            if(node->subtrees[0] == NULL || !evaluateExpressionNode(node->subtrees[0], activation, &value)) {
+                return false;
+            }
+            activation->result = value;
+            activation->returned = true;
+            return true;
+        case IF_NODE: {
+            if(!evaluateExpressionNode(node->subtrees[0], activation, &value)) {
+                return false;
+            }
+            TreeNodePtr compoundNode = value != 0 ? node->subtrees[1] : node->subtrees[2];
+            return compoundNode == NULL || executeStatements(compoundNode->subtrees[0], activation);
+        }
+        case WHILE_NODE:
+            return executeWhile(node, activation);
+        case COMPOUND_NODE:
+            return executeStatements(node->subtrees[0], activation);
+        default:
+            return false;
+    }
+}
+
+bool executeWhile(TreeNodePtr node, Activation* activation) {
+    while (!activation->returned) {
+        int condition;
+        if(!evaluateExpressionNode(node->subtrees[0], activation, &condition)) {
+            return false;
+        }
+        if(condition == 0) {
+            return true;
+        }
+        if(!executeStatements(node->subtrees[1]->subtrees[0], activation)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Evaluates the operand of an expression: a binary or unary operator expression */
+bool evaluateNode(TreeNodePtr node, Activation* activation, int* value) {
+    switch (node->category) {
+        case BINARY_OPERATOR_EXPRESSION_NODE:
+            return evaluateBinaryOpNode(node, activation, value);
+        case UNARY_OPERATOR_EXPRESSION_NODE:
+            return evaluateUnopNode(node, activation, value);
+        default:
+            return false;
+    }
+}
+
+/* The operators are applied in the order the generated code applies them, see evaluateConstantExpression */
+bool evaluateExpressionNode(TreeNodePtr node, Activation* activation, int* value) {
+    if(!countStep(activation)) {
+        return false;
+    }
+
+    int left;
+    if(!evaluateNode(node->subtrees[0], activation, &left)) {
+        return false;
+    }
+    TreeNodePtr relationalOperatorNode = node->subtrees[1];
+    if(relationalOperatorNode == NULL) {
+        *value = left;
+        return true;
+    }
+
+    int right;
+    if(!evaluateBinaryOpNode(node->subtrees[2], activation, &right)) {
+        return false;
+    }
+    switch (relationalOperatorNode->subtrees[0]->category) {
+        case LESS_OR_EQUAL_NODE:
+            *value = left <= right;
+            return true;
+        case LESS_NODE:
+            *value = left < right;
+            return true;
+        case EQUAL_NODE:
+            *value = left == right;
+            return true;
+        case DIFFERENT_NODE:
+            *value = left != right;
+            return true;
+        case GREATER_OR_EQUAL_NODE:
+            *value = left >= right;
+            return true;
+        case GREATER_NODE:
+            *value = left > right;
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool evaluateBinaryOpNode(TreeNodePtr node, Activation* activation, int* value) {
+    if(!countStep(activation)) {
+        return false;
+    }
+
+    int term;
+    if(!evaluateTermNode(node->subtrees[0], activation, &term)) {
+        return false;
+    }
+    TreeNodePtr operatorNode = node->subtrees[1];
+    if(operatorNode == NULL) {
+        *value = term;
+        return true;
+    }
+
+    int rest;
+    return evaluateBinaryOpNode(node->subtrees[2], activation, &rest) &&
+           applyOperator(operatorNode->subtrees[0]->category, term, rest, value);
+}
+
+bool evaluateUnopNode(TreeNodePtr node, Activation* activation, int* value) {
+    if(!countStep(activation)) {
+        return false;
+    }
+
+    int term;
+    if(!evaluateTermNode(node->subtrees[1], activation, &term)) {
+        return false;
+    }
+    switch (node->subtrees[0]->subtrees[0]->category) {
+        case PLUS_NODE:
+            break;
+        case MINUS_NODE:
+            if(term == INT_MIN) {
+                return false;
+            }
+            term = -term;
+            break;
+        case NOT_NODE:
+            term = 1 - term;
+            break;
+        default:
+            return false;
+    }
+
+    TreeNodePtr additiveOperatorNode = node->subtrees[2];
+    if(additiveOperatorNode == NULL) {
+        *value = term;
+        return true;
+    }
+
+    int rest;
+    return evaluateBinaryOpNode(node->subtrees[3], activation, &rest) &&
+           applyOperator(additiveOperatorNode->subtrees[0]->category, term, rest, value);
+}
+
+bool evaluateTermNode(TreeNodePtr node, Activation* activation, int* value) {
+    if(!countStep(activation)) {
+        return false;
+    }
+
+    int factor;
+    if(!evaluateFactorNode(node->subtrees[0], activation, &factor)) {
+        return false;
+    }
+    TreeNodePtr operatorNode = node->subtrees[1];
+    if(operatorNode == NULL) {
+        *value = factor;
+        return true;
+    }
+
+    int rest;
+    return evaluateTermNode(node->subtrees[2], activation, &rest) &&
+           applyOperator(operatorNode->subtrees[0]->category, factor, rest, value);
+}
+
+bool evaluateFactorNode(TreeNodePtr node, Activation* activation, int* value) {
+    TreeNodePtr specificFactorNode = node->subtrees[0];
+    switch (specificFactorNode->category) {
+        case INTEGER_NODE:
+            // the literal was already checked when the body was compiled
+            *value = (int) strtol(specificFactorNode->name, NULL, 10);
+            return true;
+        case VALUE_NODE:
+            return evaluateValueNode(specificFactorNode, activation, value);
+        case FUNCTION_CALL_NODE:
+            return evaluateCallNode(specificFactorNode, activation, value);
+        case EXPRESSION_NODE:
+            return evaluateExpressionNode(specificFactorNode, activation, value);
+        default:
+            return false;
+    }
+}
+
+/* A parameter or variable, read only once assigned, or a constant */
+bool evaluateValueNode(TreeNodePtr node, Activation* activation, int* value) {
+    char* identifier = node->subtrees[0]->name;
+    int local = findLocal(activation->function, identifier);
+    if(local >= 0) {
+        *value = activation->values[local];
+        return activation->assigned[local];
+    }
+
+    SymbolTableEntryPtr entry = findScopeSymbol(activation->function, identifier);
+    *value = entry->description.constantDescriptor->value;
+    return true;
+}
+
+/* The arguments are evaluated in order, like they are pushed */
+bool evaluateCallNode(TreeNodePtr node, Activation* activation, int* value) {
+    SymbolTableEntryPtr entry = findScopeSymbol(activation->function, node->subtrees[0]->name);
+    PureFunctionPtr function = findPureFunction(entry->description.functionDescriptor);
+    if(function == NULL) {
+        return false;
+    }
+
+    int* arguments = malloc((function->parametersCount + 1) * sizeof(int));
+    int count = 0;
+    for (TreeNodePtr argumentNode = node->subtrees[1]; argumentNode != NULL; argumentNode = argumentNode->next) {
+        if(count == function->parametersCount ||
+           !evaluateExpressionNode(argumentNode, activation, &arguments[count])) {
+            free(arguments);
+            return false;
+        }
+        count++;
+    }
+
+    bool evaluated = count == function->parametersCount &&
+                     callPureFunction(function, arguments, activation->evaluation, value);
+    free(arguments);
+    return evaluated;
+}
+
+/*
+ * The arithmetic operators are the constant expressions' ones, "and" and "or" are applied to the booleans 0 and 1 like
+ * MEPA applies them, without short circuit: both operands were evaluated
+ */
+bool applyOperator(NodeCategory operator, int left, int right, int* value) {
+    switch (operator) {
+        case AND_NODE:
+            *value = left != 0 ? right : left;
+            return true;
+        case OR_NODE:
+            *value = left != 0 ? left : right;
+            return true;
+        default: {
+            long long result;
+            if(!applyConstantOperator(operator, left, right, &result)) {
+                return false;
+            }
+            *value = (int) result;
+            return true;
+        }
+    }
+}
+
+bool countStep(Activation* activation) {
+    return ++activation->evaluation->steps <= EVALUATION_STEPS_LIMIT;
+}
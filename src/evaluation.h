@@ -0,0 +1,46 @@
+/**
+ * This module finds the pure functions and evaluates their calls at compile time, so the code generator replaces the
+ * calls passing only constants by the value they return
+ *
+ * A function is selected right after its declaration was compiled, while the symbol table still has its scope, so the
+ * identifiers of its body keep the symbols they were declared with when a call is evaluated inside another function
+ **/
+
+#ifndef EVALUATION_HEADER
+#define EVALUATION_HEADER
+
+#include "tree.h"
+#include "symboltable.h"
+
+typedef struct {
+    SymbolTableEntryPtr functionEntry;
+    TreeNodePtr bodyNode;
+    /* Names of the parameters then the variables of the function, the positions of their values during a call */
+    char** locals;
+    int parametersCount;
+    int localsCount;
+    /* Symbols of the other identifiers used by the body (constants and pure functions), resolved in its own scope */
+    Stack* scope;
+} PureFunction, *PureFunctionPtr;
+
+/*
+ * Selects the function being compiled as pure when its result only depends on its arguments: it returns an integer or
+ * a boolean, receives integers by value, only declares integer and boolean variables and its body only uses them, the
+ * constants and the pure functions (itself included), without arrays, gotos, labels nor nested functions. read and
+ * write are pseudo functions, so they are never called by a pure function.
+ * It must be called before the function's level ends.
+ */
+void selectPureFunction(TreeNodePtr functionNode, SymbolTableEntryPtr functionEntry);
+
+/* The pure function of the given descriptor, NULL if the function isn't pure */
+PureFunctionPtr findPureFunction(FunctionDescriptorPtr functionDescriptor);
+
+/*
+ * Evaluates a call to a pure function by interpreting its body, returns false when the call would not run like MEPA
+ * runs it: a division by zero, a value outside the int range, a variable read before being assigned, a function
+ * ending without a return, or a call taking more than EVALUATION_STEPS_LIMIT steps (nodes evaluated) or nesting more
+ * than EVALUATION_DEPTH_LIMIT calls
+ */
+bool evaluatePureCall(PureFunctionPtr function, int* arguments, int* result);
+
+#endif
@@ -0,0 +1,197 @@
+#include "framelayout.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+/* Statements of the body repeated by a goto, from the label to the goto */
+typedef struct {
+    int firstStatement;
+    int lastStatement;
+} RepeatedStatements, *RepeatedStatementsPtr;
+
+typedef struct {
+    Stack* liveRanges;
+    Stack* repeated;
+    TreeNodePtr bodyNode;
+    /* The statement being searched, the last statement of the body for the nested functions */
+    int statement;
+    bool nestedFunction;
+} RangeSearch;
+
+void addDeclaredRanges(Stack* liveRanges, TreeNodePtr variablesNode);
+bool findRangeUse(TreeNodePtr node, void* context);
+int findLabeledStatement(TreeNodePtr bodyNode, char* label);
+bool widenRange(LiveRangePtr range, Stack* repeated);
+bool livesOverlap(LiveRangePtr range, LiveRangePtr other);
+bool byVariableIdentifier(void* data, void* secondParam);
+
+static const bool usesFilter[NODE_CATEGORIES_COUNT] = {
+    [IDENTIFIER_NODE] = true,
+    [GOTO_NODE] = true
+};
+
+Stack* findLiveRanges(TreeNodePtr blockNode) {
+    Stack* liveRanges = newStack();
+    addDeclaredRanges(liveRanges, blockNode->subtrees[2]);
+
+    RangeSearch search = {
+        .liveRanges = liveRanges,
+        .repeated = newStack(),
+        .bodyNode = blockNode->subtrees[4],
+        .statement = 0,
+        .nestedFunction = false
+    };
+    TreeVisitor visitor = {
+        .preVisit = findRangeUse,
+        .postVisit = NULL,
+        .categoryFilter = usesFilter,
+        .context = &search
+    };
+
+    for (TreeNodePtr statementNode = search.bodyNode->subtrees[0]; statementNode != NULL;
+         statementNode = statementNode->next) {
+        visitSubtree(statementNode, &visitor);
+        search.statement++;
+    }
+
+    if(blockNode->subtrees[3] != NULL) {
+        search.statement--;
+        search.nestedFunction = true;
+        visitSubtree(blockNode->subtrees[3], &visitor);
+    }
+
+    // a widened range may overlap other repeated statements
+    for (LinkedNode* node = liveRanges->top; node != NULL; node = node->next) {
+        while (widenRange(node->data, search.repeated));
+    }
+
+    while (search.repeated->top != NULL) {
+        free(pop(search.repeated));
+    }
+    free(search.repeated);
+    return liveRanges;
+}
+
+void addDeclaredRanges(Stack* liveRanges, TreeNodePtr variablesNode) {
+    if(variablesNode == NULL) {
+        return;
+    }
+
+    for (TreeNodePtr declarationNode = variablesNode->subtrees[0]; declarationNode != NULL;
+         declarationNode = declarationNode->next) {
+        for (TreeNodePtr identifierNode = declarationNode->subtrees[0]; identifierNode != NULL;
+             identifierNode = identifierNode->next) {
+            LiveRangePtr range = malloc(sizeof(LiveRange));
+            range->identifier = identifierNode->name;
+            range->firstStatement = INT_MAX;
+            range->lastStatement = -1;
+            range->displacement = 0;
+            range->size = 0;
+            range->placed = false;
+            push(liveRanges, range);
+        }
+    }
+}
+
+bool findRangeUse(TreeNodePtr node, void* context) {
+    RangeSearch* search = (RangeSearch*) context;
+
+    if(node->category == GOTO_NODE) {
+        int labeledStatement = findLabeledStatement(search->bodyNode, node->subtrees[0]->name);
+        if(labeledStatement >= 0 && labeledStatement <= search->statement) {
+            RepeatedStatementsPtr repeated = malloc(sizeof(RepeatedStatements));
+            repeated->firstStatement = labeledStatement;
+            repeated->lastStatement = search->statement;
+            push(search->repeated, repeated);
+        }
+        return false;
+    }
+
+    LiveRangePtr range = find(search->liveRanges, node->name, byVariableIdentifier);
+    if(range != NULL) {
+        int firstStatement = search->nestedFunction ? 0 : search->statement;
+        if(firstStatement < range->firstStatement) {
+            range->firstStatement = firstStatement;
+        }
+        if(search->statement > range->lastStatement) {
+            range->lastStatement = search->statement;
+        }
+    }
+    return true;
+}
+
+/* Index of the body's statement with the given label, -1 if the label isn't the body's own */
+int findLabeledStatement(TreeNodePtr bodyNode, char* label) {
+    int index = 0;
+    for (TreeNodePtr statementNode = bodyNode->subtrees[0]; statementNode != NULL;
+         statementNode = statementNode->next) {
+        TreeNodePtr labelNode = statementNode->subtrees[0];
+        if(labelNode->category == LABEL_NODE && strcmp(labelNode->subtrees[0]->name, label) == 0) {
+            return index;
+        }
+        index++;
+    }
+    return -1;
+}
+
+/* Extends the range over the repeated statements it overlaps, returns true if it changed */
+bool widenRange(LiveRangePtr range, Stack* repeated) {
+    bool widened = false;
+    for (LinkedNode* node = repeated->top; node != NULL; node = node->next) {
+        RepeatedStatementsPtr statements = node->data;
+        if(range->firstStatement > statements->lastStatement || range->lastStatement < statements->firstStatement) {
+            continue;
+        }
+        if(statements->firstStatement < range->firstStatement) {
+            range->firstStatement = statements->firstStatement;
+            widened = true;
+        }
+        if(statements->lastStatement > range->lastStatement) {
+            range->lastStatement = statements->lastStatement;
+            widened = true;
+        }
+    }
+    return widened;
+}
+
+int placeVariable(Stack* liveRanges, char* identifier, int size) {
+    LiveRangePtr range = find(liveRanges, identifier, byVariableIdentifier);
+    int displacement = 0;
+
+    // first fit: moves past the placed variables it would overlap until none is left
+    bool moved = true;
+    while (moved) {
+        moved = false;
+        for (LinkedNode* node = liveRanges->top; node != NULL; node = node->next) {
+            LiveRangePtr other = node->data;
+            if(other->placed && livesOverlap(range, other) &&
+               displacement < other->displacement + other->size && other->displacement < displacement + size) {
+                displacement = other->displacement + other->size;
+                moved = true;
+            }
+        }
+    }
+
+    range->displacement = displacement;
+    range->size = size;
+    range->placed = true;
+    return displacement;
+}
+
+/* Ranges of variables no statement uses overlap no other range, they are never read nor written */
+bool livesOverlap(LiveRangePtr range, LiveRangePtr other) {
+    return range->firstStatement <= other->lastStatement && other->firstStatement <= range->lastStatement;
+}
+
+void freeLiveRanges(Stack* liveRanges) {
+    while (liveRanges->top != NULL) {
+        free(pop(liveRanges));
+    }
+    free(liveRanges);
+}
+
+bool byVariableIdentifier(void* data, void* secondParam) {
+    LiveRangePtr range = (LiveRangePtr) data;
+    return strcmp(range->identifier, (char*) secondParam) == 0;
+}
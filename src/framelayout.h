@@ -0,0 +1,43 @@
+/**
+ * This module lays out the variables of an activation record, so variables whose values are never needed at the same
+ * time share their positions
+ *
+ * Live ranges are computed on the statements of the function's body (a loop is a single statement), identifiers are
+ * matched by name, so any occurrence of a variable's name counts as a use
+ **/
+
+#ifndef FRAME_LAYOUT_HEADER
+#define FRAME_LAYOUT_HEADER
+
+#include "tree.h"
+
+typedef struct {
+    char* identifier;
+    /* Indices of the first and last statements of the body using the variable, first > last if none does */
+    int firstStatement;
+    int lastStatement;
+    /* Filled by placeVariable */
+    int displacement;
+    int size;
+    bool placed;
+} LiveRange, *LiveRangePtr;
+
+/*
+ * Finds the live ranges of the variables declared by the block. The ranges are widened conservatively:
+ * - a goto back to a label of the body repeats the statements in between, like a loop, so a range overlapping them
+ *   covers all of them
+ * - variables used by nested functions are live in the whole body, the functions may be called by any statement, and
+ *   gotos from nested functions to a label of the body repeat the statements from the label on
+ * Variables passed by reference need no special case: their address can't outlive the call, in the same statement.
+ */
+Stack* findLiveRanges(TreeNodePtr blockNode);
+
+/*
+ * Places a variable at the lowest displacement where it doesn't overlap the variables already placed whose live ranges
+ * overlap its own, and returns that displacement
+ */
+int placeVariable(Stack* liveRanges, char* identifier, int size);
+
+void freeLiveRanges(Stack* liveRanges);
+
+#endif
@@ -0,0 +1,172 @@
+#include "inlining.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Largest body inlined, in tree nodes: up to a few simple statements (ex: "return 2*a;" has 14 nodes, a conditional
+ * returning one of two values 32), so each call site doesn't grow much more than the call overhead it saves
+ */
+#define INLINE_SIZE_LIMIT 80
+
+typedef struct {
+    InlineCandidatePtr candidate;
+    int size;
+    bool rejected;
+} CandidateSearch;
+
+bool inspectInlineBody(TreeNodePtr node, void* context);
+bool isInlinedCall(TreeNodePtr callNode);
+void addScopeSymbol(InlineCandidatePtr candidate, char* identifier);
+TreeNodePtr findFinalReturn(TreeNodePtr bodyNode);
+void freeInlineCandidate(InlineCandidatePtr candidate);
+bool byFunctionDescriptor(void* data, void* secondParam);
+bool byIdentifier(void* data, void* secondParam);
+
+/* The selected functions, the last one declared on top */
+Stack* inlineCandidates = NULL;
+
+void selectInlineCandidate(TreeNodePtr functionNode, SymbolTableEntryPtr functionEntry) {
+    FunctionDescriptorPtr functionDescriptor = functionEntry->description.functionDescriptor;
+    TreeNodePtr blockNode = functionNode->subtrees[1];
+    if(blockNode->subtrees[0] != NULL || blockNode->subtrees[3] != NULL ||
+       (functionDescriptor->returnType != NULL && functionDescriptor->returnType->size != 1)) {
+        return;
+    }
+    for (ParameterDescriptorsListPtr parameter = functionDescriptor->parameters; parameter != NULL;
+         parameter = parameter->next) {
+        if(parameter->descriptor->parameterPassage == FUNCTION_PARAMETER) {
+            return;
+        }
+    }
+
+    InlineCandidatePtr candidate = malloc(sizeof(InlineCandidate));
+    candidate->functionEntry = functionEntry;
+    candidate->bodyNode = blockNode->subtrees[4];
+    candidate->scope = newStack();
+    candidate->finalReturn = findFinalReturn(candidate->bodyNode);
+    candidate->returns = 0;
+
+    CandidateSearch search = {
+        .candidate = candidate,
+        .size = 0,
+        .rejected = false
+    };
+    TreeVisitor visitor = {
+        .preVisit = inspectInlineBody,
+        .postVisit = NULL,
+        .categoryFilter = NULL,
+        .context = &search
+    };
+    visitSubtree(candidate->bodyNode, &visitor);
+
+    if(search.rejected) {
+        freeInlineCandidate(candidate);
+        return;
+    }
+
+    if(inlineCandidates == NULL) {
+        inlineCandidates = newStack();
+    }
+    push(inlineCandidates, candidate);
+}
+
+InlineCandidatePtr findInlineCandidate(FunctionDescriptorPtr functionDescriptor) {
+    if(inlineCandidates == NULL) {
+        return NULL;
+    }
+    return (InlineCandidatePtr) find(inlineCandidates, functionDescriptor, byFunctionDescriptor);
+}
+
+bool isInlinedLocal(InlineCandidatePtr candidate, SymbolTableEntryPtr entry) {
+    return entry->level == candidate->functionEntry->level &&
+           (entry->category == VARIABLE_SYMBOL || entry->category == PARAMETER_SYMBOL);
+}
+
+bool inspectInlineBody(TreeNodePtr node, void* context) {
+    CandidateSearch* search = (CandidateSearch*) context;
+
+    search->size++;
+    switch (node->category) {
+        case IDENTIFIER_NODE:
+            addScopeSymbol(search->candidate, node->name);
+            break;
+        case FUNCTION_CALL_NODE:
+            search->rejected = search->rejected || !isInlinedCall(node);
+            break;
+        case RETURN_NODE:
+            search->candidate->returns++;
+            break;
+        case GOTO_NODE:
+            search->rejected = true;
+            break;
+        default:
+            break;
+    }
+
+    if(search->size > INLINE_SIZE_LIMIT) {
+        search->rejected = true;
+    }
+    return !search->rejected;
+}
+
+bool isInlinedCall(TreeNodePtr callNode) {
+    SymbolTableEntryPtr functionEntry = findIdentifier(callNode->subtrees[0]->name);
+    if(functionEntry == NULL) {
+        return false;
+    }
+
+    switch (functionEntry->category) {
+        case PSEUDO_FUNCTION_SYMBOL:
+            return true;
+        case FUNCTION_SYMBOL:
+            return findInlineCandidate(functionEntry->description.functionDescriptor) != NULL;
+        default:
+            return false;
+    }
+}
+
+void addScopeSymbol(InlineCandidatePtr candidate, char* identifier) {
+    if(find(candidate->scope, identifier, byIdentifier) != NULL) {
+        return;
+    }
+
+    SymbolTableEntryPtr entry = findIdentifier(identifier);
+    if(entry != NULL) {
+        push(candidate->scope, entry);
+    }
+}
+
+/* The body was already compiled, so the return statement is known to be valid */
+TreeNodePtr findFinalReturn(TreeNodePtr bodyNode) {
+    TreeNodePtr statementNode = bodyNode->subtrees[0];
+    if(statementNode == NULL) {
+        return NULL;
+    }
+    while (statementNode->next != NULL) {
+        statementNode = statementNode->next;
+    }
+
+    // the function has no labels, so its statements are unlabeled
+    TreeNodePtr unlabeledStatementNode = statementNode->subtrees[0];
+    if(unlabeledStatementNode != NULL && unlabeledStatementNode->category == RETURN_NODE) {
+        return unlabeledStatementNode;
+    }
+    return NULL;
+}
+
+void freeInlineCandidate(InlineCandidatePtr candidate) {
+    while (pop(candidate->scope) != NULL);
+    free(candidate->scope);
+    free(candidate);
+}
+
+bool byFunctionDescriptor(void* data, void* secondParam) {
+    InlineCandidatePtr candidate = (InlineCandidatePtr) data;
+    return candidate->functionEntry->description.functionDescriptor == (FunctionDescriptorPtr) secondParam;
+}
+
+bool byIdentifier(void* data, void* secondParam) {
+    SymbolTableEntryPtr entry = (SymbolTableEntryPtr) data;
+    return strcmp(entry->identifier, (char*) secondParam) == 0;
+}
@@ -0,0 +1,49 @@
+/**
+ * This module selects the functions the code generator inlines at their call sites
+ *
+ * A function is selected right after its declaration was compiled, while the symbol table still has its scope, so the
+ * identifiers of its body keep the symbols they were declared with when the body is compiled inside another function
+ **/
+
+#ifndef INLINING_HEADER
+#define INLINING_HEADER
+
+#include "tree.h"
+#include "symboltable.h"
+
+typedef struct {
+    SymbolTableEntryPtr functionEntry;
+    TreeNodePtr bodyNode;
+    /* Symbols of the identifiers used by the body, resolved in the function's own scope */
+    Stack* scope;
+    /* The return statement ending the body, NULL if the body doesn't end with one */
+    TreeNodePtr finalReturn;
+    /* Number of return statements of the body, the final one included */
+    int returns;
+} InlineCandidate, *InlineCandidatePtr;
+
+typedef struct {
+    InlineCandidatePtr candidate;
+    /* Filled by the code generator: the temporary keeping the result and the label ending the body, -1 if not needed */
+    int resultDisplacement;
+    int exitLabel;
+} InlineExpansion, *InlineExpansionPtr;
+
+/*
+ * Selects the function being compiled for inlining when it is small (see INLINE_SIZE_LIMIT) and its body can be
+ * compiled in any caller's activation record: it has no labels nor nested functions, no gotos, no function parameters
+ * and doesn't return an array.
+ * The call graph is checked along the way: its body may only call the pseudo functions and functions already selected.
+ * Since a function can only call itself, the enclosing functions or the ones declared before it, functions calling
+ * themselves (directly or through an enclosing one) are never selected, nor functions calling function parameters.
+ * It must be called before the function's level ends.
+ */
+void selectInlineCandidate(TreeNodePtr functionNode, SymbolTableEntryPtr functionEntry);
+
+/* The candidate of the given function, NULL if it isn't inlined */
+InlineCandidatePtr findInlineCandidate(FunctionDescriptorPtr functionDescriptor);
+
+/* Checks if a symbol of the candidate's scope is one of its own parameters or variables */
+bool isInlinedLocal(InlineCandidatePtr candidate, SymbolTableEntryPtr entry);
+
+#endif
@@ -0,0 +1,1099 @@
+#include "loops.h"
+
+#include <stdlib.h>
+#include <limits.h>
+
+#include "codegen.h"
+#include "options.h"
+
+/**
+ * Loop effects
+ **/
+
+bool recordEffects(TreeNodePtr node, void* context);
+void recordModification(LoopEffectsPtr effects, TreeNodePtr valueNode);
+void recordCallEffects(LoopEffectsPtr effects, TreeNodePtr callNode);
+void recordArgumentsEffects(LoopEffectsPtr effects, TreeNodePtr argumentNode, ParameterDescriptorsListPtr parameters);
+int countModifications(LoopEffectsPtr effects, SymbolTableEntryPtr entry);
+
+static const bool effectsFilter[NODE_CATEGORIES_COUNT] = {
+    [ASSIGNMENT_NODE] = true,
+    [FUNCTION_CALL_NODE] = true
+};
+
+LoopEffectsPtr findLoopEffects(TreeNodePtr whileNode) {
+    LoopEffectsPtr effects = malloc(sizeof(LoopEffects));
+    effects->modifiedEntries = newMap();
+    effects->nonLocalsModified = false;
+    effects->allModified = false;
+
+    TreeVisitor visitor = {
+        .preVisit = recordEffects,
+        .postVisit = NULL,
+        .categoryFilter = effectsFilter,
+        .context = effects
+    };
+    visitSubtree(whileNode, &visitor);
+
+    return effects;
+}
+
+void freeLoopEffects(LoopEffectsPtr effects) {
+    freeMap(effects->modifiedEntries, free);
+    free(effects);
+}
+
+bool isInvariantEntry(SymbolTableEntryPtr entry, LoopEffectsPtr effects) {
+    switch (entry->category) {
+        case CONSTANT_SYMBOL:
+            return true;
+        case VARIABLE_SYMBOL:
+            break;
+        case PARAMETER_SYMBOL:
+            if(entry->description.parameterDescriptor->parameterPassage == FUNCTION_PARAMETER) {
+                return false;
+            }
+            break;
+        default:
+            return false;
+    }
+
+    if(effects->allModified || (effects->nonLocalsModified && !isLocalEntry(entry))) {
+        return false;
+    }
+    return mapGet(effects->modifiedEntries, entry) == NULL;
+}
+
+/* Number of assignments, reads and arguments by reference of the entry inside the loop */
+int countModifications(LoopEffectsPtr effects, SymbolTableEntryPtr entry) {
+    int* modifications = mapGet(effects->modifiedEntries, entry);
+    return modifications != NULL ? *modifications : 0;
+}
+
+bool recordEffects(TreeNodePtr node, void* context) {
+    LoopEffectsPtr effects = (LoopEffectsPtr) context;
+    if(node->category == ASSIGNMENT_NODE) {
+        recordModification(effects, node->subtrees[0]);
+    } else {
+        recordCallEffects(effects, node);
+    }
+    return true;
+}
+
+void recordModification(LoopEffectsPtr effects, TreeNodePtr valueNode) {
+    SymbolTableEntryPtr entry = findNodeIdentifier(valueNode);
+    if(entry == NULL || (entry->category != VARIABLE_SYMBOL && entry->category != PARAMETER_SYMBOL)) {
+        return;
+    }
+
+    int* modifications = mapGet(effects->modifiedEntries, entry);
+    if(modifications == NULL) {
+        modifications = calloc(1, sizeof(int));
+        mapPut(effects->modifiedEntries, entry, modifications);
+    }
+    (*modifications)++;
+    // a variable of an enclosing function or a parameter by reference may be an alias of any other one of them
+    if(!isLocalEntry(entry)) {
+        effects->nonLocalsModified = true;
+    }
+}
+
+void recordCallEffects(LoopEffectsPtr effects, TreeNodePtr callNode) {
+    SymbolTableEntryPtr functionEntry = findNodeIdentifier(callNode);
+    if(functionEntry == NULL) {
+        return;
+    }
+
+    TreeNodePtr argumentNode = callNode->subtrees[1];
+    switch (functionEntry->category) {
+        case PSEUDO_FUNCTION_SYMBOL:
+            if(functionEntry->description.pseudoFunction == READ) {
+                for (TreeNodePtr current = argumentNode; current != NULL; current = current->next) {
+                    recordModification(effects, getSingleValueNode(current));
+                }
+            }
+            break;
+        case FUNCTION_SYMBOL:
+            // functions declared inside the current one see its variables, the other ones only see the non locals
+            if(functionEntry->level > getFunctionLevel()) {
+                effects->allModified = true;
+            }
+            effects->nonLocalsModified = true;
+            recordArgumentsEffects(effects, argumentNode, functionEntry->description.functionDescriptor->parameters);
+            break;
+        case PARAMETER_SYMBOL: {
+            // a function parameter was declared outside the current function, it can't see its variables
+            TypeDescriptorPtr type = functionEntry->description.parameterDescriptor->type;
+            if(type->category == FUNCTION_TYPE) {
+                effects->nonLocalsModified = true;
+                recordArgumentsEffects(effects, argumentNode, type->description.functionTypeDescriptor->parameters);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void recordArgumentsEffects(LoopEffectsPtr effects, TreeNodePtr argumentNode, ParameterDescriptorsListPtr parameters) {
+    TreeNodePtr currentArgument = argumentNode;
+    ParameterDescriptorsListPtr currentParameter = parameters;
+    while (currentArgument != NULL && currentParameter != NULL) {
+        switch (currentParameter->descriptor->parameterPassage) {
+            case VARIABLE_PARAMETER:
+                recordModification(effects, getSingleValueNode(currentArgument));
+                break;
+            case FUNCTION_PARAMETER:
+                // the function may be declared inside the current one
+                effects->allModified = true;
+                break;
+            case VALUE_PARAMETER:
+                break;
+        }
+        currentArgument = currentArgument->next;
+        currentParameter = currentParameter->next;
+    }
+}
+
+/*
+ * Resolves the identifier of a value or function call node, the nodes are not validated: semantic errors are reported
+ * by the code generator when it reaches them
+ */
+SymbolTableEntryPtr findNodeIdentifier(TreeNodePtr node) {
+    if(node == NULL || node->subtrees[0] == NULL || node->subtrees[0]->category != IDENTIFIER_NODE) {
+        return NULL;
+    }
+    return findIdentifier(node->subtrees[0]->name);
+}
+
+/* Variables and parameters by value of the current function, nothing outside the activation record aliases them */
+bool isLocalEntry(SymbolTableEntryPtr entry) {
+    if(entry->level != getFunctionLevel()) {
+        return false;
+    }
+    return entry->category == VARIABLE_SYMBOL ||
+           (entry->category == PARAMETER_SYMBOL &&
+            entry->description.parameterDescriptor->parameterPassage == VALUE_PARAMETER);
+}
+
+/**
+ * Loop invariants
+ **/
+
+typedef struct {
+    LoopEffectsPtr effects;
+    Map* hoisted;
+    /* Uses of the induction variables' addresses, mapped to their addresses */
+    Map* inductionAddresses;
+    Stack* found;
+    /* Reads of variables and parameters by the expressions checked so far, constants are not counted */
+    int variableReads;
+} InvariantsSearch;
+
+void searchIterationExpression(TreeNodePtr node, void* context);
+void searchIterationTarget(TreeNodePtr valueNode, void* context);
+void searchExpression(InvariantsSearch* search, TreeNodePtr node);
+void searchArrayPrefix(InvariantsSearch* search, TreeNodePtr valueNode);
+void addInvariant(InvariantsSearch* search, LoopInvariantCategory category, TreeNodePtr node, int subscripts);
+
+bool isInvariantExpression(InvariantsSearch* search, TreeNodePtr node, int* cost);
+bool isInvariantValue(InvariantsSearch* search, TreeNodePtr valueNode, int* cost);
+
+bool isInductionAddress(Map* inductionAddresses, TreeNodePtr valueNode);
+
+Stack* findLoopInvariants(TreeNodePtr whileNode, Map* hoistedInvariants, Stack* inductionVariables) {
+    InvariantsSearch search;
+    search.effects = findLoopEffects(whileNode);
+    search.hoisted = hoistedInvariants;
+    search.inductionAddresses = newMap();
+    for (LinkedNode* current = inductionVariables->top; current != NULL; current = current->next) {
+        InductionVariablePtr inductionVariable = (InductionVariablePtr) current->data;
+        for (LinkedNode* address = inductionVariable->addresses->top; address != NULL; address = address->next) {
+            for (LinkedNode* use = ((InductionAddressPtr) address->data)->uses->top; use != NULL; use = use->next) {
+                mapPut(search.inductionAddresses, use->data, address->data);
+            }
+        }
+    }
+    search.found = newStack();
+    search.variableReads = 0;
+
+    // the condition is evaluated before the invariants in the rotated loop, so any part of it can be hoisted
+    IterationVisitor visitor = {
+        .expression = searchIterationExpression,
+        .target = searchIterationTarget,
+        .context = &search
+    };
+    visitIteration(whileNode, &visitor);
+
+    freeLoopEffects(search.effects);
+    freeMap(search.inductionAddresses, NULL);
+
+    // the search stack has the last invariant found on its top
+    Stack* invariants = newStack();
+    while (search.found->size > 0) {
+        push(invariants, pop(search.found));
+    }
+    free(search.found);
+    return invariants;
+}
+
+LoopInvariantPtr findHoistedInvariant(Map* hoistedInvariants, TreeNodePtr node) {
+    return (LoopInvariantPtr) mapGet(hoistedInvariants, node);
+}
+
+void searchIterationExpression(TreeNodePtr node, void* context) {
+    searchExpression((InvariantsSearch*) context, node);
+}
+
+void searchIterationTarget(TreeNodePtr valueNode, void* context) {
+    searchArrayPrefix((InvariantsSearch*) context, valueNode);
+}
+
+/* Searches the expression top down, so only the largest invariant subexpressions are hoisted */
+void searchExpression(InvariantsSearch* search, TreeNodePtr node) {
+    if(node == NULL || findHoistedInvariant(search->hoisted, node) != NULL) {
+        return;
+    }
+
+    int cost = 0;
+    switch (node->category) {
+        case EXPRESSION_NODE:
+        case BINARY_OPERATOR_EXPRESSION_NODE:
+        case UNARY_OPERATOR_EXPRESSION_NODE:
+        case TERM_NODE:
+        case FACTOR_NODE:
+            if(isInvariantExpression(search, node, &cost) && cost >= 2) {
+                addInvariant(search, INVARIANT_VALUE, node, 0);
+                return;
+            }
+            break;
+        default:
+            return;
+    }
+
+    switch (node->category) {
+        case EXPRESSION_NODE:
+        case BINARY_OPERATOR_EXPRESSION_NODE:
+        case TERM_NODE:
+            searchExpression(search, node->subtrees[0]);
+            searchExpression(search, node->subtrees[2]);
+            break;
+        case UNARY_OPERATOR_EXPRESSION_NODE:
+            searchExpression(search, node->subtrees[1]);
+            searchExpression(search, node->subtrees[3]);
+            break;
+        default: {
+            // factors: the arguments of function calls are not searched, the call may leave the iteration first
+            TreeNodePtr specificFactorNode = node->subtrees[0];
+            if(specificFactorNode->category == VALUE_NODE) {
+                searchArrayPrefix(search, specificFactorNode);
+            } else {
+                searchExpression(search, specificFactorNode);
+            }
+        }
+    }
+}
+
+/*
+ * The address of an array element only depends on the subscripts, even if the array is modified in the loop, so the
+ * address selected by the leading invariant subscripts is hoisted when at least one of them isn't a constant
+ */
+void searchArrayPrefix(InvariantsSearch* search, TreeNodePtr valueNode) {
+    if(valueNode == NULL || valueNode->category != VALUE_NODE) {
+        return;
+    }
+
+    // the subscripts of an induction variable address are only evaluated before the loop
+    if(isInductionAddress(search->inductionAddresses, valueNode)) {
+        return;
+    }
+
+    TreeNodePtr indexNode = valueNode->subtrees[1];
+    SymbolTableEntryPtr entry = findNodeIdentifier(valueNode);
+    TypeDescriptorPtr type = entry == NULL ? NULL : getEntryType(entry);
+    if(type != NULL && findHoistedInvariant(search->hoisted, valueNode) == NULL) {
+        int subscripts = 0;
+        bool readsVariables = false;
+        while (indexNode != NULL && type->category == ARRAY_TYPE) {
+            int cost = 0;
+            int variableReads = search->variableReads;
+            if(!isInvariantExpression(search, indexNode->subtrees[0], &cost)) {
+                break;
+            }
+            readsVariables = readsVariables || search->variableReads > variableReads;
+            type = type->description.arrayDescriptor->elementType;
+            indexNode = indexNode->next;
+            subscripts++;
+        }
+
+        if(readsVariables) {
+            addInvariant(search, INVARIANT_ARRAY_PREFIX, valueNode, subscripts);
+        } else {
+            indexNode = valueNode->subtrees[1];
+        }
+    }
+
+    for (; indexNode != NULL; indexNode = indexNode->next) {
+        searchExpression(search, indexNode->subtrees[0]);
+    }
+}
+
+void addInvariant(InvariantsSearch* search, LoopInvariantCategory category, TreeNodePtr node, int subscripts) {
+    LoopInvariantPtr invariant = malloc(sizeof(LoopInvariant));
+    invariant->category = category;
+    invariant->node = node;
+    invariant->subscripts = subscripts;
+    invariant->displacement = -1;
+    invariant->type = NULL;
+    push(search->found, invariant);
+}
+
+/*
+ * Checks if the single word expression rooted at node doesn't change in the loop and adds the number of instructions
+ * evaluating it to cost
+ */
+bool isInvariantExpression(InvariantsSearch* search, TreeNodePtr node, int* cost) {
+    if(findHoistedInvariant(search->hoisted, node) != NULL) {
+        *cost += 1;
+        return true;
+    }
+
+    switch (node->category) {
+        case EXPRESSION_NODE:
+        case BINARY_OPERATOR_EXPRESSION_NODE:
+        case TERM_NODE:
+            if(node->subtrees[1] == NULL) {
+                return isInvariantExpression(search, node->subtrees[0], cost);
+            }
+            *cost += 1;
+            return isInvariantExpression(search, node->subtrees[0], cost) &&
+                   isInvariantExpression(search, node->subtrees[2], cost);
+        case UNARY_OPERATOR_EXPRESSION_NODE:
+            if(node->subtrees[0]->subtrees[0]->category != PLUS_NODE) {
+                *cost += 1;
+            }
+            if(!isInvariantExpression(search, node->subtrees[1], cost)) {
+                return false;
+            }
+            if(node->subtrees[2] == NULL) {
+                return true;
+            }
+            *cost += 1;
+            return isInvariantExpression(search, node->subtrees[3], cost);
+        case FACTOR_NODE: {
+            TreeNodePtr specificFactorNode = node->subtrees[0];
+            switch (specificFactorNode->category) {
+                case VALUE_NODE:
+                    return isInvariantValue(search, specificFactorNode, cost);
+                case INTEGER_NODE:
+                    *cost += 1;
+                    return true;
+                case EXPRESSION_NODE:
+                    return isInvariantExpression(search, specificFactorNode, cost);
+                default:
+                    return false;
+            }
+        }
+        default:
+            return false;
+    }
+}
+
+bool isInvariantValue(InvariantsSearch* search, TreeNodePtr valueNode, int* cost) {
+    SymbolTableEntryPtr entry = findNodeIdentifier(valueNode);
+    if(entry == NULL || !isInvariantEntry(entry, search->effects)) {
+        return false;
+    }
+
+    if(entry->category == CONSTANT_SYMBOL) {
+        *cost += 1;
+        return valueNode->subtrees[1] == NULL;
+    }
+    search->variableReads++;
+
+    TypeDescriptorPtr type = getEntryType(entry);
+    TreeNodePtr indexNode = valueNode->subtrees[1];
+    if(indexNode != NULL) {
+        // the base address and the final load
+        *cost += 2;
+    } else {
+        *cost += 1;
+    }
+    for (; indexNode != NULL; indexNode = indexNode->next) {
+        if(type->category != ARRAY_TYPE || !isInvariantExpression(search, indexNode->subtrees[0], cost)) {
+            return false;
+        }
+        // the element is indexed by its size
+        *cost += 1;
+        type = type->description.arrayDescriptor->elementType;
+    }
+
+    return type->size == 1;
+}
+
+/* The type of a variable or parameter, NULL for the other entries and for function parameters */
+TypeDescriptorPtr getEntryType(SymbolTableEntryPtr entry) {
+    switch (entry->category) {
+        case VARIABLE_SYMBOL:
+            return entry->description.variableDescriptor->type;
+        case PARAMETER_SYMBOL:
+            if(entry->description.parameterDescriptor->parameterPassage == FUNCTION_PARAMETER) {
+                return NULL;
+            }
+            return entry->description.parameterDescriptor->type;
+        default:
+            return NULL;
+    }
+}
+
+bool isInductionAddress(Map* inductionAddresses, TreeNodePtr valueNode) {
+    return inductionAddresses != NULL && mapGet(inductionAddresses, valueNode) != NULL;
+}
+
+/**
+ * Induction variables
+ **/
+
+/* Instructions updating the temporary of an address each time its induction variable is updated */
+#define ADDRESS_BUMP_COST 4
+
+typedef struct {
+    LoopEffectsPtr effects;
+    Stack* inductionVariables;
+} UpdatesSearch;
+
+typedef struct {
+    InvariantsSearch invariants;
+    InductionVariablePtr inductionVariable;
+    /* Array value nodes evaluated in every iteration, mapped to themselves */
+    Map* alwaysEvaluated;
+} AddressesSearch;
+
+bool recordInductionUpdate(TreeNodePtr node, void* context);
+void findInductionAddresses(TreeNodePtr whileNode, InductionVariablePtr inductionVariable, LoopEffectsPtr effects,
+                            Map* hoistedInvariants);
+void collectIterationExpression(TreeNodePtr node, void* context);
+void collectIterationTarget(TreeNodePtr valueNode, void* context);
+bool collectArrayValue(TreeNodePtr node, void* context);
+bool recordInductionAddress(TreeNodePtr node, void* context);
+bool isInductionSubscript(AddressesSearch* search, TreeNodePtr expressionNode, int* constant);
+bool byAddressNode(void* data, void* secondParam);
+
+static const bool assignmentsFilter[NODE_CATEGORIES_COUNT] = {
+    [ASSIGNMENT_NODE] = true
+};
+
+static const bool valuesFilter[NODE_CATEGORIES_COUNT] = {
+    [VALUE_NODE] = true
+};
+
+Stack* findInductionVariables(TreeNodePtr whileNode, Map* hoistedInvariants) {
+    UpdatesSearch search;
+    search.effects = findLoopEffects(whileNode);
+    search.inductionVariables = newStack();
+
+    if(!search.effects->allModified) {
+        TreeVisitor visitor = {
+            .preVisit = recordInductionUpdate,
+            .postVisit = NULL,
+            .categoryFilter = assignmentsFilter,
+            .context = &search
+        };
+        visitSubtree(whileNode, &visitor);
+    }
+
+    Stack* inductionVariables = newStack();
+    while (search.inductionVariables->size > 0) {
+        InductionVariablePtr inductionVariable = pop(search.inductionVariables);
+        findInductionAddresses(whileNode, inductionVariable, search.effects, hoistedInvariants);
+        if(inductionVariable->addresses->size > 0) {
+            push(inductionVariables, inductionVariable);
+        } else {
+            freeInductionVariable(inductionVariable);
+        }
+    }
+    free(search.inductionVariables);
+    freeLoopEffects(search.effects);
+    return inductionVariables;
+}
+
+InductionVariablePtr findInductionUpdate(Map* inductionUpdates, TreeNodePtr assignmentNode) {
+    return (InductionVariablePtr) mapGet(inductionUpdates, assignmentNode);
+}
+
+void activateInductionVariable(Map* inductionUpdates, InductionVariablePtr inductionVariable, bool active) {
+    mapPut(inductionUpdates, inductionVariable->updateNode, active ? inductionVariable : NULL);
+}
+
+void freeInductionVariable(InductionVariablePtr inductionVariable) {
+    while (inductionVariable->addresses->size > 0) {
+        InductionAddressPtr address = pop(inductionVariable->addresses);
+        while (pop(address->uses) != NULL);
+        free(address->uses);
+        free(address);
+    }
+    free(inductionVariable->addresses);
+    free(inductionVariable);
+}
+
+/* Records the assignments "i = i + c", "i = c + i" and "i = i - c" of a local integer variable modified only there */
+bool recordInductionUpdate(TreeNodePtr node, void* context) {
+    UpdatesSearch* search = (UpdatesSearch*) context;
+
+    TreeNodePtr targetNode = node->subtrees[0];
+    SymbolTableEntryPtr entry = findNodeIdentifier(targetNode);
+    if(entry == NULL || targetNode->subtrees[1] != NULL || !isLocalEntry(entry) ||
+       !equivalentTypes(getEntryType(entry), getSymbolTable()->integerTypeDescriptor) ||
+       countModifications(search->effects, entry) != 1) {
+        return true;
+    }
+
+    int step;
+    TreeNodePtr valueNode = getSingleValueNode(splitSubscript(node->subtrees[1], true, &step));
+    if(step == 0 || valueNode == NULL || valueNode->subtrees[1] != NULL || findNodeIdentifier(valueNode) != entry) {
+        return true;
+    }
+
+    InductionVariablePtr inductionVariable = malloc(sizeof(InductionVariable));
+    inductionVariable->entry = entry;
+    inductionVariable->updateNode = node;
+    inductionVariable->step = step;
+    inductionVariable->addresses = newStack();
+    push(search->inductionVariables, inductionVariable);
+    return true;
+}
+
+/*
+ * Every use of an address is replaced by a single load of its temporary, a use evaluated in every iteration is weighted
+ * twice a use in a conditional branch or nested loop
+ */
+void findInductionAddresses(TreeNodePtr whileNode, InductionVariablePtr inductionVariable, LoopEffectsPtr effects,
+                            Map* hoistedInvariants) {
+    AddressesSearch search;
+    search.invariants.effects = effects;
+    search.invariants.hoisted = hoistedInvariants;
+    search.invariants.inductionAddresses = NULL;
+    search.invariants.found = NULL;
+    search.invariants.variableReads = 0;
+    search.inductionVariable = inductionVariable;
+    search.alwaysEvaluated = newMap();
+
+    IterationVisitor iterationVisitor = {
+        .expression = collectIterationExpression,
+        .target = collectIterationTarget,
+        .context = search.alwaysEvaluated
+    };
+    visitIteration(whileNode, &iterationVisitor);
+
+    TreeVisitor visitor = {
+        .preVisit = recordInductionAddress,
+        .postVisit = NULL,
+        .categoryFilter = valuesFilter,
+        .context = &search
+    };
+    visitSubtree(whileNode, &visitor);
+
+    Stack* candidates = inductionVariable->addresses;
+    inductionVariable->addresses = newStack();
+    while (candidates->size > 0) {
+        InductionAddressPtr address = pop(candidates);
+        if(address->alwaysEvaluated && address->benefit > 2 * ADDRESS_BUMP_COST) {
+            push(inductionVariable->addresses, address);
+        } else {
+            while (pop(address->uses) != NULL);
+            free(address->uses);
+            free(address);
+        }
+    }
+    free(candidates);
+
+    freeMap(search.alwaysEvaluated, NULL);
+}
+
+void collectIterationExpression(TreeNodePtr node, void* context) {
+    TreeVisitor visitor = {
+        .preVisit = collectArrayValue,
+        .postVisit = NULL,
+        .categoryFilter = valuesFilter,
+        .context = context
+    };
+    visitSubtree(node, &visitor);
+}
+
+void collectIterationTarget(TreeNodePtr valueNode, void* context) {
+    if(valueNode != NULL) {
+        collectIterationExpression(valueNode, context);
+    }
+}
+
+bool collectArrayValue(TreeNodePtr node, void* context) {
+    if(node->subtrees[1] != NULL) {
+        mapPut((Map*) context, node, node);
+    }
+    return true;
+}
+
+/*
+ * Records an array value whose subscripts are either linear in the induction variable or invariant, with at least one
+ * linear subscript, in the group of the values selecting the same element
+ */
+bool recordInductionAddress(TreeNodePtr node, void* context) {
+    AddressesSearch* search = (AddressesSearch*) context;
+    TreeNodePtr indexNode = node->subtrees[1];
+    SymbolTableEntryPtr entry = findNodeIdentifier(node);
+    TypeDescriptorPtr type = entry == NULL ? NULL : getEntryType(entry);
+    if(indexNode == NULL || type == NULL || findHoistedInvariant(search->invariants.hoisted, node) != NULL) {
+        return true;
+    }
+
+    int subscripts = 0;
+    int delta = 0;
+    // the base address, then the subscripts and their indexing, the leading invariant subscripts would be hoisted
+    int cost = 1;
+    bool invariantPrefix = compilerOptions.optimizations[LOOP_INVARIANT_CODE_MOTION];
+    for (; indexNode != NULL; indexNode = indexNode->next) {
+        if(type->category != ARRAY_TYPE) {
+            return true;
+        }
+        type = type->description.arrayDescriptor->elementType;
+        subscripts++;
+
+        int constant;
+        int subscriptCost = 0;
+        if(isInductionSubscript(search, indexNode->subtrees[0], &constant)) {
+            delta += search->inductionVariable->step * type->size;
+            subscriptCost = constant == 0 ? 1 : 3;
+            invariantPrefix = false;
+        } else if(!isInvariantExpression(&search->invariants, indexNode->subtrees[0], &subscriptCost)) {
+            return true;
+        }
+        if(!invariantPrefix) {
+            cost += subscriptCost + 1;
+        }
+    }
+    if(delta == 0) {
+        return true;
+    }
+
+    InductionAddressPtr address = find(search->inductionVariable->addresses, node, byAddressNode);
+    if(address == NULL) {
+        address = malloc(sizeof(InductionAddress));
+        address->uses = newStack();
+        address->firstUse = node;
+        address->subscripts = subscripts;
+        address->delta = delta;
+        address->displacement = -1;
+        address->benefit = 0;
+        address->alwaysEvaluated = false;
+        push(search->inductionVariable->addresses, address);
+    }
+
+    bool alwaysEvaluated = mapGet(search->alwaysEvaluated, node) != NULL;
+    address->alwaysEvaluated = address->alwaysEvaluated || alwaysEvaluated;
+    address->benefit += (alwaysEvaluated ? 2 : 1) * (cost - 1);
+    push(address->uses, node);
+    return true;
+}
+
+/* Checks if the subscript is the induction variable plus or minus a constant */
+bool isInductionSubscript(AddressesSearch* search, TreeNodePtr expressionNode, int* constant) {
+    TreeNodePtr variableNode = splitSubscript(expressionNode, true, constant);
+    TreeNodePtr valueNode = getSingleValueNode(variableNode);
+    return valueNode != NULL && valueNode->subtrees[1] == NULL &&
+           findNodeIdentifier(valueNode) == search->inductionVariable->entry;
+}
+
+bool byAddressNode(void* data, void* secondParam) {
+    return equalTrees(((InductionAddressPtr) data)->firstUse, (TreeNodePtr) secondParam);
+}
+
+
+/**
+ * Counted loops
+ **/
+
+/* Largest trip count of the loops replaced by copies of their body */
+#define FULL_UNROLL_ITERATIONS 16
+/*
+ * Largest size of the copies of a body, in tree nodes: about 500 instructions (ex: the body
+ * "C[i][j] = C[i][j] + A[i][k]*B[k][j]; k = k + 1;" has 94 nodes and compiles to 30 instructions)
+ */
+#define UNROLL_SIZE_LIMIT 1536
+/*
+ * Size the copies of the bodies may bring a whole program to, in tree nodes: about 500 instructions, the default
+ * program size of MEPA, at the fewest nodes per instruction (ex: calls like "write(fib(n))"), so unrolling doesn't
+ * make a program too large for MEPA when the program itself isn't
+ */
+#define UNROLL_PROGRAM_SIZE_LIMIT 1350
+
+TreeNodePtr getLastStatement(TreeNodePtr compoundNode);
+bool isCounterUpdate(TreeNodePtr node, SymbolTableEntryPtr counter, int* step);
+bool findTripCount(CountedLoopPtr countedLoop, TreeNodePtr conditionNode, TreeNodePtr initNode);
+int unrolledGrowth(CountedLoopPtr countedLoop, int copies);
+
+CountedLoopPtr findCountedLoop(TreeNodePtr whileNode, TreeNodePtr initNode, Map* hoistedInvariants) {
+    TreeNodePtr conditionNode = whileNode->subtrees[0];
+    TreeNodePtr relationalOperatorNode = conditionNode->subtrees[1];
+    TreeNodePtr counterNode = getSingleValueNode(conditionNode->subtrees[0]);
+    TreeNodePtr updateNode = getLastStatement(whileNode->subtrees[1]);
+    if(relationalOperatorNode == NULL || counterNode == NULL || counterNode->subtrees[1] != NULL) {
+        return NULL;
+    }
+
+    SymbolTableEntryPtr counter = findNodeIdentifier(counterNode);
+    if(counter == NULL || !isLocalEntry(counter) ||
+       !equivalentTypes(getEntryType(counter), getSymbolTable()->integerTypeDescriptor)) {
+        return NULL;
+    }
+
+    int step;
+    if(!isCounterUpdate(updateNode, counter, &step)) {
+        return NULL;
+    }
+    switch (relationalOperatorNode->subtrees[0]->category) {
+        case LESS_NODE:
+        case LESS_OR_EQUAL_NODE:
+            if(step < 0) {
+                return NULL;
+            }
+            break;
+        case GREATER_NODE:
+        case GREATER_OR_EQUAL_NODE:
+            if(step > 0) {
+                return NULL;
+            }
+            break;
+        default:
+            return NULL;
+    }
+
+    int histogram[NODE_CATEGORIES_COUNT];
+    categoryHistogram(whileNode->subtrees[1], histogram);
+    if(histogram[WHILE_NODE] > 0) {
+        return NULL;
+    }
+
+    InvariantsSearch search;
+    search.effects = findLoopEffects(whileNode);
+    search.hoisted = hoistedInvariants;
+    search.inductionAddresses = NULL;
+    search.found = NULL;
+    search.variableReads = 0;
+    int cost = 0;
+    bool counted = !search.effects->allModified && countModifications(search.effects, counter) == 1 &&
+                   isInvariantExpression(&search, conditionNode->subtrees[2], &cost);
+    freeLoopEffects(search.effects);
+    if(!counted) {
+        return NULL;
+    }
+
+    CountedLoopPtr countedLoop = malloc(sizeof(CountedLoop));
+    countedLoop->counter = counter;
+    countedLoop->updateNode = updateNode;
+    countedLoop->step = step;
+    countedLoop->initialValue = 0;
+    countedLoop->tripCount = 0;
+    countedLoop->constantTripCount = findTripCount(countedLoop, conditionNode, initNode);
+    countedLoop->bodySize = 0;
+    for (int category = 0; category < NODE_CATEGORIES_COUNT; category++) {
+        countedLoop->bodySize += histogram[category];
+    }
+    return countedLoop;
+}
+
+TreeNodePtr getLastStatement(TreeNodePtr compoundNode) {
+    TreeNodePtr statementNode = compoundNode->subtrees[0];
+    while (statementNode != NULL && statementNode->next != NULL) {
+        statementNode = statementNode->next;
+    }
+    return statementNode;
+}
+
+/* Checks if the node is the assignment "i = i + c", "i = c + i" or "i = i - c" of the counter */
+bool isCounterUpdate(TreeNodePtr node, SymbolTableEntryPtr counter, int* step) {
+    if(node == NULL || node->category != ASSIGNMENT_NODE) {
+        return false;
+    }
+
+    TreeNodePtr targetNode = node->subtrees[0];
+    if(targetNode->subtrees[1] != NULL || findNodeIdentifier(targetNode) != counter) {
+        return false;
+    }
+
+    TreeNodePtr valueNode = getSingleValueNode(splitSubscript(node->subtrees[1], true, step));
+    return *step != 0 && valueNode != NULL && valueNode->subtrees[1] == NULL && findNodeIdentifier(valueNode) == counter;
+}
+
+/*
+ * Computes the number of iterations of the loop when the counter starts from a constant and the bound is constant,
+ * returns false if they aren't
+ */
+bool findTripCount(CountedLoopPtr countedLoop, TreeNodePtr conditionNode, TreeNodePtr initNode) {
+    if(initNode == NULL || initNode->category != ASSIGNMENT_NODE || initNode->subtrees[0]->subtrees[1] != NULL ||
+       findNodeIdentifier(initNode->subtrees[0]) != countedLoop->counter) {
+        return false;
+    }
+
+    int initial;
+    long long bound;
+    if(!evaluateConstantExpression(initNode->subtrees[1], &initial) ||
+       !evaluateBinaryOpExpression(conditionNode->subtrees[2], &bound)) {
+        return false;
+    }
+
+    // the distance the counter moves before the condition fails, the iterations are the steps needed to cover it
+    long long distance;
+    long long step = countedLoop->step > 0 ? countedLoop->step : -(long long) countedLoop->step;
+    switch (conditionNode->subtrees[1]->subtrees[0]->category) {
+        case LESS_NODE:
+            distance = bound - initial;
+            break;
+        case LESS_OR_EQUAL_NODE:
+            distance = bound - initial + 1;
+            break;
+        case GREATER_NODE:
+            distance = initial - bound;
+            break;
+        default:
+            distance = initial - bound + 1;
+            break;
+    }
+
+    long long tripCount = distance > 0 ? (distance + step - 1) / step : 0;
+    if(tripCount > INT_MAX) {
+        return false;
+    }
+    countedLoop->initialValue = initial;
+    countedLoop->tripCount = (int) tripCount;
+    return true;
+}
+
+/*
+ * A loop that never runs is left alone, a single copy is worth it when it replaces the whole loop: it saves the
+ * condition and the jumps
+ */
+bool chooseUnrolledCopies(CountedLoopPtr countedLoop, int* growthBudget) {
+    int sizeLimitedCopies = UNROLL_SIZE_LIMIT / countedLoop->bodySize;
+    int copies = compilerOptions.unrollFactor < sizeLimitedCopies ? compilerOptions.unrollFactor : sizeLimitedCopies;
+    if(countedLoop->constantTripCount && countedLoop->tripCount <= sizeLimitedCopies &&
+       (countedLoop->tripCount <= FULL_UNROLL_ITERATIONS || countedLoop->tripCount <= copies) &&
+       (countedLoop->tripCount - 1) * countedLoop->bodySize <= *growthBudget) {
+        countedLoop->copies = countedLoop->tripCount;
+        countedLoop->fullyUnrolled = true;
+        if(countedLoop->tripCount > 0) {
+            *growthBudget -= (countedLoop->tripCount - 1) * countedLoop->bodySize;
+        }
+        return countedLoop->tripCount > 0;
+    }
+
+    while (copies >= 2 && unrolledGrowth(countedLoop, copies) > *growthBudget) {
+        copies--;
+    }
+    countedLoop->copies = copies;
+    countedLoop->fullyUnrolled = false;
+    if(copies < 2) {
+        return false;
+    }
+    *growthBudget -= unrolledGrowth(countedLoop, copies);
+    return true;
+}
+
+int initialUnrollingBudget(TreeNodePtr programNode) {
+    int histogram[NODE_CATEGORIES_COUNT];
+    categoryHistogram(programNode, histogram);
+    int programSize = 0;
+    for (int category = 0; category < NODE_CATEGORIES_COUNT; category++) {
+        programSize += histogram[category];
+    }
+    return programSize < UNROLL_PROGRAM_SIZE_LIMIT ? UNROLL_PROGRAM_SIZE_LIMIT - programSize : 0;
+}
+
+/* Tree nodes the copies of a partially unrolled loop and its remainder add to the single copy of the body */
+int unrolledGrowth(CountedLoopPtr countedLoop, int copies) {
+    int remainderCopies = countedLoop->constantTripCount ? countedLoop->tripCount % copies : 1;
+    return (copies + remainderCopies - 1) * countedLoop->bodySize;
+}
+
+/**
+ * Copy loops
+ **/
+
+/* Largest block moved by a single LDMV and STMV, in words */
+#define BLOCK_MOVE_LIMIT 256
+
+bool isElementSequence(InvariantsSearch* search, TreeNodePtr valueNode, SymbolTableEntryPtr counter, int* elementSize);
+
+bool isBlockCopy(TreeNodePtr whileNode, CountedLoopPtr countedLoop, Map* hoistedInvariants, int* words) {
+    TreeNodePtr assignmentNode = whileNode->subtrees[1]->subtrees[0];
+    if(!countedLoop->constantTripCount || countedLoop->tripCount == 0 || countedLoop->tripCount > BLOCK_MOVE_LIMIT ||
+       countedLoop->step != 1 || assignmentNode->category != ASSIGNMENT_NODE ||
+       assignmentNode->next != countedLoop->updateNode) {
+        return false;
+    }
+
+    TreeNodePtr targetNode = assignmentNode->subtrees[0];
+    TreeNodePtr sourceNode = getSingleValueNode(assignmentNode->subtrees[1]);
+    SymbolTableEntryPtr target = findNodeIdentifier(targetNode);
+    SymbolTableEntryPtr source = findNodeIdentifier(sourceNode);
+    if(target == NULL || source == NULL || target == source || (!isLocalEntry(target) && !isLocalEntry(source))) {
+        return false;
+    }
+
+    InvariantsSearch search;
+    search.effects = findLoopEffects(whileNode);
+    search.hoisted = hoistedInvariants;
+    search.inductionAddresses = NULL;
+    search.found = NULL;
+    search.variableReads = 0;
+    int targetSize;
+    int sourceSize;
+    bool copy = isElementSequence(&search, targetNode, countedLoop->counter, &targetSize) &&
+                isElementSequence(&search, sourceNode, countedLoop->counter, &sourceSize) &&
+                targetSize == sourceSize;
+    freeLoopEffects(search.effects);
+
+    *words = countedLoop->tripCount * targetSize;
+    return copy && *words <= BLOCK_MOVE_LIMIT;
+}
+
+/*
+ * Checks if the array value node selects consecutive elements as the counter moves by 1: its last subscript is the
+ * counter plus or minus a constant and the other ones are loop invariant
+ */
+bool isElementSequence(InvariantsSearch* search, TreeNodePtr valueNode, SymbolTableEntryPtr counter, int* elementSize) {
+    TypeDescriptorPtr type = getEntryType(findNodeIdentifier(valueNode));
+    TreeNodePtr indexNode = valueNode->subtrees[1];
+    if(type == NULL || indexNode == NULL) {
+        return false;
+    }
+
+    for (; indexNode != NULL; indexNode = indexNode->next) {
+        if(type->category != ARRAY_TYPE) {
+            return false;
+        }
+
+        TreeNodePtr subscriptNode = indexNode->subtrees[0];
+        int cost = 0;
+        if(indexNode->next == NULL) {
+            int constant;
+            TreeNodePtr counterNode = getSingleValueNode(splitSubscript(subscriptNode, true, &constant));
+            if(counterNode == NULL || counterNode->subtrees[1] != NULL || findNodeIdentifier(counterNode) != counter) {
+                return false;
+            }
+        } else if(!isInvariantExpression(search, subscriptNode, &cost)) {
+            return false;
+        }
+        type = type->description.arrayDescriptor->elementType;
+    }
+
+    *elementSize = type->size;
+    return true;
+}
+
+/**
+ * Iteration visitor
+ **/
+
+bool visitIterationStatement(TreeNodePtr node, IterationVisitor* visitor);
+bool visitPseudoFunctionCall(TreeNodePtr node, IterationVisitor* visitor);
+bool mayLeaveIteration(TreeNodePtr node);
+bool findIterationExit(TreeNodePtr node, void* context);
+
+void visitIteration(TreeNodePtr whileNode, IterationVisitor* visitor) {
+    visitor->expression(whileNode->subtrees[0], visitor->context);
+    visitIterationStatement(whileNode->subtrees[1], visitor);
+}
+
+/* Returns false when the statements after this one may not be reached in every iteration */
+bool visitIterationStatement(TreeNodePtr node, IterationVisitor* visitor) {
+    if(node == NULL) {
+        return true;
+    }
+
+    switch (node->category) {
+        case ASSIGNMENT_NODE:
+            if(mayLeaveIteration(node)) {
+                return false;
+            }
+            // the commands of a dead store are discarded, its expressions are never evaluated
+            if(compilerOptions.optimizations[DEAD_STORE_ELIMINATION] &&
+               isUnusedVariable(findNodeIdentifier(node->subtrees[0]))) {
+                return true;
+            }
+            visitor->target(node->subtrees[0], visitor->context);
+            visitor->expression(node->subtrees[1], visitor->context);
+            return true;
+        case FUNCTION_CALL_NODE:
+            return visitPseudoFunctionCall(node, visitor);
+        case IF_NODE:
+            if(!mayLeaveIteration(node->subtrees[0])) {
+                visitor->expression(node->subtrees[0], visitor->context);
+            }
+            return !mayLeaveIteration(node);
+        case WHILE_NODE:
+            if(!mayLeaveIteration(node->subtrees[0])) {
+                visitor->expression(node->subtrees[0], visitor->context);
+            }
+            return false;
+        case COMPOUND_NODE:
+            for (TreeNodePtr statement = node->subtrees[0]; statement != NULL; statement = statement->next) {
+                if(!visitIterationStatement(statement, visitor)) {
+                    return false;
+                }
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool visitPseudoFunctionCall(TreeNodePtr node, IterationVisitor* visitor) {
+    SymbolTableEntryPtr functionEntry = findNodeIdentifier(node);
+    if(functionEntry == NULL || functionEntry->category != PSEUDO_FUNCTION_SYMBOL) {
+        return false;
+    }
+
+    for (TreeNodePtr argument = node->subtrees[1]; argument != NULL; argument = argument->next) {
+        if(functionEntry->description.pseudoFunction == WRITE) {
+            visitor->expression(argument, visitor->context);
+        } else {
+            visitor->target(getSingleValueNode(argument), visitor->context);
+        }
+    }
+    return true;
+}
+
+static const bool iterationExitsFilter[NODE_CATEGORIES_COUNT] = {
+    [GOTO_NODE] = true,
+    [RETURN_NODE] = true,
+    [WHILE_NODE] = true,
+    [FUNCTION_CALL_NODE] = true
+};
+
+/*
+ * Checks if the statements after the node may not be reached: it has a goto, a return, a loop (which may not end) or
+ * calls a function (which may not return, for instance by a goto to a label of an enclosing function)
+ */
+bool mayLeaveIteration(TreeNodePtr node) {
+    bool found = false;
+    TreeVisitor visitor = {
+        .preVisit = findIterationExit,
+        .postVisit = NULL,
+        .categoryFilter = iterationExitsFilter,
+        .context = &found
+    };
+    visitSubtree(node, &visitor);
+    return found;
+}
+
+bool findIterationExit(TreeNodePtr node, void* context) {
+    bool* found = (bool*) context;
+    if(node->category == FUNCTION_CALL_NODE) {
+        SymbolTableEntryPtr functionEntry = findNodeIdentifier(node);
+        if(functionEntry != NULL && functionEntry->category == PSEUDO_FUNCTION_SYMBOL) {
+            return true;
+        }
+    }
+    *found = true;
+    return false;
+}
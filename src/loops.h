@@ -0,0 +1,205 @@
+/**
+ * This module provides the analyses of while loops used by the loop optimizations of the code generator
+ *
+ * The analyses run when the code generator reaches the loop, so identifiers are resolved by the symbol table in the
+ * same scope the loop is compiled in
+ **/
+
+#ifndef LOOPS_HEADER
+#define LOOPS_HEADER
+
+#include "tree.h"
+#include "symboltable.h"
+
+/**
+ * Loop effects
+ **/
+typedef struct {
+    /*
+     * Variables and parameters assigned, read or passed by reference inside the loop, mapped to the number of times
+     * they are (an int)
+     */
+    Map* modifiedEntries;
+    /*
+     * Set when something outside the current activation record may change: a variable of an enclosing function or
+     * the target of a parameter passed by reference was modified, or a function was called
+     */
+    bool nonLocalsModified;
+    /*
+     * Set when even the current function's variables may change behind the loop's back: a nested function (which sees
+     * them) was called or passed as an argument
+     */
+    bool allModified;
+} LoopEffects, *LoopEffectsPtr;
+
+LoopEffectsPtr findLoopEffects(TreeNodePtr whileNode);
+void freeLoopEffects(LoopEffectsPtr effects);
+
+/* A variable, parameter or constant whose value does not change while the loop runs */
+bool isInvariantEntry(SymbolTableEntryPtr entry, LoopEffectsPtr effects);
+
+/* The entry of a value or function call node's identifier, NULL if it isn't declared */
+SymbolTableEntryPtr findNodeIdentifier(TreeNodePtr node);
+/* Variables and parameters by value of the current function, nothing outside the activation record aliases them */
+bool isLocalEntry(SymbolTableEntryPtr entry);
+/* The type of a variable or parameter, NULL for the other entries and for function parameters */
+TypeDescriptorPtr getEntryType(SymbolTableEntryPtr entry);
+
+/**
+ * Loop invariants
+ **/
+typedef enum {
+    /* A scalar expression (expression, binary operator expression, term or factor node) evaluated once */
+    INVARIANT_VALUE,
+    /* The address selected by the leading subscripts of an array value node */
+    INVARIANT_ARRAY_PREFIX,
+    /*
+     * The address of an array element indexed by an induction variable (all the subscripts), it isn't invariant but
+     * the temporary keeping it is updated along with the variable
+     */
+    INDUCTION_ARRAY_ADDRESS
+} LoopInvariantCategory;
+
+typedef struct {
+    LoopInvariantCategory category;
+    TreeNodePtr node;
+    /* Number of leading subscripts of the array addresses */
+    int subscripts;
+    /* Filled by the code generator: the temporary keeping the invariant while the loop runs and its type */
+    int displacement;
+    TypeDescriptorPtr type;
+} LoopInvariant, *LoopInvariantPtr;
+
+/*
+ * Finds the loop invariant computations of a while loop worth evaluating once before it (at least two instructions
+ * replaced by a single load), in the order they are found. The loop is expected to be rotated by the code generator,
+ * so the invariants are only evaluated after the loop condition held once.
+ * Only the parts of the loop evaluated in every iteration are searched (see visitIteration), an expression that faults
+ * (ex: a division by zero) must not be evaluated if the loop would not evaluate it.
+ * Nodes already in hoistedInvariants (the invariants of the enclosing loops) and the array addresses of the loop's
+ * induction variables are not searched.
+ */
+Stack* findLoopInvariants(TreeNodePtr whileNode, Map* hoistedInvariants, Stack* inductionVariables);
+
+/* Finds the invariant of the given node among the hoisted ones (mapped by their nodes), NULL if it isn't hoisted */
+LoopInvariantPtr findHoistedInvariant(Map* hoistedInvariants, TreeNodePtr node);
+
+/**
+ * Induction variables
+ **/
+typedef struct {
+    /* Array value nodes selecting the same element, the first one is used to compute the address before the loop */
+    Stack* uses;
+    TreeNodePtr firstUse;
+    int subscripts;
+    /* Added to the address each time the induction variable is updated */
+    int delta;
+    /* Weighted instructions saved per iteration, see findInductionVariables */
+    int benefit;
+    bool alwaysEvaluated;
+    /* Filled by the code generator: the temporary keeping the address */
+    int displacement;
+} InductionAddress, *InductionAddressPtr;
+
+typedef struct {
+    SymbolTableEntryPtr entry;
+    /* The assignment "i = i + step" (or "i = i - step") */
+    TreeNodePtr updateNode;
+    int step;
+    Stack* addresses;
+} InductionVariable, *InductionVariablePtr;
+
+/*
+ * Finds the induction variables of a while loop: local integer variables only modified by a statement of the loop body
+ * itself adding a constant step to them, so they are updated once per iteration. For each one, it also finds the array
+ * elements whose subscripts are either the variable (plus or minus a constant) or loop invariant: their address
+ * changes by a constant each time the variable is updated, so the code generator can keep it in a temporary and bump
+ * it instead of indexing the array again.
+ * Bumping an address costs four instructions per iteration, so only addresses whose uses save more than that are
+ * kept (a use in a conditional branch counts as half a use) and only addresses evaluated in every iteration are kept,
+ * since they are computed before the loop. Variables without addresses worth it are not returned.
+ */
+Stack* findInductionVariables(TreeNodePtr whileNode, Map* hoistedInvariants);
+
+/*
+ * Finds the induction variable updated by the given assignment, NULL if it doesn't update one. The induction variables
+ * are mapped by their update nodes (see activateInductionVariable)
+ */
+InductionVariablePtr findInductionUpdate(Map* inductionUpdates, TreeNodePtr assignmentNode);
+/* Maps the induction variable by its update node, or removes it from the map when active is false */
+void activateInductionVariable(Map* inductionUpdates, InductionVariablePtr inductionVariable, bool active);
+
+void freeInductionVariable(InductionVariablePtr inductionVariable);
+
+/**
+ * Counted loops
+ **/
+typedef struct {
+    SymbolTableEntryPtr counter;
+    /* The last statement of the body, "i = i + step" (or "i = i - step") */
+    TreeNodePtr updateNode;
+    int step;
+    /* Set when the counter is given a constant right before the loop and the bound is constant */
+    bool constantTripCount;
+    int initialValue;
+    int tripCount;
+    /* Tree nodes of the loop body, an estimate of the code emitted for each copy of it */
+    int bodySize;
+    /* Filled by chooseUnrolledCopies */
+    int copies;
+    bool fullyUnrolled;
+} CountedLoop, *CountedLoopPtr;
+
+/*
+ * Finds if a while loop is counted: its condition is "i < E" or "i <= E" (with a positive step) or "i > E" or "i >= E"
+ * (with a negative step), where i is a local integer variable only modified by the last statement of the body, which
+ * adds a constant step to it, and E is loop invariant. Labels can't be declared inside a loop, so no goto enters its
+ * body. Loops with nested loops are not searched, only innermost loops are transformed.
+ * initNode is the unlabeled statement compiled right before the loop, if any: when it assigns a constant to the counter
+ * and E is constant, the number of iterations is known.
+ */
+CountedLoopPtr findCountedLoop(TreeNodePtr whileNode, TreeNodePtr initNode, Map* hoistedInvariants);
+
+/*
+ * Chooses the copies of the body of an unrolled loop, returns false if unrolling it isn't worth it. A loop running a
+ * few iterations (see FULL_UNROLL_ITERATIONS) is replaced by copies of its body, the other ones get up to
+ * compilerOptions.unrollFactor copies, as long as the copies stay under UNROLL_SIZE_LIMIT tree nodes.
+ * growthBudget is the number of tree nodes the copies of the program's loops may still add, the loop gets fewer copies
+ * (or none) when it would go over it, and the nodes its copies add are taken from it.
+ */
+bool chooseUnrolledCopies(CountedLoopPtr countedLoop, int* growthBudget);
+/* The growth budget of the unrolled loops of a whole program, see UNROLL_PROGRAM_SIZE_LIMIT */
+int initialUnrollingBudget(TreeNodePtr programNode);
+
+/**
+ * Copy loops
+ **/
+
+/*
+ * Checks if a counted loop, with a known trip count and a step of 1, only copies consecutive elements of an array to
+ * another one: its body is "T[...][i + c] = S[...][i + d]; i = i + 1;", where the leading subscripts are loop invariant
+ * and the elements have the same size, so the elements read and written are contiguous. The arrays must be different
+ * variables and one of them a local one (see isLocalEntry), so they don't overlap.
+ * Fills the words copied by the whole loop, up to BLOCK_MOVE_LIMIT since a block move keeps them on the stack.
+ */
+bool isBlockCopy(TreeNodePtr whileNode, CountedLoopPtr countedLoop, Map* hoistedInvariants, int* words);
+
+/**
+ * Iteration visitor
+ **/
+typedef struct {
+    /* An expression evaluated in every iteration */
+    void (*expression)(TreeNodePtr expressionNode, void* context);
+    /* The value node of an assignment or read target evaluated in every iteration, it may be NULL for invalid targets */
+    void (*target)(TreeNodePtr valueNode, void* context);
+    void* context;
+} IterationVisitor;
+
+/*
+ * Visits the parts of a while loop evaluated in every iteration that runs: the loop condition and the statements
+ * always reached in the body. The visit stops at the first statement that may leave the iteration (goto, return,
+ * nested loop or function call) and does not enter the branches of conditionals, only their conditions
+ */
+void visitIteration(TreeNodePtr whileNode, IterationVisitor* visitor);
+
+#endif
@@ -0,0 +1,262 @@
+#include "options.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+CompilerOptions compilerOptions = {
+    .timePasses = false,
+    .stats = false,
+    .dumpTree = false,
+    .dumpCfg = false,
+    .printAfter = -1,
+    .reportPasses = false,
+    .unrollFactor = 4
+};
+
+#define MAX_OPTIMIZATION_LEVEL 2
+#define MAX_UNROLL_FACTOR 64
+
+typedef struct {
+    const char* name;
+    const char* description;
+    /* The lowest -O level enabling the optimization */
+    int level;
+} OptimizationInfo;
+
+/* Indexed by Optimization */
+const OptimizationInfo optimizationsInfo[OPTIMIZATIONS_COUNT] = {
+    [FOLD_CONSTANT_INDICES] = {
+        "fold-constant-indices",
+        "address array elements with constant subscripts by a precomputed displacement",
+        1
+    },
+    [LINEARIZE_ARRAY_ADDRESSING] = {
+        "linearize-array-addressing",
+        "compute array element addresses from the stride table, folding constant terms of the subscripts",
+        1
+    },
+    [LOOP_INVARIANT_CODE_MOTION] = {
+        "loop-invariant-code-motion",
+        "evaluate the computations of while loops that do not change across iterations once before the loop",
+        2
+    },
+    [INDUCTION_VARIABLES] = {
+        "induction-variables",
+        "keep the addresses of array elements indexed by loop counters in temporaries bumped with the counter",
+        2
+    },
+    [LOOP_IDIOMS] = {
+        "loop-idioms",
+        "replace the while loops copying consecutive array elements by a single block move (LDMV/STMV)",
+        2
+    },
+    [LOOP_UNROLLING] = {
+        "unroll-loops",
+        "repeat the body of innermost counted while loops, or replace them by copies of it for a few iterations",
+        2
+    },
+    [COMMON_SUBEXPRESSION_ELIMINATION] = {
+        "common-subexpression-elimination",
+        "compute the array element addresses and values repeated by straight-line assignments once into temporaries",
+        2
+    },
+    [PURE_CALL_EVALUATION] = {
+        "evaluate-pure-calls",
+        "replace the calls of pure functions passing only constants by the value they return, computed at compile time",
+        2
+    },
+    [INLINE_FUNCTIONS] = {
+        "inline-functions",
+        "compile the body of small non recursive functions in place of their calls",
+        2
+    },
+    [TAIL_CALL_ELIMINATION] = {
+        "tail-call-elimination",
+        "turn the calls of a function to itself in return statements into jumps to its body",
+        1
+    },
+    [UNREACHABLE_CODE_ELIMINATION] = {
+        "unreachable-code-elimination",
+        "leave out the functions never called nor passed as arguments and the statements following returns and gotos",
+        2
+    },
+    [DEAD_STORE_ELIMINATION] = {
+        "dead-store-elimination",
+        "leave out the variables never read and the assignments to them from the activation records",
+        1
+    },
+    [STACK_SLOT_SHARING] = {
+        "stack-slot-sharing",
+        "let variables whose values are never needed at the same time share positions of the activation record",
+        1
+    },
+    [COPY_ELISION] = {
+        "copy-elision",
+        "pass the arrays by value a function never writes by address, and return local arrays in place",
+        2
+    },
+    [FUNCTION_SPECIALIZATION] = {
+        "function-specialization",
+        "compile versions of the functions receiving known functions as parameters that call them directly",
+        2
+    },
+    [LOCAL_LABELS] = {
+        "local-labels",
+        "enter the labels only targeted by gotos of their own function without restoring the stack (ENLB)",
+        1
+    },
+    [STATIC_ACTIVATION_RECORDS] = {
+        "static-activation-records",
+        "keep the variables of the functions never active twice in the main function's activation record",
+        2
+    }
+};
+
+/* Flags given by -f<name> (1) and -fno-<name> (0), -1 for the ones left to the optimization level */
+typedef int OptimizationFlags[OPTIMIZATIONS_COUNT];
+
+void printUsage(char* programName);
+bool parseOptimizationLevel(char* argument, int* level);
+bool parseOptimizationFlag(char* argument, OptimizationFlags flags);
+bool parseUnrollFactor(char* argument);
+int findOptimization(char* name);
+
+void parseOptions(int argc, char** argv) {
+    int level = 0;
+    OptimizationFlags flags;
+    for (int optimization = 0; optimization < OPTIMIZATIONS_COUNT; optimization++) {
+        flags[optimization] = -1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        char* argument = argv[i];
+
+        if (strcmp(argument, "--help") == 0) {
+            printUsage(argv[0]);
+            exit(EXIT_SUCCESS);
+        } else if (strcmp(argument, "--time-passes") == 0) {
+            compilerOptions.timePasses = true;
+        } else if (strcmp(argument, "--stats") == 0) {
+            compilerOptions.stats = true;
+        } else if (strcmp(argument, "--dump-tree") == 0) {
+            compilerOptions.dumpTree = true;
+        } else if (strcmp(argument, "--dump-cfg") == 0) {
+            compilerOptions.dumpCfg = true;
+        } else if (strcmp(argument, "--report-passes") == 0) {
+            compilerOptions.reportPasses = true;
+        } else if (strncmp(argument, "--print-after=", 14) == 0 && findOptimization(argument + 14) >= 0) {
+            compilerOptions.printAfter = findOptimization(argument + 14);
+        } else if (parseUnrollFactor(argument)) {
+            // the factor only matters when loops are unrolled
+        } else if (parseOptimizationLevel(argument, &level) || parseOptimizationFlag(argument, flags)) {
+            // applied once all the arguments were read
+        } else {
+            fprintf(stderr, "Unknown option '%s'\n", argument);
+            printUsage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // -f<name> and -fno-<name> override the level wherever they are given
+    for (int optimization = 0; optimization < OPTIMIZATIONS_COUNT; optimization++) {
+        compilerOptions.optimizations[optimization] = flags[optimization] >= 0 ?
+                                                      flags[optimization] == 1 :
+                                                      level >= optimizationsInfo[optimization].level;
+    }
+}
+
+/*
+ * Parses -O<level> (-O alone is -O1), returns false if the argument is not a known optimization level
+ */
+bool parseOptimizationLevel(char* argument, int* level) {
+    if (strncmp(argument, "-O", 2) != 0) {
+        return false;
+    }
+
+    if (argument[2] == '\0') {
+        *level = 1;
+        return true;
+    }
+    if (argument[2] >= '0' && argument[2] <= '0' + MAX_OPTIMIZATION_LEVEL && argument[3] == '\0') {
+        *level = argument[2] - '0';
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Parses -f<name> and -fno-<name>, returns false if the argument is not a known optimization flag
+ */
+bool parseOptimizationFlag(char* argument, OptimizationFlags flags) {
+    if (strncmp(argument, "-f", 2) != 0) {
+        return false;
+    }
+
+    char* name = argument + 2;
+    bool enabled = true;
+    if (strncmp(name, "no-", 3) == 0) {
+        name += 3;
+        enabled = false;
+    }
+
+    int optimization = findOptimization(name);
+    if (optimization < 0) {
+        return false;
+    }
+    flags[optimization] = enabled ? 1 : 0;
+    return true;
+}
+
+/*
+ * Parses --unroll-factor=<n>, returns false if the argument is not the option or the factor isn't between 2 and
+ * MAX_UNROLL_FACTOR
+ */
+bool parseUnrollFactor(char* argument) {
+    if (strncmp(argument, "--unroll-factor=", 16) != 0) {
+        return false;
+    }
+
+    char* end;
+    long factor = strtol(argument + 16, &end, 10);
+    if (argument[16] == '\0' || *end != '\0' || factor < 2 || factor > MAX_UNROLL_FACTOR) {
+        return false;
+    }
+    compilerOptions.unrollFactor = (int) factor;
+    return true;
+}
+
+/* The optimization with the given name, -1 if there is none */
+int findOptimization(char* name) {
+    for (int optimization = 0; optimization < OPTIMIZATIONS_COUNT; optimization++) {
+        if (strcmp(name, optimizationsInfo[optimization].name) == 0) {
+            return optimization;
+        }
+    }
+    return -1;
+}
+
+const char* getOptimizationName(Optimization optimization) {
+    return optimizationsInfo[optimization].name;
+}
+
+void printUsage(char* programName) {
+    fprintf(stderr, "Usage: %s [options] < program.sl > program.mep\n", programName);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --help           print this message\n");
+    fprintf(stderr, "  --time-passes    report wall and CPU time spent on each compilation phase\n");
+    fprintf(stderr, "  --stats          report scanning, tree, symbol table and code generation counters\n");
+    fprintf(stderr, "  --dump-tree      print the syntax tree instead of generating code\n");
+    fprintf(stderr, "  --dump-cfg       print the control flow graphs of the generated code in the DOT language\n");
+    fprintf(stderr, "  --report-passes  report the time and the instructions each enabled optimization adds\n");
+    fprintf(stderr, "  --print-after=<name>\n");
+    fprintf(stderr, "                   print the code generated up to that optimization of the pipeline\n");
+    fprintf(stderr, "  --unroll-factor=<n>\n");
+    fprintf(stderr, "                   copies of the body in the loops partially unrolled by -funroll-loops (4)\n");
+    fprintf(stderr, "  -O0, -O1, -O2    enable no optimization (default), the cheap ones or all of them\n");
+    fprintf(stderr, "Optimizations in pipeline order (-f<name> enables, -fno-<name> disables, -O level):\n");
+    for (int optimization = 0; optimization < OPTIMIZATIONS_COUNT; optimization++) {
+        fprintf(stderr, "  -f%-28s %s (-O%d)\n", optimizationsInfo[optimization].name,
+                optimizationsInfo[optimization].description, optimizationsInfo[optimization].level);
+    }
+}
@@ -0,0 +1,70 @@
+/**
+ * This module parses and keeps the compiler command line options
+ **/
+
+#ifndef OPTIONS_HEADER
+#define OPTIONS_HEADER
+
+#include "utils.h"
+
+/*
+ * Optional code generation optimizations, each one is enabled by -f<name> and disabled by -fno-<name>
+ * They are all disabled by default (-O0), so the generated code is the same as the reference MEPA code. -O1 enables
+ * the cheap ones, working on a single function or statement, and -O2 all of them.
+ * The order of the enumeration is the order of the pass pipeline, see runPassPipeline
+ */
+typedef enum {
+    FOLD_CONSTANT_INDICES,
+    LINEARIZE_ARRAY_ADDRESSING,
+    LOOP_INVARIANT_CODE_MOTION,
+    INDUCTION_VARIABLES,
+    LOOP_IDIOMS,
+    LOOP_UNROLLING,
+    COMMON_SUBEXPRESSION_ELIMINATION,
+    PURE_CALL_EVALUATION,
+    INLINE_FUNCTIONS,
+    TAIL_CALL_ELIMINATION,
+    UNREACHABLE_CODE_ELIMINATION,
+    DEAD_STORE_ELIMINATION,
+    STACK_SLOT_SHARING,
+    COPY_ELISION,
+    FUNCTION_SPECIALIZATION,
+    LOCAL_LABELS,
+    STATIC_ACTIVATION_RECORDS,
+    OPTIMIZATIONS_COUNT
+} Optimization;
+
+typedef struct {
+    /* --time-passes: reports wall and CPU time spent on each compilation phase */
+    bool timePasses;
+    /* --stats: reports counters collected during the compilation */
+    bool stats;
+    /* --dump-tree: prints the syntax tree instead of generating code */
+    bool dumpTree;
+    /* --dump-cfg: prints the control flow graphs of the generated code in the DOT language instead of the code */
+    bool dumpCfg;
+    /* Indexed by Optimization */
+    bool optimizations[OPTIMIZATIONS_COUNT];
+    /* --print-after=<name>: prints the code generated by the pipeline up to that optimization, -1 if not given */
+    int printAfter;
+    /* --report-passes: reports the time and the instructions each enabled optimization adds to the compilation */
+    bool reportPasses;
+    /* --unroll-factor=<n>: copies of the body per iteration of the loops partially unrolled by -funroll-loops */
+    int unrollFactor;
+} CompilerOptions;
+
+/*
+ * Options are read on hot paths (every token, every tree node), so they are kept in a plain global instead of
+ * behind a getter, checking a disabled option costs a single load
+ */
+extern CompilerOptions compilerOptions;
+
+/*
+ * Reads the command line arguments into compilerOptions, unknown options terminate the program with an usage message
+ */
+void parseOptions(int argc, char** argv);
+
+/* The name of an optimization as written after -f */
+const char* getOptimizationName(Optimization optimization);
+
+#endif
@@ -1,13 +1,22 @@
 %{
 
 #include "tree.h"
+#include "stats.h"
 #include<stdio.h>
 
-/* FLEX functions */
+/* FLEX functions, the scanner is called through the instrumentation hook (see stats.h) */
+#define yylex instrumentedYylex
 extern int yylex (void);
 void yyerror(char *);
 char *tokenValue;
 
+/*
+ * The list rules are right recursive, so the parser stack grows with the length of a list (statements, arguments,
+ * parameters...). The stack lives on the heap and is only enlarged when needed, the default limit (10000) is raised
+ * so long generated programs can be parsed
+ */
+#define YYMAXDEPTH 100000000
+
 %}
 
 %{ /* Comparison operators */ %}
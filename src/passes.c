@@ -0,0 +1,183 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "passes.h"
+#include "codegen.h"
+#include "options.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+typedef struct {
+    double wallSeconds;
+    double cpuSeconds;
+    /* Lines of the generated code, one MEPA instruction each */
+    long instructions;
+    /* The stage exited normally, a semantic error included */
+    bool completed;
+} StageResult;
+
+StageResult compileStage(TreeNodePtr programNode, bool printCode);
+void compileInChild(TreeNodePtr programNode, int outputDescriptor);
+double childrenCpuSeconds();
+int stageNameWidth();
+void printStageReport(const char* name, int nameWidth, StageResult* result, StageResult* previous);
+
+void runPassPipeline(TreeNodePtr programNode) {
+    bool enabled[OPTIMIZATIONS_COUNT];
+    for (int optimization = 0; optimization < OPTIMIZATIONS_COUNT; optimization++) {
+        enabled[optimization] = compilerOptions.optimizations[optimization];
+        compilerOptions.optimizations[optimization] = false;
+    }
+
+    int printAfter = compilerOptions.printAfter;
+    if (printAfter >= 0 && !enabled[printAfter]) {
+        fprintf(stderr, "Optimization '%s' is not enabled, no code is printed after it\n",
+                getOptimizationName(printAfter));
+    }
+
+    // the report is printed once all the stages were compiled, after the printed code
+    StageResult unoptimized = compileStage(programNode, false);
+    StageResult results[OPTIMIZATIONS_COUNT];
+    for (int optimization = 0; optimization < OPTIMIZATIONS_COUNT; optimization++) {
+        if (!enabled[optimization]) {
+            continue;
+        }
+
+        compilerOptions.optimizations[optimization] = true;
+        if (optimization == printAfter) {
+            fprintf(stderr, "===== Code after %s =====\n", getOptimizationName(optimization));
+        }
+        results[optimization] = compileStage(programNode, optimization == printAfter);
+    }
+
+    if (compilerOptions.reportPasses) {
+        int nameWidth = stageNameWidth();
+        fprintf(stderr, "===== Pass pipeline =====\n");
+        fprintf(stderr, "%-*s %10s %10s %10s %12s %8s\n", nameWidth, "pass", "wall (ms)", "delta", "cpu (ms)",
+                "instructions", "delta");
+        printStageReport("-O0", nameWidth, &unoptimized, NULL);
+        StageResult* previous = &unoptimized;
+        for (int optimization = 0; optimization < OPTIMIZATIONS_COUNT; optimization++) {
+            if (enabled[optimization]) {
+                printStageReport(getOptimizationName(optimization), nameWidth, &results[optimization], previous);
+                previous = &results[optimization];
+            }
+        }
+    }
+}
+
+/* Compiles the program with the current optimizations in a child process, its code is printed on the standard error */
+StageResult compileStage(TreeNodePtr programNode, bool printCode) {
+    StageResult result = {0, 0, 0, false};
+    int pipeDescriptors[2];
+    fflush(stdout);
+    fflush(stderr);
+    if (pipe(pipeDescriptors) != 0) {
+        perror("pass pipeline");
+        return result;
+    }
+
+    struct timespec wallStart;
+    struct timespec wallEnd;
+    clock_gettime(CLOCK_MONOTONIC, &wallStart);
+    double cpuStart = childrenCpuSeconds();
+
+    pid_t child = fork();
+    if (child < 0) {
+        perror("pass pipeline");
+        close(pipeDescriptors[0]);
+        close(pipeDescriptors[1]);
+        return result;
+    }
+    if (child == 0) {
+        close(pipeDescriptors[0]);
+        compileInChild(programNode, pipeDescriptors[1]);
+    }
+
+    close(pipeDescriptors[1]);
+    FILE* code = fdopen(pipeDescriptors[0], "r");
+    int character;
+    while ((character = fgetc(code)) != EOF) {
+        if (character == '\n') {
+            result.instructions++;
+        }
+        if (printCode) {
+            fputc(character, stderr);
+        }
+    }
+    fclose(code);
+
+    int status;
+    waitpid(child, &status, 0);
+    clock_gettime(CLOCK_MONOTONIC, &wallEnd);
+    result.wallSeconds = (double) (wallEnd.tv_sec - wallStart.tv_sec) + (wallEnd.tv_nsec - wallStart.tv_nsec) / 1e9;
+    result.cpuSeconds = childrenCpuSeconds() - cpuStart;
+    result.completed = WIFEXITED(status);
+    return result;
+}
+
+/*
+ * The child writes the code to the pipe, and nothing else: its own reports and the messages of a crash are discarded.
+ * A semantic error exits from inside the code generator, after printing its message with the code
+ */
+void compileInChild(TreeNodePtr programNode, int outputDescriptor) {
+    dup2(outputDescriptor, STDOUT_FILENO);
+    close(outputDescriptor);
+    int nullDescriptor = open("/dev/null", O_WRONLY);
+    if (nullDescriptor >= 0) {
+        dup2(nullDescriptor, STDERR_FILENO);
+        close(nullDescriptor);
+    }
+    compilerOptions.timePasses = false;
+    compilerOptions.stats = false;
+
+    processProgram(programNode);
+    fflush(stdout);
+    _exit(EXIT_SUCCESS);
+}
+
+double childrenCpuSeconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_CHILDREN, &usage);
+    return (double) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+/* The deltas are taken from the previous stage, the time a pass adds may be under the noise of small programs */
+/* Width of the name column, the longest name of the registered optimizations */
+int stageNameWidth() {
+    int width = (int) strlen("pass");
+    for (int optimization = 0; optimization < OPTIMIZATIONS_COUNT; optimization++) {
+        int length = (int) strlen(getOptimizationName(optimization));
+        if (length > width) {
+            width = length;
+        }
+    }
+    return width;
+}
+
+void printStageReport(const char* name, int nameWidth, StageResult* result, StageResult* previous) {
+    fprintf(stderr, "%-*s %10.3f", nameWidth, name, result->wallSeconds * 1e3);
+    if (previous != NULL) {
+        fprintf(stderr, " %+10.3f", (result->wallSeconds - previous->wallSeconds) * 1e3);
+    } else {
+        fprintf(stderr, " %10s", "");
+    }
+    fprintf(stderr, " %10.3f", result->cpuSeconds * 1e3);
+
+    if (!result->completed) {
+        fprintf(stderr, " %12s\n", "crashed");
+        return;
+    }
+    fprintf(stderr, " %12ld", result->instructions);
+    if (previous != NULL && previous->completed) {
+        fprintf(stderr, " %+8ld", result->instructions - previous->instructions);
+    }
+    fprintf(stderr, "\n");
+}
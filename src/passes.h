@@ -0,0 +1,22 @@
+/**
+ * This module runs the pass pipeline behind the --print-after and --report-passes options
+ *
+ * The optimizations are applied by the code generator while it walks the tree, in a single traversal, so the code
+ * after a pass is the code generated with the optimizations up to that pass in the pipeline (the order of the
+ * Optimization enumeration). Each stage of the pipeline is compiled by a child process from the same tree, so the
+ * compiler's global state is never reset and a stage failing doesn't stop the compilation
+ **/
+
+#ifndef PASSES_HEADER
+#define PASSES_HEADER
+
+#include "tree.h"
+
+/*
+ * Compiles the program once without optimizations, then once more each time the next enabled optimization of the
+ * pipeline is added: the code after the --print-after optimization is printed and the time and instructions each
+ * optimization adds are reported on the standard error. The program itself is still compiled by processProgram
+ */
+void runPassPipeline(TreeNodePtr programNode);
+
+#endif
@@ -17,6 +17,9 @@
 #include "slc.h"
 #include "tree.h"
 #include "codegen.h"
+#include "options.h"
+#include "stats.h"
+#include "passes.h"
 
 extern int line_num;
 extern char *yytext;
@@ -39,9 +42,31 @@ int yyerror(char *s) {
 
 int main(int argc, char **argv) {
 
+  parseOptions(argc, argv);
+  if (compilerOptions.timePasses || compilerOptions.stats)
+    atexit(printInstrumentationReports);
+
+  CompilerPhase previousPhase = compilerOptions.timePasses ? enterPhase(PARSING_PHASE) : NO_PHASE;
   if (yyparse()!=0) 
     return 0;  // error message printed already
-  processProgram(getTree()); // generates code
+  if (compilerOptions.timePasses)
+    leavePhase(previousPhase);
+  if (compilerOptions.stats)
+    sampleHeapUsage();
+
+  void *tree = getTree();
+  if (compilerOptions.dumpTree) {
+    dumpTree(tree);
+    return 0;
+  }
+
+  if (compilerOptions.printAfter >= 0 || compilerOptions.reportPasses)
+    runPassPipeline(tree);
+
+  previousPhase = compilerOptions.timePasses ? enterPhase(CODE_EMISSION_PHASE) : NO_PHASE;
+  processProgram(tree); // generates code
+  if (compilerOptions.timePasses)
+    leavePhase(previousPhase);
   return 0;
   
 } // main
@@ -0,0 +1,504 @@
+#include "specialization.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "codegen.h"
+
+/*
+ * Most versions of a single function, each one repeats the whole function's code. Programs passing more functions to
+ * the same function parameter keep calling the remaining ones through their generalized addresses
+ */
+#define VERSIONS_LIMIT 4
+
+/*
+ * Largest function, in tree nodes, whose versions bind constants: unlike a bound function, which saves a call through
+ * a generalized address each time it is called, a constant only saves the instructions folded with it
+ */
+#define CONSTANT_VERSION_SIZE_LIMIT 400
+
+typedef struct {
+    /* The functions declared by the block */
+    TreeNodePtr functionNodes;
+    /* Versions found, the last one on top, and the ones whose bodies weren't searched yet */
+    Stack* versions;
+    Stack* pending;
+    /* The version whose body is being searched, NULL for the block's own body */
+    FunctionVersionPtr context;
+} VersionSearch;
+
+typedef struct {
+    TreeNodePtr laterFunctionNodes;
+    bool found;
+} LaterUseSearch;
+
+void searchCallSites(TreeNodePtr bodyNode, VersionSearch* search);
+bool addCallVersion(TreeNodePtr node, void* context);
+SymbolTableEntryPtr resolveFunction(char* identifier, VersionSearch* search);
+SymbolTableEntryPtr resolveCalledFunction(SymbolTableEntryPtr entry);
+TreeNodePtr findDeclaredFunction(TreeNodePtr functionNodes, SymbolTableEntryPtr functionEntry);
+bool declaresNestedFunction(TreeNodePtr blockNode, char* identifier);
+bool usesLaterFunction(TreeNodePtr functionNode);
+bool findLaterUse(TreeNodePtr node, void* context);
+bool isConstantArgument(TreeNodePtr argumentNode, VersionSearch* search, int* value);
+bool findValueNode(TreeNodePtr node, void* context);
+bool isSmallFunction(TreeNodePtr functionNode);
+bool hasBindings(FunctionVersionPtr version, FunctionVersionPtr other);
+bool matchesArguments(FunctionVersionPtr version, TreeNodePtr argumentNode);
+int countVersions(Stack* versions, SymbolTableEntryPtr functionEntry);
+bool isCalledBy(FunctionVersionPtr version, Stack* versions);
+void freeFunctionVersion(FunctionVersionPtr version);
+
+/* Versions found by findFunctionVersions and not released yet, the innermost block's ones on top */
+Stack* activeVersions = NULL;
+
+static const bool callsFilter[NODE_CATEGORIES_COUNT] = {
+    [FUNCTION_CALL_NODE] = true
+};
+
+Stack* findFunctionVersions(TreeNodePtr blockNode) {
+    if(activeVersions == NULL) {
+        activeVersions = newStack();
+    }
+
+    Stack* versions = newStack();
+    if(blockNode->subtrees[3] == NULL) {
+        return versions;
+    }
+
+    VersionSearch search = {
+        .functionNodes = blockNode->subtrees[3]->subtrees[0],
+        .versions = newStack(),
+        .pending = newStack(),
+        .context = NULL
+    };
+    searchCallSites(blockNode->subtrees[4], &search);
+    while (search.pending->top != NULL) {
+        search.context = pop(search.pending);
+        searchCallSites(search.context->functionNode->subtrees[1]->subtrees[4], &search);
+    }
+    free(search.pending);
+
+    // sorts the versions by declaration: the last function's ones are pushed first, then they are reversed
+    Stack* sorted = newStack();
+    for (TreeNodePtr functionNode = search.functionNodes; functionNode != NULL; functionNode = functionNode->next) {
+        for (LinkedNode* node = search.versions->top; node != NULL; node = node->next) {
+            FunctionVersionPtr version = node->data;
+            if(version->functionNode == functionNode) {
+                push(sorted, version);
+            }
+        }
+    }
+    while (sorted->top != NULL) {
+        FunctionVersionPtr version = pop(sorted);
+        push(versions, version);
+        push(activeVersions, version);
+    }
+    free(sorted);
+
+    while (pop(search.versions) != NULL);
+    free(search.versions);
+    return versions;
+}
+
+void searchCallSites(TreeNodePtr bodyNode, VersionSearch* search) {
+    TreeVisitor visitor = {
+        .preVisit = addCallVersion,
+        .postVisit = NULL,
+        .categoryFilter = callsFilter,
+        .context = search
+    };
+    visitSubtree(bodyNode, &visitor);
+}
+
+/*
+ * Adds the version a call needs, if it calls a function of the block passing known functions to all its function
+ * parameters, constants to some of its integer parameters or both
+ */
+bool addCallVersion(TreeNodePtr node, void* context) {
+    VersionSearch* search = (VersionSearch*) context;
+
+    SymbolTableEntryPtr functionEntry = resolveFunction(node->subtrees[0]->name, search);
+    if(functionEntry == NULL) {
+        return true;
+    }
+    TreeNodePtr functionNode = findDeclaredFunction(search->functionNodes, functionEntry);
+    if(functionNode == NULL) {
+        return true;
+    }
+
+    FunctionDescriptorPtr functionDescriptor = functionEntry->description.functionDescriptor;
+    int targetsCount = 0;
+    int parametersCount = 0;
+    for (ParameterDescriptorsListPtr parameter = functionDescriptor->parameters; parameter != NULL;
+         parameter = parameter->next) {
+        if(parameter->descriptor->parameterPassage == FUNCTION_PARAMETER) {
+            targetsCount++;
+        }
+        parametersCount++;
+    }
+    bool bindsConstants = isSmallFunction(functionNode);
+    if((targetsCount == 0 && !bindsConstants) || countVersions(search->versions, functionEntry) >= VERSIONS_LIMIT) {
+        return true;
+    }
+
+    FunctionVersionPtr version = malloc(sizeof(FunctionVersion));
+    version->functionNode = functionNode;
+    version->functionEntry = functionEntry;
+    version->targets = malloc(targetsCount * sizeof(SymbolTableEntryPtr));
+    version->targetsCount = 0;
+    version->constantPositions = malloc(parametersCount * sizeof(int));
+    version->constants = malloc(parametersCount * sizeof(int));
+    version->constantsCount = 0;
+    version->descriptor = NULL;
+    version->firstCommand = -1;
+    version->lastCommand = -1;
+    version->called = false;
+    version->callers = newStack();
+
+    int position = 0;
+    TreeNodePtr argumentNode = node->subtrees[1];
+    for (ParameterDescriptorsListPtr parameter = functionDescriptor->parameters; parameter != NULL;
+         parameter = parameter->next) {
+        if(argumentNode == NULL) {
+            freeFunctionVersion(version);
+            return true;
+        }
+        ParameterDescriptorPtr descriptor = parameter->descriptor;
+        if(descriptor->parameterPassage == FUNCTION_PARAMETER) {
+            TreeNodePtr valueNode = getSingleValueNode(argumentNode);
+            SymbolTableEntryPtr targetEntry = valueNode == NULL || valueNode->subtrees[1] != NULL ? NULL :
+                                              resolveFunction(valueNode->subtrees[0]->name, search);
+            if(targetEntry == NULL ||
+               !equivalentTypes(descriptor->type, targetEntry->description.functionDescriptor->functionType)) {
+                freeFunctionVersion(version);
+                return true;
+            }
+            version->targets[version->targetsCount++] = targetEntry;
+        }
+        int value;
+        if(bindsConstants && descriptor->readOnly && isConstantArgument(argumentNode, search, &value)) {
+            version->constantPositions[version->constantsCount] = position;
+            version->constants[version->constantsCount] = value;
+            version->constantsCount++;
+        }
+        argumentNode = argumentNode->next;
+        position++;
+    }
+
+    if((version->targetsCount == 0 && version->constantsCount == 0) || usesLaterFunction(functionNode)) {
+        freeFunctionVersion(version);
+        return true;
+    }
+    for (LinkedNode* versionNode = search->versions->top; versionNode != NULL; versionNode = versionNode->next) {
+        if(hasBindings(versionNode->data, version)) {
+            freeFunctionVersion(version);
+            return true;
+        }
+    }
+
+    push(search->versions, version);
+    push(search->pending, version);
+    return true;
+}
+
+static const bool valuesFilter[NODE_CATEGORIES_COUNT] = {
+    [VALUE_NODE] = true
+};
+
+/*
+ * Evaluates an argument made only of constants. A version's body is searched in the block's scope, where the names it
+ * declares aren't visible, so only integer literals are taken there
+ */
+bool isConstantArgument(TreeNodePtr argumentNode, VersionSearch* search, int* value) {
+    if(search->context != NULL) {
+        bool found = false;
+        TreeVisitor visitor = {
+            .preVisit = findValueNode,
+            .postVisit = NULL,
+            .categoryFilter = valuesFilter,
+            .context = &found
+        };
+        visitSubtree(argumentNode, &visitor);
+        if(found) {
+            return false;
+        }
+    }
+    return evaluateConstantExpression(argumentNode, value);
+}
+
+bool findValueNode(TreeNodePtr node, void* context) {
+    *((bool*) context) = true;
+    return false;
+}
+
+bool isSmallFunction(TreeNodePtr functionNode) {
+    // the function's block, the function node links to the functions declared after it
+    int histogram[NODE_CATEGORIES_COUNT];
+    categoryHistogram(functionNode->subtrees[1], histogram);
+
+    int size = 0;
+    for (int category = 0; category < NODE_CATEGORIES_COUNT; category++) {
+        size += histogram[category];
+    }
+    return size <= CONSTANT_VERSION_SIZE_LIMIT;
+}
+
+/*
+ * The function an identifier refers to in the body being searched: a declared function, or the function a parameter
+ * of the version (or of the block's function, when it is a version too) receives. NULL for anything else, the
+ * functions declared inside the version and its other parameters included
+ */
+SymbolTableEntryPtr resolveFunction(char* identifier, VersionSearch* search) {
+    FunctionVersionPtr context = search->context;
+    if(context != NULL) {
+        TreeNodePtr headerNode = context->functionNode->subtrees[0];
+        int target = 0;
+        for (TreeNodePtr parameterNode = headerNode->subtrees[2]; parameterNode != NULL;
+             parameterNode = parameterNode->next) {
+            if(parameterNode->category == FUNCTION_PARAMETER_NODE) {
+                if(strcmp(parameterNode->subtrees[0]->subtrees[1]->name, identifier) == 0) {
+                    return context->targets[target];
+                }
+                target++;
+                continue;
+            }
+            for (TreeNodePtr identifierNode = parameterNode->subtrees[0]; identifierNode != NULL;
+                 identifierNode = identifierNode->next) {
+                if(strcmp(identifierNode->name, identifier) == 0) {
+                    return NULL;
+                }
+            }
+        }
+        if(declaresNestedFunction(context->functionNode->subtrees[1], identifier)) {
+            return NULL;
+        }
+    }
+
+    SymbolTableEntryPtr entry = findIdentifier(identifier);
+    return entry == NULL ? NULL : resolveCalledFunction(entry);
+}
+
+SymbolTableEntryPtr resolveCalledFunction(SymbolTableEntryPtr entry) {
+    switch (entry->category) {
+        case FUNCTION_SYMBOL:
+            return entry;
+        case PARAMETER_SYMBOL:
+            return entry->description.parameterDescriptor->boundFunction;
+        default:
+            return NULL;
+    }
+}
+
+/* The declaration of a function of the block, the functions declared by the enclosing blocks have lower levels */
+TreeNodePtr findDeclaredFunction(TreeNodePtr functionNodes, SymbolTableEntryPtr functionEntry) {
+    if(functionEntry->level != getFunctionLevel() + 1) {
+        return NULL;
+    }
+
+    // a function redeclared with the same name is found by its last declaration
+    TreeNodePtr declaration = NULL;
+    for (TreeNodePtr functionNode = functionNodes; functionNode != NULL; functionNode = functionNode->next) {
+        if(strcmp(functionNode->subtrees[0]->subtrees[1]->name, functionEntry->identifier) == 0) {
+            declaration = functionNode;
+        }
+    }
+    return declaration;
+}
+
+bool declaresNestedFunction(TreeNodePtr blockNode, char* identifier) {
+    TreeNodePtr functionsNode = blockNode->subtrees[3];
+    if(functionsNode == NULL) {
+        return false;
+    }
+    for (TreeNodePtr functionNode = functionsNode->subtrees[0]; functionNode != NULL; functionNode = functionNode->next) {
+        if(strcmp(functionNode->subtrees[0]->subtrees[1]->name, identifier) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static const bool identifiersFilter[NODE_CATEGORIES_COUNT] = {
+    [IDENTIFIER_NODE] = true
+};
+
+/* Checks if a function uses the name of a function declared after it, in its nested functions too */
+bool usesLaterFunction(TreeNodePtr functionNode) {
+    LaterUseSearch search = {
+        .laterFunctionNodes = functionNode->next,
+        .found = false
+    };
+    TreeVisitor visitor = {
+        .preVisit = findLaterUse,
+        .postVisit = NULL,
+        .categoryFilter = identifiersFilter,
+        .context = &search
+    };
+    visitSubtree(functionNode, &visitor);
+    return search.found;
+}
+
+bool findLaterUse(TreeNodePtr node, void* context) {
+    LaterUseSearch* search = (LaterUseSearch*) context;
+    for (TreeNodePtr functionNode = search->laterFunctionNodes; functionNode != NULL && !search->found;
+         functionNode = functionNode->next) {
+        search->found = strcmp(functionNode->subtrees[0]->subtrees[1]->name, node->name) == 0;
+    }
+    return !search->found;
+}
+
+FunctionVersionPtr findCallVersion(TreeNodePtr callNode, SymbolTableEntryPtr functionEntry) {
+    if(activeVersions == NULL) {
+        return NULL;
+    }
+
+    for (LinkedNode* node = activeVersions->top; node != NULL; node = node->next) {
+        FunctionVersionPtr version = node->data;
+        if(version->functionEntry == functionEntry && version->descriptor != NULL &&
+           matchesArguments(version, callNode->subtrees[1])) {
+            return version;
+        }
+    }
+    return NULL;
+}
+
+/* Checks if two versions of the same function bind the same functions and constants */
+bool hasBindings(FunctionVersionPtr version, FunctionVersionPtr other) {
+    if(version->functionEntry != other->functionEntry || version->constantsCount != other->constantsCount) {
+        return false;
+    }
+    for (int i = 0; i < version->targetsCount; i++) {
+        if(version->targets[i] != other->targets[i]) {
+            return false;
+        }
+    }
+    for (int i = 0; i < version->constantsCount; i++) {
+        if(version->constantPositions[i] != other->constantPositions[i] || version->constants[i] != other->constants[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Checks if the arguments for the function parameters are the version's functions and the ones for its bound
+ * parameters its constants, resolved in the current scope
+ */
+bool matchesArguments(FunctionVersionPtr version, TreeNodePtr argumentNode) {
+    FunctionDescriptorPtr functionDescriptor = version->functionEntry->description.functionDescriptor;
+    int target = 0;
+    int constant = 0;
+    int position = 0;
+    for (ParameterDescriptorsListPtr parameter = functionDescriptor->parameters; parameter != NULL;
+         parameter = parameter->next) {
+        if(argumentNode == NULL) {
+            return false;
+        }
+        if(parameter->descriptor->parameterPassage == FUNCTION_PARAMETER) {
+            TreeNodePtr valueNode = getSingleValueNode(argumentNode);
+            if(valueNode == NULL || valueNode->subtrees[1] != NULL) {
+                return false;
+            }
+            SymbolTableEntryPtr entry = findIdentifier(valueNode->subtrees[0]->name);
+            if(entry == NULL || resolveCalledFunction(entry) != version->targets[target]) {
+                return false;
+            }
+            target++;
+        } else if(bindsConstant(version, position)) {
+            int value;
+            if(!evaluateConstantExpression(argumentNode, &value) || value != version->constants[constant]) {
+                return false;
+            }
+            constant++;
+        }
+        argumentNode = argumentNode->next;
+        position++;
+    }
+    return true;
+}
+
+bool bindsConstant(FunctionVersionPtr version, int position) {
+    for (int i = 0; i < version->constantsCount; i++) {
+        if(version->constantPositions[i] == position) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int countVersions(Stack* versions, SymbolTableEntryPtr functionEntry) {
+    int count = 0;
+    for (LinkedNode* node = versions->top; node != NULL; node = node->next) {
+        FunctionVersionPtr version = node->data;
+        if(version->functionEntry == functionEntry) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void addVersionCall(FunctionVersionPtr version, FunctionVersionPtr callerVersion) {
+    if(callerVersion == NULL) {
+        version->called = true;
+    } else if(callerVersion != version) {
+        push(version->callers, callerVersion);
+    }
+}
+
+void removeUncalledVersions(Stack* versions) {
+    // a version called by a called one is called as well, until no more versions are found
+    bool found = true;
+    while (found) {
+        found = false;
+        for (LinkedNode* node = versions->top; node != NULL; node = node->next) {
+            FunctionVersionPtr version = node->data;
+            if(!version->called && isCalledBy(version, versions)) {
+                version->called = true;
+                found = true;
+            }
+        }
+    }
+
+    for (LinkedNode* node = versions->top; node != NULL; node = node->next) {
+        FunctionVersionPtr version = node->data;
+        if(!version->called) {
+            removeCommands(version->firstCommand, version->lastCommand);
+        }
+    }
+}
+
+/* Checks if a called version or the code of a version of an enclosing block calls the version */
+bool isCalledBy(FunctionVersionPtr version, Stack* versions) {
+    for (LinkedNode* callerNode = version->callers->top; callerNode != NULL; callerNode = callerNode->next) {
+        FunctionVersionPtr callerVersion = callerNode->data;
+        bool blockVersion = false;
+        for (LinkedNode* node = versions->top; node != NULL; node = node->next) {
+            blockVersion = blockVersion || node->data == callerVersion;
+        }
+        if(!blockVersion || callerVersion->called) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void releaseFunctionVersions(Stack* versions) {
+    // the versions of the nested blocks were released before
+    for (int i = 0; i < versions->size; i++) {
+        pop(activeVersions);
+    }
+    while (versions->top != NULL) {
+        freeFunctionVersion(pop(versions));
+    }
+    free(versions);
+}
+
+void freeFunctionVersion(FunctionVersionPtr version) {
+    free(version->targets);
+    free(version->constantPositions);
+    free(version->constants);
+    while (pop(version->callers) != NULL);
+    free(version->callers);
+    free(version);
+}
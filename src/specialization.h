@@ -0,0 +1,77 @@
+/**
+ * This module finds the versions of functions specialized to the functions their function parameters receive, so the
+ * code generator calls those functions directly instead of through their generalized addresses, and to the constants
+ * their integer parameters receive, so the code generator folds them into the version's code
+ *
+ * A version of a function is compiled once all the functions declared with it were, so the functions it receives may
+ * be declared after it. Its bound parameters take no position in its activation record and its calls pass no
+ * arguments for them
+ **/
+
+#ifndef SPECIALIZATION_HEADER
+#define SPECIALIZATION_HEADER
+
+#include "tree.h"
+#include "symboltable.h"
+
+typedef struct {
+    TreeNodePtr functionNode;
+    /* The function the version specializes, every call site not matching a version still calls it */
+    SymbolTableEntryPtr functionEntry;
+    /* The function each function parameter receives, in the order of the parameters */
+    SymbolTableEntryPtr* targets;
+    int targetsCount;
+    /*
+     * The integer parameters by value bound to the constants the calls pass: their positions among all the parameters,
+     * in increasing order, and their values
+     */
+    int* constantPositions;
+    int* constants;
+    int constantsCount;
+    /* Filled by the code generator once the version is added to the symbol table, NULL until then */
+    FunctionDescriptorPtr descriptor;
+    /* Range of the version's commands in the buffer, the last one excluded, filled by the code generator */
+    int firstCommand;
+    int lastCommand;
+    /* Set once a call outside the block's versions runs it, the versions whose code calls it otherwise */
+    bool called;
+    Stack* callers;
+} FunctionVersion, *FunctionVersionPtr;
+
+/*
+ * Finds the versions of the functions declared by the block its body calls with known functions for all their
+ * function parameters: functions or function parameters of a version, the versions found are searched as well.
+ * The integer parameters the function never writes (see the parameter descriptor's readOnly) are bound too when the
+ * call passes them constant expressions and the function is small (see CONSTANT_VERSION_SIZE_LIMIT), a call passing
+ * only constants needs a version as well.
+ * It must be called once all the block's functions were compiled, the names are resolved in the block's scope.
+ * A function using the name of a function declared after it is never specialized, the name would refer to the later
+ * function when the version is compiled.
+ * Returns the versions in the order they must be compiled: the order their functions were declared, a version calls
+ * the versions of the functions declared before it directly. They are found by findCallVersion until released.
+ */
+Stack* findFunctionVersions(TreeNodePtr blockNode);
+
+/*
+ * The compiled version of the called function matching the functions and constants the call passes, NULL if there is
+ * none
+ */
+FunctionVersionPtr findCallVersion(TreeNodePtr callNode, SymbolTableEntryPtr functionEntry);
+
+/* Checks if the version binds the parameter at the given position to a constant, its calls don't pass it */
+bool bindsConstant(FunctionVersionPtr version, int position);
+
+/* Records a call compiled to run the version, from the code of another version or NULL outside any version */
+void addVersionCall(FunctionVersionPtr version, FunctionVersionPtr callerVersion);
+
+/*
+ * Removes the commands of the versions returned by findFunctionVersions no compiled call runs: the calls the search
+ * found may be compiled to run the function itself or left out (ex: in a branch a bound constant discards), the
+ * versions only called by removed versions are removed as well. It must be called once the block's body was compiled
+ */
+void removeUncalledVersions(Stack* versions);
+
+/* Releases the versions returned by findFunctionVersions, the calls compiled afterwards don't use them anymore */
+void releaseFunctionVersions(Stack* versions);
+
+#endif
@@ -0,0 +1,237 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "stats.h"
+#include "slc.h"
+#include "symboltable.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+/**
+ * Phase timing
+ **/
+
+typedef struct {
+    double wallSeconds;
+    double cpuSeconds;
+} PhaseTime;
+
+PhaseTime phaseTimes[PHASES_COUNT];
+
+CompilerPhase currentPhase = NO_PHASE;
+struct timespec phaseWallStart;
+struct timespec phaseCpuStart;
+
+double elapsedSeconds(struct timespec* start, struct timespec* end);
+const char* getPhaseName(CompilerPhase phase);
+
+void switchPhase(CompilerPhase phase) {
+    struct timespec wallNow;
+    struct timespec cpuNow;
+    clock_gettime(CLOCK_MONOTONIC, &wallNow);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuNow);
+
+    if (currentPhase != NO_PHASE) {
+        phaseTimes[currentPhase].wallSeconds += elapsedSeconds(&phaseWallStart, &wallNow);
+        phaseTimes[currentPhase].cpuSeconds += elapsedSeconds(&phaseCpuStart, &cpuNow);
+    }
+
+    currentPhase = phase;
+    phaseWallStart = wallNow;
+    phaseCpuStart = cpuNow;
+}
+
+CompilerPhase enterPhase(CompilerPhase phase) {
+    CompilerPhase previousPhase = currentPhase;
+    if (phase != previousPhase) {
+        switchPhase(phase);
+    }
+    return previousPhase;
+}
+
+void leavePhase(CompilerPhase previousPhase) {
+    if (previousPhase != currentPhase) {
+        switchPhase(previousPhase);
+    }
+}
+
+double elapsedSeconds(struct timespec* start, struct timespec* end) {
+    return (double) (end->tv_sec - start->tv_sec) + (double) (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * Counters
+ **/
+
+typedef struct {
+    long tokens;
+    long treeNodes[NODE_CATEGORIES_COUNT];
+    long symbolTableEntries;
+    int symbolTablePeakDepth;
+    long instructions;
+    size_t peakHeapBytes;
+} CompilerCounters;
+
+CompilerCounters counters;
+
+/*
+ * The heap grows along with the counted items (tokens, tree nodes, symbol table entries and commands), so it is sampled
+ * every HEAP_SAMPLING_INTERVAL of them: mallinfo2 walks the allocator's bins, sampling on every item would slow down
+ * the compilation being measured
+ */
+#define HEAP_SAMPLING_INTERVAL 64
+
+int itemsSinceHeapSample = 0;
+
+void countHeapItem();
+
+int instrumentedYylex() {
+    if (!compilerOptions.timePasses && !compilerOptions.stats) {
+        return yylex();
+    }
+
+    CompilerPhase previousPhase = NO_PHASE;
+    if (compilerOptions.timePasses) {
+        previousPhase = enterPhase(SCANNING_PHASE);
+    }
+
+    int token = yylex();
+    if (compilerOptions.stats) {
+        counters.tokens++;
+        countHeapItem();
+    }
+
+    if (compilerOptions.timePasses) {
+        leavePhase(previousPhase);
+    }
+    return token;
+}
+
+void countTreeNode(NodeCategory category) {
+    counters.treeNodes[category]++;
+    countHeapItem();
+}
+
+void countSymbolTableEntry(int symbolTableDepth) {
+    counters.symbolTableEntries++;
+    if (symbolTableDepth > counters.symbolTablePeakDepth) {
+        counters.symbolTablePeakDepth = symbolTableDepth;
+    }
+    countHeapItem();
+}
+
+void countInstruction() {
+    counters.instructions++;
+    countHeapItem();
+}
+
+void countBufferedCommand() {
+    countHeapItem();
+}
+
+void countHeapItem() {
+    if (++itemsSinceHeapSample >= HEAP_SAMPLING_INTERVAL) {
+        itemsSinceHeapSample = 0;
+        sampleHeapUsage();
+    }
+}
+
+void sampleHeapUsage() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    size_t heapBytes = info.uordblks + info.hblkhd;
+    if (heapBytes > counters.peakHeapBytes) {
+        counters.peakHeapBytes = heapBytes;
+    }
+#endif
+}
+
+/**
+ * Reports
+ **/
+
+void printTimePassesReport();
+void printStatsReport();
+
+void printInstrumentationReports() {
+    if (compilerOptions.timePasses) {
+        // closes the time slice of the phase running when the compiler stopped
+        leavePhase(NO_PHASE);
+        printTimePassesReport();
+    }
+    if (compilerOptions.stats) {
+        sampleHeapUsage();
+        printStatsReport();
+    }
+}
+
+void printTimePassesReport() {
+    double totalWall = 0;
+    double totalCpu = 0;
+    for (int phase = NO_PHASE + 1; phase < PHASES_COUNT; phase++) {
+        totalWall += phaseTimes[phase].wallSeconds;
+        totalCpu += phaseTimes[phase].cpuSeconds;
+    }
+
+    fprintf(stderr, "===== Phase timing =====\n");
+    fprintf(stderr, "%-20s %12s %12s %8s\n", "phase", "wall (ms)", "cpu (ms)", "wall %");
+    for (int phase = NO_PHASE + 1; phase < PHASES_COUNT; phase++) {
+        PhaseTime time = phaseTimes[phase];
+        fprintf(stderr, "%-20s %12.3f %12.3f %7.1f%%\n",
+                getPhaseName(phase),
+                time.wallSeconds * 1e3,
+                time.cpuSeconds * 1e3,
+                totalWall > 0 ? 100 * time.wallSeconds / totalWall : 0);
+    }
+    fprintf(stderr, "%-20s %12.3f %12.3f\n", "total", totalWall * 1e3, totalCpu * 1e3);
+}
+
+void printStatsReport() {
+    long totalTreeNodes = 0;
+    for (int category = 0; category < NODE_CATEGORIES_COUNT; category++) {
+        totalTreeNodes += counters.treeNodes[category];
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    fprintf(stderr, "===== Compilation statistics =====\n");
+    fprintf(stderr, "%-40s %ld\n", "tokens scanned", counters.tokens);
+    fprintf(stderr, "%-40s %ld\n", "tree nodes created", totalTreeNodes);
+    for (int category = 0; category < NODE_CATEGORIES_COUNT; category++) {
+        if (counters.treeNodes[category] > 0) {
+            fprintf(stderr, "  %-38s %ld\n", getCategoryName(category), counters.treeNodes[category]);
+        }
+    }
+    fprintf(stderr, "%-40s %ld\n", "symbol table entries", counters.symbolTableEntries);
+    fprintf(stderr, "%-40s %d\n", "symbol table peak depth", counters.symbolTablePeakDepth);
+    fprintf(stderr, "%-40s %d\n", "MEPA labels allocated", allocatedMEPALabels());
+    fprintf(stderr, "%-40s %ld\n", "MEPA instructions emitted", counters.instructions);
+    fprintf(stderr, "%-40s %zu\n", "peak heap bytes", counters.peakHeapBytes);
+    fprintf(stderr, "%-40s %ld\n", "peak resident set (KiB)", usage.ru_maxrss);
+}
+
+const char* getPhaseName(CompilerPhase phase) {
+    switch (phase) {
+        case NO_PHASE:
+            return "none";
+        case SCANNING_PHASE:
+            return "scanning";
+        case PARSING_PHASE:
+            return "parsing";
+        case TREE_CONSTRUCTION_PHASE:
+            return "tree construction";
+        case SYMBOL_TABLE_PHASE:
+            return "symbol table";
+        case CODE_EMISSION_PHASE:
+            return "MEPA emission";
+        case PHASES_COUNT:
+            break;
+    }
+    return "unknown";
+}
@@ -0,0 +1,67 @@
+/**
+ * This module provides the compiler instrumentation behind the --time-passes and --stats options
+ *
+ * All the hooks are guarded by the options at the call site, so a compilation without those options never reads
+ * a clock nor updates a counter
+ **/
+
+#ifndef STATS_HEADER
+#define STATS_HEADER
+
+#include "options.h"
+#include "tree.h"
+
+/**
+ * Phase timing
+ **/
+typedef enum {
+    NO_PHASE = 0,
+    SCANNING_PHASE,
+    PARSING_PHASE,
+    TREE_CONSTRUCTION_PHASE,
+    SYMBOL_TABLE_PHASE,
+    CODE_EMISSION_PHASE,
+    PHASES_COUNT
+} CompilerPhase;
+
+/*
+ * Phases are nested (the scanner runs inside the parser, the symbol table is used by the code generator), the time is
+ * accounted exclusively: entering a phase pauses the enclosing one until the returned phase is left again
+ */
+CompilerPhase enterPhase(CompilerPhase phase);
+void leavePhase(CompilerPhase previousPhase);
+
+/*
+ * Helpers to time a whole function body, the clock is only read when --time-passes is enabled
+ */
+#define ENTER_PHASE(phase) \
+    CompilerPhase previousPhase = compilerOptions.timePasses ? enterPhase(phase) : NO_PHASE
+#define LEAVE_PHASE() \
+    if (compilerOptions.timePasses) leavePhase(previousPhase)
+
+/*
+ * The parser calls yylex through this function (see parser.y), so scanned tokens can be timed and counted
+ */
+int instrumentedYylex();
+
+/**
+ * Counters
+ **/
+void countTreeNode(NodeCategory category);
+void countSymbolTableEntry(int symbolTableDepth);
+void countInstruction();
+/* A command kept in the buffer until it is printed, it only counts for the heap sampling */
+void countBufferedCommand();
+/*
+ * Samples the heap usage, the counters above sample it as the compiler's data grows, it should also be called at the
+ * points where the heap is expected to be at its largest (ex: before the buffered commands are printed and released)
+ */
+void sampleHeapUsage();
+
+/*
+ * Prints the enabled reports on the standard error, so they do not mix with the generated MEPA code
+ * It is registered to run at exit, since semantic errors terminate the compiler from inside the code generator
+ */
+void printInstrumentationReports();
+
+#endif
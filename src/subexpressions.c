@@ -0,0 +1,438 @@
+#include "subexpressions.h"
+
+#include <stdlib.h>
+
+#include "codegen.h"
+#include "loops.h"
+#include "options.h"
+#include "usage.h"
+
+typedef struct _ValueNumber {
+    CommonSubexpressionCategory category;
+    TreeNodePtr firstUse;
+    TreeNodePtr firstStatement;
+    Stack* uses;
+    SymbolTableEntryPtr array;
+    /* Variables and parameters read by the subscripts */
+    Stack* subscriptEntries;
+    /* Instructions computing the address */
+    int cost;
+    /* The address number a value number was loaded from */
+    struct _ValueNumber* address;
+    /* Uses of an address number whose values are loaded from a value temporary, so they don't load the address */
+    int coveredUses;
+    bool alive;
+    bool kept;
+} ValueNumber, *ValueNumberPtr;
+
+typedef struct {
+    Map* hoisted;
+    /* Every number given in the run, the most recent one on top */
+    Stack* numbers;
+    TreeNodePtr statement;
+} NumberingSearch;
+
+bool isRunStatement(TreeNodePtr statementNode, bool first);
+TreeNodePtr getRunAssignment(TreeNodePtr statementNode);
+void numberStatement(NumberingSearch* search, TreeNodePtr assignmentNode);
+void numberExpression(NumberingSearch* search, TreeNodePtr node);
+bool numberExpressionNode(TreeNodePtr node, void* context);
+void numberArrayValue(NumberingSearch* search, TreeNodePtr valueNode, bool loaded);
+ValueNumberPtr findAliveNumber(NumberingSearch* search, TreeNodePtr valueNode, CommonSubexpressionCategory category);
+ValueNumberPtr newValueNumber(NumberingSearch* search, CommonSubexpressionCategory category, TreeNodePtr valueNode,
+                              SymbolTableEntryPtr array, int cost);
+bool collectSubscriptEntry(TreeNodePtr node, void* context);
+void killNumbers(NumberingSearch* search, SymbolTableEntryPtr assignedEntry);
+bool mayAlias(SymbolTableEntryPtr assignedEntry, SymbolTableEntryPtr readEntry);
+
+int addressCost(TreeNodePtr valueNode, SymbolTableEntryPtr entry);
+int expressionCost(TreeNodePtr node);
+
+void selectSubexpressions(NumberingSearch* search, StraightLineRunPtr run);
+CommonSubexpressionPtr newCommonSubexpression(ValueNumberPtr number);
+void freeValueNumber(ValueNumberPtr number);
+bool byUseNode(void* data, void* secondParam);
+
+static const bool expressionValuesFilter[NODE_CATEGORIES_COUNT] = {
+    [EXPRESSION_NODE] = true,
+    [BINARY_OPERATOR_EXPRESSION_NODE] = true,
+    [UNARY_OPERATOR_EXPRESSION_NODE] = true,
+    [TERM_NODE] = true,
+    [FACTOR_NODE] = true,
+    [VALUE_NODE] = true
+};
+
+static const bool subscriptValuesFilter[NODE_CATEGORIES_COUNT] = {
+    [VALUE_NODE] = true
+};
+
+StraightLineRunPtr findStraightLineRun(TreeNodePtr statementNode, Map* hoistedInvariants) {
+    if(!isRunStatement(statementNode, true)) {
+        return NULL;
+    }
+
+    NumberingSearch search;
+    search.hoisted = hoistedInvariants;
+    search.numbers = newStack();
+
+    StraightLineRunPtr run = malloc(sizeof(StraightLineRun));
+    run->subexpressions = newStack();
+    for (TreeNodePtr current = statementNode; current != NULL && isRunStatement(current, current == statementNode);
+         current = current->next) {
+        search.statement = current;
+        numberStatement(&search, getRunAssignment(current));
+        run->lastStatement = current;
+    }
+
+    selectSubexpressions(&search, run);
+    while (search.numbers->size > 0) {
+        freeValueNumber(pop(search.numbers));
+    }
+    free(search.numbers);
+    return run;
+}
+
+void freeStraightLineRun(StraightLineRunPtr run) {
+    while (run->subexpressions->size > 0) {
+        CommonSubexpressionPtr subexpression = pop(run->subexpressions);
+        while (pop(subexpression->uses) != NULL);
+        free(subexpression->uses);
+        free(subexpression);
+    }
+    free(run->subexpressions);
+    free(run);
+}
+
+CommonSubexpressionPtr findCommonSubexpression(Stack* subexpressions, TreeNodePtr valueNode,
+                                               CommonSubexpressionCategory category) {
+    for (LinkedNode* current = subexpressions->top; current != NULL; current = current->next) {
+        CommonSubexpressionPtr subexpression = (CommonSubexpressionPtr) current->data;
+        if(subexpression->category == category && find(subexpression->uses, valueNode, byUseNode) != NULL) {
+            return subexpression;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * An assignment calling no function, the statements of a body after the first one must not be labeled. Empty
+ * statements end the run, they are only found after labels
+ */
+bool isRunStatement(TreeNodePtr statementNode, bool first) {
+    if(statementNode->category == STATEMENT_NODE && statementNode->subtrees[0]->category == LABEL_NODE && !first) {
+        return false;
+    }
+    TreeNodePtr unlabeledStatementNode = getRunAssignment(statementNode);
+    return unlabeledStatementNode != NULL && unlabeledStatementNode->category == ASSIGNMENT_NODE &&
+           !hasFunctionCall(unlabeledStatementNode);
+}
+
+/* The unlabeled statement of a statement node of a body, the compound statements' ones already are */
+TreeNodePtr getRunAssignment(TreeNodePtr statementNode) {
+    if(statementNode->category != STATEMENT_NODE) {
+        return statementNode;
+    }
+    bool labeled = statementNode->subtrees[0]->category == LABEL_NODE;
+    return labeled ? statementNode->subtrees[1] : statementNode->subtrees[0];
+}
+
+/**
+ * Value numbering
+ **/
+
+/*
+ * The assignment's target is selected before its expression is evaluated, the store happens last: every use in the
+ * statement sees the values from before it
+ */
+void numberStatement(NumberingSearch* search, TreeNodePtr assignmentNode) {
+    TreeNodePtr targetNode = assignmentNode->subtrees[0];
+    SymbolTableEntryPtr targetEntry = findNodeIdentifier(targetNode);
+
+    // the commands of a dead store are left out, its uses would never be compiled
+    if(!compilerOptions.optimizations[DEAD_STORE_ELIMINATION] || targetEntry == NULL ||
+       !isUnusedVariable(targetEntry)) {
+        numberArrayValue(search, targetNode, false);
+        numberExpression(search, assignmentNode->subtrees[1]);
+    }
+    killNumbers(search, targetEntry);
+}
+
+void numberExpression(NumberingSearch* search, TreeNodePtr node) {
+    TreeVisitor visitor = {
+        .preVisit = numberExpressionNode,
+        .postVisit = NULL,
+        .categoryFilter = expressionValuesFilter,
+        .context = search
+    };
+    visitSubtree(node, &visitor);
+}
+
+/* The values of expressions are loaded by their factors, the hoisted parts of the expression are never compiled */
+bool numberExpressionNode(TreeNodePtr node, void* context) {
+    NumberingSearch* search = (NumberingSearch*) context;
+    if(findHoistedInvariant(search->hoisted, node) != NULL) {
+        return false;
+    }
+    if(node->category == VALUE_NODE) {
+        numberArrayValue(search, node, true);
+        return false;
+    }
+    return true;
+}
+
+/* Numbers the address of an array element, and its value when it is loaded, after the loads of its subscripts */
+void numberArrayValue(NumberingSearch* search, TreeNodePtr valueNode, bool loaded) {
+    if(valueNode == NULL || valueNode->subtrees[1] == NULL || findHoistedInvariant(search->hoisted, valueNode) != NULL) {
+        return;
+    }
+    for (TreeNodePtr indexNode = valueNode->subtrees[1]; indexNode != NULL; indexNode = indexNode->next) {
+        numberExpression(search, indexNode->subtrees[0]);
+    }
+
+    SymbolTableEntryPtr entry = findNodeIdentifier(valueNode);
+    int cost = entry == NULL ? -1 : addressCost(valueNode, entry);
+    // a single instruction already selects the element
+    if(cost <= 1) {
+        return;
+    }
+
+    ValueNumberPtr address = findAliveNumber(search, valueNode, COMMON_ADDRESS);
+    if(address == NULL) {
+        address = newValueNumber(search, COMMON_ADDRESS, valueNode, entry, cost);
+    }
+    push(address->uses, valueNode);
+
+    TypeDescriptorPtr elementType = getEntryType(entry);
+    for (TreeNodePtr indexNode = valueNode->subtrees[1]; indexNode != NULL; indexNode = indexNode->next) {
+        elementType = elementType->description.arrayDescriptor->elementType;
+    }
+    if(!loaded || elementType->size != 1) {
+        return;
+    }
+
+    ValueNumberPtr value = findAliveNumber(search, valueNode, COMMON_VALUE);
+    if(value == NULL) {
+        value = newValueNumber(search, COMMON_VALUE, valueNode, entry, cost);
+        value->address = address;
+    }
+    push(value->uses, valueNode);
+}
+
+ValueNumberPtr findAliveNumber(NumberingSearch* search, TreeNodePtr valueNode, CommonSubexpressionCategory category) {
+    for (LinkedNode* current = search->numbers->top; current != NULL; current = current->next) {
+        ValueNumberPtr number = (ValueNumberPtr) current->data;
+        if(number->alive && number->category == category && equalTrees(number->firstUse, valueNode)) {
+            return number;
+        }
+    }
+    return NULL;
+}
+
+ValueNumberPtr newValueNumber(NumberingSearch* search, CommonSubexpressionCategory category, TreeNodePtr valueNode,
+                              SymbolTableEntryPtr array, int cost) {
+    ValueNumberPtr number = malloc(sizeof(ValueNumber));
+    number->category = category;
+    number->firstUse = valueNode;
+    number->firstStatement = search->statement;
+    number->uses = newStack();
+    number->array = array;
+    number->subscriptEntries = newStack();
+    number->cost = cost;
+    number->address = NULL;
+    number->coveredUses = 0;
+    number->alive = true;
+    number->kept = false;
+
+    TreeVisitor visitor = {
+        .preVisit = collectSubscriptEntry,
+        .postVisit = NULL,
+        .categoryFilter = subscriptValuesFilter,
+        .context = number->subscriptEntries
+    };
+    for (TreeNodePtr indexNode = valueNode->subtrees[1]; indexNode != NULL; indexNode = indexNode->next) {
+        visitSubtree(indexNode->subtrees[0], &visitor);
+    }
+
+    push(search->numbers, number);
+    return number;
+}
+
+bool collectSubscriptEntry(TreeNodePtr node, void* context) {
+    SymbolTableEntryPtr entry = findNodeIdentifier(node);
+    if(entry != NULL && entry->category != CONSTANT_SYMBOL) {
+        push((Stack*) context, entry);
+    }
+    return true;
+}
+
+/* An undeclared target is reported by the code generator, nothing is known about it */
+void killNumbers(NumberingSearch* search, SymbolTableEntryPtr assignedEntry) {
+    for (LinkedNode* current = search->numbers->top; current != NULL; current = current->next) {
+        ValueNumberPtr number = (ValueNumberPtr) current->data;
+        if(!number->alive) {
+            continue;
+        }
+        if(assignedEntry == NULL || (number->category == COMMON_VALUE && mayAlias(assignedEntry, number->array))) {
+            number->alive = false;
+            continue;
+        }
+        for (LinkedNode* entry = number->subscriptEntries->top; entry != NULL; entry = entry->next) {
+            if(mayAlias(assignedEntry, entry->data)) {
+                number->alive = false;
+                break;
+            }
+        }
+    }
+}
+
+/*
+ * A variable of an enclosing function or a parameter by reference may be an alias of any other one of them, the
+ * current function's variables can only be assigned by their own name
+ */
+bool mayAlias(SymbolTableEntryPtr assignedEntry, SymbolTableEntryPtr readEntry) {
+    return assignedEntry == readEntry || (!isLocalEntry(assignedEntry) && !isLocalEntry(readEntry));
+}
+
+/**
+ * Costs
+ **/
+
+/*
+ * Instructions leaving the address of the element on the stack, following processArraySubscripts: the base address,
+ * then each subscript and its indexing. With the folding of constant subscripts, only the runtime part of a subscript
+ * is indexed, and an element of a local array with only constant subscripts takes none. -1 for invalid values
+ */
+int addressCost(TreeNodePtr valueNode, SymbolTableEntryPtr entry) {
+    TypeDescriptorPtr type = getEntryType(entry);
+    if(type == NULL || type->category != ARRAY_TYPE) {
+        return -1;
+    }
+
+    bool folded = compilerOptions.optimizations[FOLD_CONSTANT_INDICES] ||
+                  compilerOptions.optimizations[LINEARIZE_ARRAY_ADDRESSING];
+    int cost = 1;
+    int constantOffset = 0;
+    for (TreeNodePtr indexNode = valueNode->subtrees[1]; indexNode != NULL; indexNode = indexNode->next) {
+        if(type->category != ARRAY_TYPE) {
+            return -1;
+        }
+        type = type->description.arrayDescriptor->elementType;
+
+        int constant;
+        TreeNodePtr variablePart = folded ?
+                                   splitSubscript(indexNode->subtrees[0],
+                                                  compilerOptions.optimizations[LINEARIZE_ARRAY_ADDRESSING],
+                                                  &constant) :
+                                   indexNode->subtrees[0];
+        if(variablePart != NULL) {
+            cost += expressionCost(variablePart) + 1;
+        } else {
+            constantOffset += constant;
+        }
+    }
+
+    if(folded && valueFromEntry(entry).category == ARRAY_REFERENCE && constantOffset != 0) {
+        cost += 2;
+    } else if(folded && valueFromEntry(entry).category == ARRAY_VALUE && cost == 1 && type->category != ARRAY_TYPE) {
+        return 0;
+    }
+    return cost;
+}
+
+/* Instructions evaluating a single word expression, term or factor */
+int expressionCost(TreeNodePtr node) {
+    switch (node->category) {
+        case EXPRESSION_NODE:
+        case BINARY_OPERATOR_EXPRESSION_NODE:
+        case TERM_NODE:
+            if(node->subtrees[1] == NULL) {
+                return expressionCost(node->subtrees[0]);
+            }
+            return expressionCost(node->subtrees[0]) + expressionCost(node->subtrees[2]) + 1;
+        case UNARY_OPERATOR_EXPRESSION_NODE: {
+            int cost = node->subtrees[0]->subtrees[0]->category != PLUS_NODE ? 1 : 0;
+            cost += expressionCost(node->subtrees[1]);
+            if(node->subtrees[2] != NULL) {
+                cost += expressionCost(node->subtrees[3]) + 1;
+            }
+            return cost;
+        }
+        case FACTOR_NODE: {
+            TreeNodePtr specificFactorNode = node->subtrees[0];
+            if(specificFactorNode->category == EXPRESSION_NODE) {
+                return expressionCost(specificFactorNode);
+            }
+            if(specificFactorNode->category != VALUE_NODE || specificFactorNode->subtrees[1] == NULL) {
+                return 1;
+            }
+
+            SymbolTableEntryPtr entry = findNodeIdentifier(specificFactorNode);
+            int cost = entry == NULL ? -1 : addressCost(specificFactorNode, entry);
+            return cost < 0 ? 1 : cost + 1;
+        }
+        default:
+            return 1;
+    }
+}
+
+/**
+ * Selection
+ **/
+
+/*
+ * A value loaded n times from a temporary saves n loads of the element but costs its store and n loads of the
+ * temporary. The values are selected first, the address of an element whose loads were selected is then only loaded
+ * once more by the evaluation of the value
+ */
+void selectSubexpressions(NumberingSearch* search, StraightLineRunPtr run) {
+    for (LinkedNode* current = search->numbers->top; current != NULL; current = current->next) {
+        ValueNumberPtr number = (ValueNumberPtr) current->data;
+        int uses = number->uses->size;
+        if(number->category == COMMON_VALUE && uses * (number->cost + 1) > number->cost + 2 + uses) {
+            number->kept = true;
+            number->address->coveredUses += uses - 1;
+        }
+    }
+
+    for (LinkedNode* current = search->numbers->top; current != NULL; current = current->next) {
+        ValueNumberPtr number = (ValueNumberPtr) current->data;
+        int uses = number->uses->size - number->coveredUses;
+        if(number->category == COMMON_ADDRESS && uses * number->cost > number->cost + 1 + uses) {
+            number->kept = true;
+        }
+    }
+
+    // the numbers were pushed in the order of their first uses, the first one ends on top of the run's stack
+    for (LinkedNode* current = search->numbers->top; current != NULL; current = current->next) {
+        ValueNumberPtr number = (ValueNumberPtr) current->data;
+        if(number->kept) {
+            push(run->subexpressions, newCommonSubexpression(number));
+        }
+    }
+}
+
+CommonSubexpressionPtr newCommonSubexpression(ValueNumberPtr number) {
+    CommonSubexpressionPtr subexpression = malloc(sizeof(CommonSubexpression));
+    subexpression->category = number->category;
+    subexpression->uses = number->uses;
+    subexpression->firstUse = number->firstUse;
+    subexpression->firstStatement = number->firstStatement;
+    subexpression->displacement = -1;
+    subexpression->type = NULL;
+    number->uses = NULL;
+    return subexpression;
+}
+
+void freeValueNumber(ValueNumberPtr number) {
+    if(number->uses != NULL) {
+        while (pop(number->uses) != NULL);
+        free(number->uses);
+    }
+    while (pop(number->subscriptEntries) != NULL);
+    free(number->subscriptEntries);
+    free(number);
+}
+
+bool byUseNode(void* data, void* secondParam) {
+    return data == secondParam;
+}
@@ -0,0 +1,59 @@
+/**
+ * This module numbers the array element addresses and values of straight-line code, so the code generator can compute
+ * the repeated ones once into temporaries
+ *
+ * Straight-line code is a run of assignments following each other in a statement list, without function calls (a call
+ * may write anything, and its commands may be inlined) and without labels after the first one (a goto entering the
+ * run would skip the temporaries). Like the loop analyses, the run is searched when the code generator reaches it, so
+ * identifiers are resolved in the scope it is compiled in
+ **/
+
+#ifndef SUBEXPRESSIONS_HEADER
+#define SUBEXPRESSIONS_HEADER
+
+#include "tree.h"
+#include "symboltable.h"
+
+typedef enum {
+    /* The address of an array element, its uses are the array value nodes loaded or assigned */
+    COMMON_ADDRESS,
+    /* The single word value of an array element, its uses are the array value nodes loaded by factors */
+    COMMON_VALUE
+} CommonSubexpressionCategory;
+
+typedef struct {
+    CommonSubexpressionCategory category;
+    /* Array value nodes selecting the same element, while nothing the element depends on is assigned */
+    Stack* uses;
+    TreeNodePtr firstUse;
+    /* The statement of the run before which the subexpression is evaluated, the one of its first use */
+    TreeNodePtr firstStatement;
+    /* Filled by the code generator: the temporary keeping the subexpression and the type of the element */
+    int displacement;
+    TypeDescriptorPtr type;
+} CommonSubexpression, *CommonSubexpressionPtr;
+
+typedef struct {
+    /* The last statement of the run, an element of the same statement list as the first one */
+    TreeNodePtr lastStatement;
+    /* The subexpressions worth a temporary, in the order of their first uses (the first one on top) */
+    Stack* subexpressions;
+} StraightLineRun, *StraightLineRunPtr;
+
+/*
+ * Finds the run starting at the given statement (a statement node of a body or an unlabeled statement of a compound
+ * statement), NULL if the statement doesn't start one. Nodes already in hoistedInvariants are not numbered.
+ * Value numbers are given by the structure of the array value nodes: the same array with the same subscripts. The
+ * number of an address dies with an assignment to a variable its subscripts read, and the number of a value also
+ * dies with an assignment to its array. A variable of an enclosing function and a parameter by reference may alias
+ * each other, so an assignment to one of them also kills the numbers depending on the other ones.
+ * Only the subexpressions saving instructions are kept: a temporary costs a store, then a load for each use.
+ */
+StraightLineRunPtr findStraightLineRun(TreeNodePtr statementNode, Map* hoistedInvariants);
+void freeStraightLineRun(StraightLineRunPtr run);
+
+/* Finds the subexpression of the given category one of whose uses is the node, NULL if there is none */
+CommonSubexpressionPtr findCommonSubexpression(Stack* subexpressions, TreeNodePtr valueNode,
+                                               CommonSubexpressionCategory category);
+
+#endif
@@ -1,12 +1,17 @@
 #include "symboltable.h"
+#include "stats.h"
 
 #include <stdio.h>
 #include <string.h>
 
 #define FUNCTION_PARAMETERS_DISPLACEMENT -5;
+#define UNUSED_VARIABLE_DISPLACEMENT -1
 
 int currentFunctionLevel = 0;
+/* Symbols of the inlined bodies being compiled, they are always on top of the stack */
+int inlinedSymbols = 0;
 int totalParametersSize(ParameterPtr parameter);
+int parameterSize(ParameterPtr parameter);
 
 /**
  * Symbol Table
@@ -16,6 +21,8 @@ void addSymbolTableEntry(SymbolTableEntryPtr entry);
 
 ParameterDescriptorsListPtr newParameterDescriptors(ParameterPtr parameter);
 ParameterDescriptorsListPtr addParameterEntries(ParameterPtr parameters);
+void addParameter(char* identifier, ParameterDescriptorPtr parameterDescriptor);
+void addConstant(int level, char* identifier, int value, TypeDescriptorPtr typeDescriptor);
 
 SymbolTablePtr symbolTable = NULL;
 SymbolTablePtr getSymbolTable() {
@@ -37,7 +44,10 @@ bool byIdentifierPredicate(void* data, void* secondParam) {
     return false;
 }
 SymbolTableEntryPtr findIdentifier(char* identifier) {
-    return (SymbolTableEntryPtr) find(getSymbolTable()->stack, identifier, byIdentifierPredicate);
+    ENTER_PHASE(SYMBOL_TABLE_PHASE);
+    SymbolTableEntryPtr entry = (SymbolTableEntryPtr) find(getSymbolTable()->stack, identifier, byIdentifierPredicate);
+    LEAVE_PHASE();
+    return entry;
 }
 
 /*
@@ -54,7 +64,16 @@ FunctionDescriptorPtr findCurrentFunctionDescriptor() {
         return getSymbolTable()->mainFunctionDescriptor;
     }
 
-    SymbolTableEntryPtr entry = (SymbolTableEntryPtr) find(getSymbolTable()->stack, &currentFunctionLevel, byLastFunctionInLevel);
+    ENTER_PHASE(SYMBOL_TABLE_PHASE);
+    // an inlined body is compiled in its caller, even if it sees other functions of the caller's level
+    Stack* stack = getSymbolTable()->stack;
+    Stack scope = {stack->top, stack->size};
+    for (int i = 0; i < inlinedSymbols; i++) {
+        scope.top = scope.top->next;
+        scope.size--;
+    }
+    SymbolTableEntryPtr entry = (SymbolTableEntryPtr) find(&scope, &currentFunctionLevel, byLastFunctionInLevel);
+    LEAVE_PHASE();
 
     if(entry == NULL || entry->category != FUNCTION_SYMBOL) {
         fprintf(stderr, "Expected current function descriptor but got a %s\n", getSymbolTableCategoryName(entry->category));
@@ -70,7 +89,7 @@ TypeDescriptorPtr newFunctionType(FunctionHeaderPtr functionHeader) {
     functionTypeDescriptor->parameters = newParameterDescriptors(functionHeader->parameters);
     functionTypeDescriptor->returnType = functionHeader->returnType;
 
-    TypeDescriptorPtr type = malloc(sizeof(TypeDescriptorPtr));
+    TypeDescriptorPtr type = malloc(sizeof(TypeDescriptor));
     type->category = FUNCTION_TYPE;
     type->size = 3; // generalized address
     type->description.functionTypeDescriptor = functionTypeDescriptor;
@@ -83,7 +102,18 @@ TypeDescriptorPtr newArrayType(int dimension, TypeDescriptorPtr elementType) {
     arrayDescriptor->dimension = dimension;
     arrayDescriptor->elementType = elementType;
 
-    TypeDescriptorPtr typeDescriptor = malloc(sizeof(TypeDescriptorPtr));
+    // the strides of the element subscripts follow the stride of this array subscript
+    arrayDescriptor->subscripts = 1;
+    if(elementType->category == ARRAY_TYPE) {
+        arrayDescriptor->subscripts += elementType->description.arrayDescriptor->subscripts;
+    }
+    arrayDescriptor->strides = malloc(arrayDescriptor->subscripts * sizeof(int));
+    arrayDescriptor->strides[0] = elementType->size;
+    for (int i = 1; i < arrayDescriptor->subscripts; i++) {
+        arrayDescriptor->strides[i] = elementType->description.arrayDescriptor->strides[i - 1];
+    }
+
+    TypeDescriptorPtr typeDescriptor = malloc(sizeof(TypeDescriptor));
     typeDescriptor->category = ARRAY_TYPE;
     typeDescriptor->size = dimension * elementType->size;
     typeDescriptor->description.arrayDescriptor = arrayDescriptor;
@@ -102,6 +132,9 @@ SymbolTableEntryPtr addFunction(FunctionHeaderPtr functionHeader) {
     functionDescriptor->returnMepaLabel = nextMEPALabel();
     functionDescriptor->bodyMepaLabel = -1; // this label is only created if needed
     functionDescriptor->variablesDisplacement = 0;
+    functionDescriptor->temporariesDisplacement = 0;
+    functionDescriptor->frameAllocationCommand = -1;
+    functionDescriptor->localsLevel = currentFunctionLevel;
     functionDescriptor->parametersSize = totalParametersSize(functionHeader->parameters);
     functionDescriptor->returnType = functionHeader->returnType;
     functionDescriptor->parameters = addParameterEntries(functionHeader->parameters);
@@ -133,6 +166,9 @@ FunctionDescriptorPtr addMainFunction() {
     FunctionDescriptorPtr functionDescriptor = malloc(sizeof(FunctionDescriptor));
 
     functionDescriptor->variablesDisplacement = 0;
+    functionDescriptor->temporariesDisplacement = 0;
+    functionDescriptor->frameAllocationCommand = -1;
+    functionDescriptor->localsLevel = currentFunctionLevel;
     functionDescriptor->headerMepaLabel = -1; // main can't be invoked
     functionDescriptor->returnMepaLabel = -1; // main can't have a return
     functionDescriptor->bodyMepaLabel = -1; // this label is only created if needed
@@ -150,6 +186,8 @@ void addLabel(char* identifier) {
     LabelDescriptorPtr labelDescriptor = malloc(sizeof(LabelDescriptor));
     labelDescriptor->mepaLabel = nextMEPALabel();
     labelDescriptor->defined = false;
+    labelDescriptor->nonLocalGoto = false;
+    labelDescriptor->commandIndex = -1;
 
     SymbolTableEntryPtr symbol = malloc(sizeof(SymbolTableEntry));
     symbol->category = LABEL_SYMBOL;
@@ -177,8 +215,48 @@ void addVariable(char* identifier, TypeDescriptorPtr typeDescriptor) {
 
     variableDescriptor->displacement = functionDescriptor->variablesDisplacement;
     functionDescriptor->variablesDisplacement += typeDescriptor->size;
+    functionDescriptor->temporariesDisplacement = functionDescriptor->variablesDisplacement;
+
+    variableDescriptor->type = typeDescriptor;
+    variableDescriptor->level = functionDescriptor->localsLevel;
+
+    SymbolTableEntryPtr symbol = malloc(sizeof(SymbolTableEntry));
+    symbol->category = VARIABLE_SYMBOL;
+    symbol->level = currentFunctionLevel;
+    symbol->identifier = identifier;
+    symbol->description.variableDescriptor = variableDescriptor;
+
+    addSymbolTableEntry(symbol);
+}
+
+void addVariableAt(char* identifier, TypeDescriptorPtr typeDescriptor, int displacement) {
+    FunctionDescriptorPtr functionDescriptor = findCurrentFunctionDescriptor();
+
+    VariableDescriptorPtr variableDescriptor = malloc(sizeof(VariableDescriptor));
+    variableDescriptor->displacement = displacement;
+    variableDescriptor->type = typeDescriptor;
+    // the result's position is in the parameters area, which is always in the function's own activation record
+    variableDescriptor->level = displacement < 0 ? currentFunctionLevel : functionDescriptor->localsLevel;
+
+    if(displacement + typeDescriptor->size > functionDescriptor->variablesDisplacement) {
+        functionDescriptor->variablesDisplacement = displacement + typeDescriptor->size;
+        functionDescriptor->temporariesDisplacement = functionDescriptor->variablesDisplacement;
+    }
+
+    SymbolTableEntryPtr symbol = malloc(sizeof(SymbolTableEntry));
+    symbol->category = VARIABLE_SYMBOL;
+    symbol->level = currentFunctionLevel;
+    symbol->identifier = identifier;
+    symbol->description.variableDescriptor = variableDescriptor;
+
+    addSymbolTableEntry(symbol);
+}
 
+void addUnusedVariable(char* identifier, TypeDescriptorPtr typeDescriptor) {
+    VariableDescriptorPtr variableDescriptor = malloc(sizeof(VariableDescriptor));
+    variableDescriptor->displacement = UNUSED_VARIABLE_DISPLACEMENT;
     variableDescriptor->type = typeDescriptor;
+    variableDescriptor->level = currentFunctionLevel;
 
     SymbolTableEntryPtr symbol = malloc(sizeof(SymbolTableEntry));
     symbol->category = VARIABLE_SYMBOL;
@@ -189,6 +267,27 @@ void addVariable(char* identifier, TypeDescriptorPtr typeDescriptor) {
     addSymbolTableEntry(symbol);
 }
 
+bool isUnusedVariable(SymbolTableEntryPtr entry) {
+    return entry != NULL && entry->category == VARIABLE_SYMBOL &&
+           entry->description.variableDescriptor->displacement == UNUSED_VARIABLE_DISPLACEMENT;
+}
+
+void addBoundFunctionParameter(char* identifier, TypeDescriptorPtr functionType, SymbolTableEntryPtr function) {
+    ParameterDescriptorPtr parameterDescriptor = malloc(sizeof(ParameterDescriptor));
+    parameterDescriptor->displacement = 0;
+    parameterDescriptor->type = functionType;
+    parameterDescriptor->parameterPassage = FUNCTION_PARAMETER;
+    parameterDescriptor->byAddress = false;
+    parameterDescriptor->readOnly = false;
+    parameterDescriptor->boundFunction = function;
+
+    addParameter(identifier, parameterDescriptor);
+}
+
+void addBoundValueParameter(char* identifier, TypeDescriptorPtr type, int value) {
+    addConstant(currentFunctionLevel, identifier, value, type);
+}
+
 
 TypeDescriptorPtr newPredefinedTypeDescriptor(int size, PredefinedType predefinedType) {
 
@@ -229,7 +328,7 @@ void initializeSymbolTable() {
     TypeDescriptorPtr integerTypeDescriptor = newPredefinedTypeDescriptor(1, INTEGER);
     TypeDescriptorPtr booleanTypeDescriptor = newPredefinedTypeDescriptor(1, BOOLEAN);
 
-    symbolTable = malloc(sizeof(SymbolTablePtr));
+    symbolTable = malloc(sizeof(SymbolTable));
     symbolTable->stack = newStack();
     symbolTable->integerTypeDescriptor = integerTypeDescriptor;
     symbolTable->booleanTypeDescriptor = booleanTypeDescriptor;
@@ -245,14 +344,23 @@ void initializeSymbolTable() {
 }
 
 void addSymbolTableEntry(SymbolTableEntryPtr entry) {
-    push(getSymbolTable()->stack, entry);
+    ENTER_PHASE(SYMBOL_TABLE_PHASE);
+    Stack* stack = getSymbolTable()->stack;
+    push(stack, entry);
+    if (compilerOptions.stats) {
+        countSymbolTableEntry(stack->size);
+    }
+    LEAVE_PHASE();
 }
 
 ParameterDescriptorPtr newParameterDescriptor(ParameterPtr parameter, int displacement) {
-    ParameterDescriptorPtr parameterDescriptor = malloc(sizeof(ParameterDescriptorPtr));
+    ParameterDescriptorPtr parameterDescriptor = malloc(sizeof(ParameterDescriptor));
     parameterDescriptor->displacement = displacement;
     parameterDescriptor->type = parameter->type;
     parameterDescriptor->parameterPassage = parameter->passage;
+    parameterDescriptor->byAddress = parameter->byAddress;
+    parameterDescriptor->readOnly = parameter->readOnly;
+    parameterDescriptor->boundFunction = NULL;
 
     return parameterDescriptor;
 }
@@ -260,34 +368,30 @@ ParameterDescriptorPtr newParameterDescriptor(ParameterPtr parameter, int displa
 /*
  * The parameters list of type ParameterPtr comes from the compiler in the order of the parameters declaration
  */
-ParameterDescriptorsListPtr newParameterDescriptorsRec(ParameterPtr parameter, int* displacement) {
-    if(parameter == NULL) {
-        return NULL;
-    }
-
-    // Process the parameters in inversed order to calculate the displacement correctly,
-    // so the first declared parameter will be in the lowest parameter position of the stack
-    // this allows pushing arguments in they declared order too
-    ParameterDescriptorsListPtr nextParameters = newParameterDescriptorsRec(parameter->next, displacement);
+ParameterDescriptorsListPtr newParameterDescriptors(ParameterPtr parameters) {
+    // The first declared parameter is in the lowest parameter position of the stack, this allows pushing arguments in
+    // their declared order, so the parameters start below the whole parameters area
+    int displacement = 1 + FUNCTION_PARAMETERS_DISPLACEMENT;
+    displacement -= totalParametersSize(parameters);
 
-    if(parameter->passage == VARIABLE_PARAMETER) {
-        // a parameter by reference has only it's address on the stack, therefore it occupies only one position
-        *displacement -= 1;
-    } else {
-        // a parameter by value has its whole value on the stack, therefore it's size is the same as it's type
-        *displacement -= parameter->type->size;
-    }
+    ParameterDescriptorsListPtr parameterDescriptors = NULL;
+    ParameterDescriptorsListPtr lastParameterDescriptor = NULL;
+    for (ParameterPtr parameter = parameters; parameter != NULL; parameter = parameter->next) {
+        ParameterDescriptorsListPtr parameterDescriptor = malloc(sizeof(ParameterDescriptorsList));
+        parameterDescriptor->descriptor = newParameterDescriptor(parameter, displacement);
+        parameterDescriptor->next = NULL;
 
-    ParameterDescriptorsListPtr parameterDescriptor = malloc(sizeof(ParameterDescriptorsList));
-    parameterDescriptor->descriptor = newParameterDescriptor(parameter, *displacement);
-    parameterDescriptor->next = nextParameters;
+        if(lastParameterDescriptor == NULL) {
+            parameterDescriptors = parameterDescriptor;
+        } else {
+            lastParameterDescriptor->next = parameterDescriptor;
+        }
+        lastParameterDescriptor = parameterDescriptor;
 
-    return parameterDescriptor;
-}
-ParameterDescriptorsListPtr newParameterDescriptors(ParameterPtr parameters) {
-    int displacement = 1 + FUNCTION_PARAMETERS_DISPLACEMENT;
+        displacement += parameterSize(parameter);
+    }
 
-    return newParameterDescriptorsRec(parameters, &displacement);
+    return parameterDescriptors;
 }
 
 void addParameter(char* identifier, ParameterDescriptorPtr parameterDescriptor) {
@@ -315,6 +419,39 @@ ParameterDescriptorsListPtr addParameterEntries(ParameterPtr parameters) {
     return parameterDescriptors;
 }
 
+/**
+ * Compiler temporaries
+ **/
+
+int allocateTemporary(FunctionDescriptorPtr functionDescriptor, int size) {
+    int displacement = functionDescriptor->temporariesDisplacement;
+    functionDescriptor->temporariesDisplacement += size;
+    if(functionDescriptor->temporariesDisplacement > functionDescriptor->variablesDisplacement) {
+        functionDescriptor->variablesDisplacement = functionDescriptor->temporariesDisplacement;
+    }
+    return displacement;
+}
+
+void releaseTemporaries(FunctionDescriptorPtr functionDescriptor, int displacement) {
+    functionDescriptor->temporariesDisplacement = displacement;
+}
+
+/**
+ * Inlined scopes
+ **/
+
+void addInlinedSymbol(SymbolTableEntryPtr entry) {
+    addSymbolTableEntry(entry);
+    inlinedSymbols++;
+}
+
+void removeInlinedSymbols(int count) {
+    for (int i = 0; i < count; i++) {
+        pop(getSymbolTable()->stack);
+    }
+    inlinedSymbols -= count;
+}
+
 /**
  * Level counter
  **/
@@ -322,7 +459,12 @@ int getFunctionLevel() {
     return currentFunctionLevel;
 }
 
+int getLocalsLevel() {
+    return findCurrentFunctionDescriptor()->localsLevel;
+}
+
 void endFunctionLevel() {
+    ENTER_PHASE(SYMBOL_TABLE_PHASE);
     SymbolTablePtr symbolTablePtr = getSymbolTable();
     currentFunctionLevel--;
 
@@ -349,6 +491,7 @@ void endFunctionLevel() {
         push(symbolTablePtr->stack, poped);
     }
     free(auxStack);
+    LEAVE_PHASE();
 }
 
 /**
@@ -359,6 +502,10 @@ int nextMEPALabel(){
     return ++mepaLabelCounter;
 }
 
+int allocatedMEPALabels() {
+    return mepaLabelCounter;
+}
+
 /**
  * Type Compatibility
  **/
@@ -424,24 +571,6 @@ Value variableSymbolToValue(SymbolTableEntryPtr entry);
 Value parameterSymbolToValue(SymbolTableEntryPtr entry);
 Value constantSymbolToValue(SymbolTableEntryPtr entry);
 
-ParameterPtr concatenateParameters(ParameterPtr parameters1, ParameterPtr parameters2) {
-    if(parameters1 == NULL) {
-        return parameters2;
-    }
-
-    if(parameters2 == NULL) {
-        return parameters1;
-    }
-
-    ParameterPtr current = parameters1;
-    while (current->next != NULL) {
-        current = current->next;
-    }
-    current->next = parameters2;
-
-    return parameters1;
-}
-
 Value valueFromEntry(SymbolTableEntryPtr entry) {
     switch(entry->category) {
         case VARIABLE_SYMBOL: {
@@ -474,7 +603,7 @@ void freeFunctionHeader(FunctionHeaderPtr functionHeader) {
 Value variableSymbolToValue(SymbolTableEntryPtr entry) {
     Value value;
     value.type = entry->description.variableDescriptor->type;
-    value.level = entry->level;
+    value.level = entry->description.variableDescriptor->level;
     value.content.displacement = entry->description.variableDescriptor->displacement;
 
     switch(entry->description.variableDescriptor->type->category) {
@@ -509,7 +638,7 @@ Value parameterSymbolToValue(SymbolTableEntryPtr entry) {
             }
             break;
         case ARRAY_TYPE:
-            if(parameterDescriptor->parameterPassage == VARIABLE_PARAMETER) {
+            if(parameterDescriptor->parameterPassage == VARIABLE_PARAMETER || parameterDescriptor->byAddress) {
                 value.category = ARRAY_REFERENCE;
             } else {
                 value.category = ARRAY_VALUE;
@@ -536,16 +665,21 @@ int totalParametersSize(ParameterPtr parameter) {
     int size = 0;
     ParameterPtr current = parameter;
     while (current != NULL) {
-        if(current->passage == VARIABLE_PARAMETER) {
-            size += 1;
-        } else {
-            size += current->type->size;
-        }
+        size += parameterSize(current);
         current = current->next;
     }
     return size;
 }
 
+int parameterSize(ParameterPtr parameter) {
+    if(parameter->passage == VARIABLE_PARAMETER || parameter->byAddress) {
+        // a parameter by reference has only it's address on the stack, therefore it occupies only one position
+        return 1;
+    }
+    // a parameter by value has its whole value on the stack, therefore it's size is the same as it's type
+    return parameter->type->size;
+}
+
 /**
  * Debug facilities
  **/
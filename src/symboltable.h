@@ -43,10 +43,17 @@ typedef enum {
 struct _TypeDescriptor;
 struct _ParameterDescriptor;
 struct _ParametersList;
+struct _SymbolTableEntry;
 
 typedef struct {
     int dimension;
     struct _TypeDescriptor* elementType;
+    /*
+     * Number of subscripts this array takes until a non array element is reached (ex: 2 for integer[10][10]) and the
+     * stride of each one of them, i.e. the size of the element selected by the subscript (ex: {10, 1})
+     */
+    int subscripts;
+    int* strides;
 } ArrayDescriptor, *ArrayDescriptorPtr;
 
 typedef struct {
@@ -72,12 +79,20 @@ typedef struct {
 typedef struct {
     int displacement;
     TypeDescriptorPtr type;
+    /* Level of the activation record keeping the variable, see the function descriptor's localsLevel */
+    int level;
 } VariableDescriptor, *VariableDescriptorPtr;
 
 typedef struct _ParameterDescriptor {
     int displacement;
     TypeDescriptorPtr type;
     ParameterPassage parameterPassage;
+    /* An array by value the function never writes, it receives the address of the argument instead of a copy */
+    bool byAddress;
+    /* An integer by value the function never writes, its specialized versions may bind it to the constant passed */
+    bool readOnly;
+    /* The function a function parameter of a specialized version always receives, it is called directly, or NULL */
+    struct _SymbolTableEntry* boundFunction;
 } ParameterDescriptor, *ParameterDescriptorPtr;
 
 typedef struct _ParametersList {
@@ -89,7 +104,17 @@ typedef struct {
     int headerMepaLabel;
     int bodyMepaLabel;
     int returnMepaLabel;
+    /* Size of the activation record's local area: the declared variables and the compiler temporaries */
     int variablesDisplacement;
+    /* Displacement of the next compiler temporary, they are allocated after all the declared variables */
+    int temporariesDisplacement;
+    /* Buffered command allocating the local area, it is completed once the function's temporaries are known */
+    int frameAllocationCommand;
+    /*
+     * Level of the activation record keeping the local area: the function's own level, or the main function's one
+     * for a function never active twice, whose local area is a static part of the main function's one
+     */
+    int localsLevel;
     int parametersSize;
     int returnDisplacement;
     TypeDescriptorPtr returnType;
@@ -100,9 +125,13 @@ typedef struct {
 typedef struct {
     int mepaLabel;
     bool defined;
+    /* A goto of a nested function targets it, entering it must restore the stack to the end of the local area */
+    bool nonLocalGoto;
+    /* Buffered command entering the label, -1 if it isn't buffered */
+    int commandIndex;
 } LabelDescriptor, *LabelDescriptorPtr;
 
-typedef struct {
+typedef struct _SymbolTableEntry {
     SymbolTableCategory category;
     char* identifier;
     int level;
@@ -135,6 +164,8 @@ typedef struct _Parameter {
     ParameterPassage passage;
     struct _Parameter* next;
     TypeDescriptorPtr type;
+    bool byAddress;
+    bool readOnly;
 } Parameter, *ParameterPtr;
 
 typedef struct _FunctionHeader {
@@ -177,12 +208,53 @@ FunctionDescriptorPtr addMainFunction();
 void addLabel(char* identifier);
 void addType(char* identifier, TypeDescriptorPtr typeDescriptor);
 void addVariable(char* identifier, TypeDescriptorPtr typeDescriptor);
+/* Adds a variable at a given displacement, variables whose values aren't needed at the same time may share positions */
+void addVariableAt(char* identifier, TypeDescriptorPtr typeDescriptor, int displacement);
+/*
+ * A variable the function never reads gets no position in the activation record, its entry only serves the semantic
+ * checks of the statements assigning it
+ */
+void addUnusedVariable(char* identifier, TypeDescriptorPtr typeDescriptor);
+bool isUnusedVariable(SymbolTableEntryPtr entry);
+/*
+ * A function parameter of a specialized version, it takes no position in the activation record: every use of it refers
+ * to the given function
+ */
+void addBoundFunctionParameter(char* identifier, TypeDescriptorPtr functionType, SymbolTableEntryPtr function);
+/*
+ * An integer parameter of a specialized version bound to the constant its calls pass, it takes no position in the
+ * activation record either: it is added as a constant, so its uses load the value and fold with the other constants
+ */
+void addBoundValueParameter(char* identifier, TypeDescriptorPtr type, int value);
+
+/**
+ * Compiler temporaries
+ **/
+/*
+ * Temporaries live in the function's activation record after its variables, they are released in the reverse order of
+ * allocation, so the frame only grows to the most temporaries alive at the same time
+ */
+int allocateTemporary(FunctionDescriptorPtr functionDescriptor, int size);
+/* Releases the temporaries allocated from the given displacement on */
+void releaseTemporaries(FunctionDescriptorPtr functionDescriptor, int displacement);
+
+/**
+ * Inlined scopes
+ **/
+/*
+ * The body of an inlined function is compiled inside its caller with the symbols of its own scope, they are added on
+ * top of the caller's symbols (shadowing them) and removed once the body is compiled, the last ones added first
+ */
+void addInlinedSymbol(SymbolTableEntryPtr entry);
+void removeInlinedSymbols(int count);
 
 /**
  * Level counter functions
  **/
 /* Gets the current function level counter value. Attention to the fact that the function level counter isn't thread safe */
 int getFunctionLevel();
+/* Level of the activation record keeping the current function's variables and temporaries, see localsLevel */
+int getLocalsLevel();
 /*
  * It should be called when a function compilation is finished and the compiler will continue to compile the
  * outermost function.
@@ -196,6 +268,8 @@ void endFunctionLevel();
  **/
 /* A MEPA label is simply an integer counter which returns a new integer every time, it isn't thread safe */
 int nextMEPALabel();
+/* Number of MEPA labels handed out so far */
+int allocatedMEPALabels();
 
 /**
  * Type Compatibility functions
@@ -205,7 +279,6 @@ bool equivalentTypes(TypeDescriptorPtr type1, TypeDescriptorPtr type2);
 /**
  * Auxiliary structures functions
  **/
-ParameterPtr concatenateParameters(ParameterPtr parameters1, ParameterPtr parameters2);
 Value valueFromEntry(SymbolTableEntryPtr entry);
 void freeFunctionHeader(FunctionHeaderPtr functionHeader);
 
@@ -1,8 +1,10 @@
 #include "tree.h"
 
 #include "symboltable.h"
+#include "stats.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 /**
  * Always use getStack() to get the stack, it will ensure that the stack is initialized
@@ -10,7 +12,6 @@
 Stack *stack = NULL;
 
 Stack *getStack();
-int count(TreeNodePtr treeNodePtr, NodeCategory category);
 
 void dumpSyntaxTree(TreeNodePtr node, int indent, bool isNext);
 const char *getCategoryName(NodeCategory category);
@@ -39,18 +40,20 @@ void *getTree() {
 void counts(void *p, int *functions, int *funcalls, int *whiles, int *ifs, int *bin) {
     TreeNodePtr treeNodePtr = (TreeNodePtr) p;
 
-    *functions = count(treeNodePtr, FUNCTION_NODE);
-    *funcalls = count(treeNodePtr, FUNCTION_CALL_NODE);
-    *whiles = count(treeNodePtr, WHILE_NODE);
-    *ifs = count(treeNodePtr, IF_NODE);
+    int histogram[NODE_CATEGORIES_COUNT];
+    categoryHistogram(treeNodePtr, histogram);
 
-    int relationalExpressions = count(treeNodePtr, RELATIONAL_OPERATOR_NODE);
-    int additiveExpressions = count(treeNodePtr, ADDITIVE_OPERATOR_NODE);
-    int multiplicativeExpressions = count(treeNodePtr, MULTIPLICATIVE_OPERATOR_NODE);
-    *bin = relationalExpressions + additiveExpressions + multiplicativeExpressions;
+    *functions = histogram[FUNCTION_NODE];
+    *funcalls = histogram[FUNCTION_CALL_NODE];
+    *whiles = histogram[WHILE_NODE];
+    *ifs = histogram[IF_NODE];
+    *bin = histogram[RELATIONAL_OPERATOR_NODE]
+            + histogram[ADDITIVE_OPERATOR_NODE]
+            + histogram[MULTIPLICATIVE_OPERATOR_NODE];
 }
 
 void addTreeNodeWithName(NodeCategory category, int numberOfChildNodes, char *name) {
+    ENTER_PHASE(TREE_CONSTRUCTION_PHASE);
 
     TreeNodePtr node = malloc(sizeof(TreeNode));
     node->category = category;
@@ -69,6 +72,11 @@ void addTreeNodeWithName(NodeCategory category, int numberOfChildNodes, char *na
     }
 
     push(stack, node);
+
+    if (compilerOptions.stats) {
+        countTreeNode(category);
+    }
+    LEAVE_PHASE();
 }
 
 void addTreeNode(NodeCategory category, int numberOfChildNodes) {
@@ -76,6 +84,7 @@ void addTreeNode(NodeCategory category, int numberOfChildNodes) {
 }
 
 void addSequence() {
+    ENTER_PHASE(TREE_CONSTRUCTION_PHASE);
     Stack *stack = getStack();
 
     TreeNodePtr topNode = pop(stack);
@@ -87,6 +96,7 @@ void addSequence() {
     } else {
         push(stack, topNode);
     }
+    LEAVE_PHASE();
 }
 
 void addEmpty() {
@@ -103,24 +113,157 @@ void dumpTree(void *root) {
     dumpSyntaxTree(tree, 0, false);
 }
 
-int count(TreeNodePtr treeNodePtr, NodeCategory category) {
-    if (treeNodePtr == NULL) {
-        return 0;
+/**
+ * Visitor
+ **/
+
+typedef struct {
+    TreeNodePtr node;
+    /* false when the node is entered, true when its subtrees were visited */
+    bool leaving;
+} VisitFrame;
+
+typedef struct {
+    VisitFrame *frames;
+    int size;
+    int capacity;
+} VisitStack;
+
+void pushVisitFrame(VisitStack *pending, TreeNodePtr node, bool leaving) {
+    if (node == NULL) {
+        return;
+    }
+
+    if (pending->size == pending->capacity) {
+        pending->capacity = pending->capacity == 0 ? 64 : 2 * pending->capacity;
+        pending->frames = realloc(pending->frames, pending->capacity * sizeof(VisitFrame));
+    }
+
+    pending->frames[pending->size].node = node;
+    pending->frames[pending->size].leaving = leaving;
+    pending->size++;
+}
+
+void visitNodes(TreeNodePtr root, TreeVisitor *visitor, bool visitRootSequence);
+
+void visitTree(TreeNodePtr root, TreeVisitor *visitor) {
+    visitNodes(root, visitor, true);
+}
+
+void visitSubtree(TreeNodePtr root, TreeVisitor *visitor) {
+    visitNodes(root, visitor, false);
+}
+
+void visitNodes(TreeNodePtr root, TreeVisitor *visitor, bool visitRootSequence) {
+    // the frames are kept on an array instead of the Stack module, a tree traversal pushes every node once or twice
+    // and a malloc per push would dominate the traversal
+    VisitStack pending = {NULL, 0, 0};
+    pushVisitFrame(&pending, root, false);
+
+    while (pending.size > 0) {
+        VisitFrame frame = pending.frames[--pending.size];
+        TreeNodePtr node = frame.node;
+        bool selected = visitor->categoryFilter == NULL || visitor->categoryFilter[node->category];
+
+        if (frame.leaving) {
+            visitor->postVisit(node, visitor->context);
+            continue;
+        }
+
+        bool visitSubtrees = true;
+        if (selected && visitor->preVisit != NULL) {
+            visitSubtrees = visitor->preVisit(node, visitor->context);
+        }
+
+        // pushed in the reverse order of visiting: the sequence, the node's post visit and the subtrees
+        if (node != root || visitRootSequence) {
+            pushVisitFrame(&pending, node->next, false);
+        }
+        if (selected && visitor->postVisit != NULL) {
+            pushVisitFrame(&pending, node, true);
+        }
+        if (visitSubtrees) {
+            for (int i = MAX_CHILD_NODES - 1; i >= 0; i--) {
+                pushVisitFrame(&pending, node->subtrees[i], false);
+            }
+        }
     }
 
-    int nodesWithCategory = 0;
-    if(treeNodePtr->category == category) {
-        nodesWithCategory++;
+    free(pending.frames);
+}
+
+bool countCategory(TreeNodePtr node, void *context) {
+    int *histogram = (int *) context;
+    histogram[node->category]++;
+    return true;
+}
+
+void categoryHistogram(TreeNodePtr root, int histogram[NODE_CATEGORIES_COUNT]) {
+    for (int category = 0; category < NODE_CATEGORIES_COUNT; category++) {
+        histogram[category] = 0;
     }
 
-    nodesWithCategory += count(treeNodePtr->next, category);
+    TreeVisitor visitor = {
+        .preVisit = countCategory,
+        .postVisit = NULL,
+        .categoryFilter = NULL,
+        .context = histogram
+    };
+    visitTree(root, &visitor);
+}
+
+bool equalTrees(TreeNodePtr first, TreeNodePtr second) {
+    if (first == NULL || second == NULL) {
+        return first == second;
+    }
+    if (first->category != second->category) {
+        return false;
+    }
+    if ((first->name == NULL) != (second->name == NULL) ||
+        (first->name != NULL && strcmp(first->name, second->name) != 0)) {
+        return false;
+    }
 
     for (int i = 0; i < MAX_CHILD_NODES; i++) {
-        TreeNodePtr child = treeNodePtr->subtrees[i];
-        nodesWithCategory += count(child, category);
+        TreeNodePtr firstChild = first->subtrees[i];
+        TreeNodePtr secondChild = second->subtrees[i];
+        while (firstChild != NULL && secondChild != NULL) {
+            if (!equalTrees(firstChild, secondChild)) {
+                return false;
+            }
+            firstChild = firstChild->next;
+            secondChild = secondChild->next;
+        }
+        if (firstChild != secondChild) {
+            return false;
+        }
     }
+    return true;
+}
 
-    return nodesWithCategory;
+TreeNodePtr getSingleValueNode(TreeNodePtr expressionNode) {
+    TreeNodePtr node = expressionNode;
+    while (node != NULL) {
+        switch (node->category) {
+            case EXPRESSION_NODE:
+            case BINARY_OPERATOR_EXPRESSION_NODE:
+            case TERM_NODE:
+                if (node->subtrees[1] != NULL) {
+                    return NULL;
+                }
+                node = node->subtrees[0];
+                break;
+            case FACTOR_NODE:
+                // a value or parenthesized expression
+                node = node->subtrees[0];
+                break;
+            case VALUE_NODE:
+                return node;
+            default:
+                return NULL;
+        }
+    }
+    return NULL;
 }
 
 Stack *getStack() {
@@ -130,29 +273,53 @@ Stack *getStack() {
     return stack;
 }
 
-void dumpSyntaxTree(TreeNodePtr node, int indent, bool isNext) {
+typedef struct {
+    TreeNodePtr node;
+    int indent;
+    bool isNext;
+} DumpFrame;
+
+void pushDumpFrame(Stack *pending, TreeNodePtr node, int indent, bool isNext) {
     if(node == NULL) {
         return;
     }
 
-    addIndent(indent);
-    if(isNext) {
-        printf("|-> ");
-    }
+    DumpFrame *frame = malloc(sizeof(DumpFrame));
+    frame->node = node;
+    frame->indent = indent;
+    frame->isNext = isNext;
+    push(pending, frame);
+}
 
-    if(node->name == NULL) {
-        printf("%s\n", getCategoryName(node->category));
-    } else {
-        printf("%s(%s)\n", getCategoryName(node->category), node->name);
-    }
+void dumpSyntaxTree(TreeNodePtr root, int indent, bool isNext) {
+    Stack *pending = newStack();
+    pushDumpFrame(pending, root, indent, isNext);
 
-    for (int i = MAX_CHILD_NODES-1; i >= 0; i--) {
-        TreeNodePtr subtree = node->subtrees[i];
-        dumpSyntaxTree(subtree, indent + 1, false);
-    }
+    while (pending->size > 0) {
+        DumpFrame *frame = pop(pending);
+        TreeNodePtr node = frame->node;
+
+        addIndent(frame->indent);
+        if(frame->isNext) {
+            printf("|-> ");
+        }
+
+        if(node->name == NULL) {
+            printf("%s\n", getCategoryName(node->category));
+        } else {
+            printf("%s(%s)\n", getCategoryName(node->category), node->name);
+        }
 
-    dumpSyntaxTree(node->next, indent, true);
+        // pushed in the reverse order of printing: the subtrees from the last to the first and then the sequence
+        pushDumpFrame(pending, node->next, frame->indent, true);
+        for (int i = 0; i < MAX_CHILD_NODES; i++) {
+            pushDumpFrame(pending, node->subtrees[i], frame->indent + 1, false);
+        }
+
+        free(frame);
+    }
 
+    free(pending);
 }
 
 void addIndent(int indent) {
@@ -1,3 +1,6 @@
+#ifndef TREE_HEADER
+#define TREE_HEADER
+
 #include "utils.h"
 
 #define MAX_CHILD_NODES 5
@@ -71,6 +74,9 @@ typedef enum {
     AND_NODE
 } NodeCategory;
 
+/* Categories start at 1, so this is also the size of an array indexed by category */
+#define NODE_CATEGORIES_COUNT (AND_NODE + 1)
+
 typedef struct _treeNode {
     NodeCategory category;
     char *name;
@@ -82,6 +88,46 @@ typedef struct _treeNode {
 void *getTree();
 void counts(void *p, int *functions, int *funcalls, int *whiles, int *ifs, int *bin);
 
+/**
+ * Visitor
+ *
+ * The tree is traversed iteratively (the C stack does not grow with the tree), the subtrees of a node are visited in
+ * order, then the node's sequence (the "next" nodes)
+ **/
+typedef struct {
+    /* Called before the subtrees of a node, returning false skips its subtrees but not its sequence */
+    bool (*preVisit)(TreeNodePtr node, void *context);
+    /* Called after all the subtrees of a node were visited */
+    void (*postVisit)(TreeNodePtr node, void *context);
+    /*
+     * Array indexed by NodeCategory, only nodes whose category is marked are handed to the callbacks, the other ones
+     * are still traversed. NULL hands every node to the callbacks
+     */
+    const bool *categoryFilter;
+    void *context;
+} TreeVisitor;
+
+void visitTree(TreeNodePtr root, TreeVisitor *visitor);
+/* Like visitTree, but the sequence of the root itself is not visited (ex: the statements following a statement) */
+void visitSubtree(TreeNodePtr root, TreeVisitor *visitor);
+
+/*
+ * Counts the nodes of each category in a single traversal, the histogram is indexed by NodeCategory
+ */
+void categoryHistogram(TreeNodePtr root, int histogram[NODE_CATEGORIES_COUNT]);
+
+/*
+ * Checks if two subtrees are structurally equal: same categories and names, the sequences of their subtrees included
+ * (the sequences of the roots themselves are not compared)
+ */
+bool equalTrees(TreeNodePtr first, TreeNodePtr second);
+
+/*
+ * The value node of an expression made of a single value (ex: an argument by reference), NULL for other expressions.
+ * The expression may also be a binary operator expression or term node
+ */
+TreeNodePtr getSingleValueNode(TreeNodePtr expressionNode);
+
 /**
  * Initializes a tree node considering that the "numberOfChildNodes" top elements on the stack
  * are the subtrees of the new node.
@@ -105,3 +151,5 @@ void addIdentifier(char *tokenValue);
  **/
 void dumpTree(void *p);
 const char *getCategoryName(NodeCategory category);
+
+#endif
@@ -0,0 +1,470 @@
+#include "usage.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    char* identifier;
+    /* Variables already found unused, the assignments to them are discarded */
+    Stack* unusedVariables;
+    /* Nested functions being searched, the innermost one on top */
+    Stack* functions;
+    bool used;
+} UsageSearch;
+
+typedef struct {
+    char* identifier;
+    /* The function whose parameter is searched, NULL when searching the variables of a block */
+    FunctionHeaderPtr functionHeader;
+    /* The functions it declares may shadow the ones visible in the symbol table */
+    TreeNodePtr blockNode;
+    bool written;
+} WriteSearch;
+
+typedef struct {
+    char* identifier;
+    bool found;
+} IdentifierSearch;
+
+typedef struct {
+    TreeNodePtr variablesNode;
+    /* The variable returned so far, NULL before the first return */
+    char* identifier;
+    bool returnsOther;
+} ReturnSearch;
+
+bool isVariableUnused(TreeNodePtr blockNode, char* identifier, Stack* unusedVariables);
+void searchBlock(TreeNodePtr blockNode, UsageSearch* search);
+bool findVariableUse(TreeNodePtr node, void* context);
+bool isDiscardedAssignment(TreeNodePtr assignmentNode, UsageSearch* search);
+bool findFunctionCall(TreeNodePtr node, void* context);
+bool declaresIdentifier(void* data, void* secondParam);
+bool listsIdentifier(TreeNodePtr identifierNode, char* identifier);
+bool byName(void* data, void* secondParam);
+void searchWrites(TreeNodePtr blockNode, WriteSearch* search);
+bool findWrite(TreeNodePtr node, void* context);
+ParameterPassage findArgumentPassage(char* function, int position, WriteSearch* search);
+ParameterPassage findPassageAt(ParameterDescriptorsListPtr parameters, int position);
+ParameterPassage findHeaderPassageAt(ParameterPtr parameters, int position);
+bool declaresFunction(TreeNodePtr blockNode, char* identifier);
+bool findFunctionHeader(TreeNodePtr node, void* context);
+bool findValue(TreeNodePtr node, void* context);
+bool findReturn(TreeNodePtr node, void* context);
+
+Stack* findUnusedVariables(TreeNodePtr blockNode) {
+    Stack* unusedVariables = newStack();
+    TreeNodePtr variablesNode = blockNode->subtrees[2];
+    if(variablesNode == NULL) {
+        return unusedVariables;
+    }
+
+    // a variable found unused may make the ones only read by its assignments unused too
+    bool found = true;
+    while (found) {
+        found = false;
+        for (TreeNodePtr declarationNode = variablesNode->subtrees[0]; declarationNode != NULL;
+             declarationNode = declarationNode->next) {
+            for (TreeNodePtr identifierNode = declarationNode->subtrees[0]; identifierNode != NULL;
+                 identifierNode = identifierNode->next) {
+                if(!isListedIdentifier(unusedVariables, identifierNode->name) &&
+                   isVariableUnused(blockNode, identifierNode->name, unusedVariables)) {
+                    push(unusedVariables, identifierNode->name);
+                    found = true;
+                }
+            }
+        }
+    }
+    return unusedVariables;
+}
+
+bool isListedIdentifier(Stack* identifiers, char* identifier) {
+    return find(identifiers, identifier, byName) != NULL;
+}
+
+void freeIdentifiers(Stack* identifiers) {
+    while (pop(identifiers) != NULL);
+    free(identifiers);
+}
+
+bool isVariableUnused(TreeNodePtr blockNode, char* identifier, Stack* unusedVariables) {
+    UsageSearch search = {
+        .identifier = identifier,
+        .unusedVariables = unusedVariables,
+        .functions = newStack(),
+        .used = false
+    };
+    searchBlock(blockNode, &search);
+    free(search.functions);
+    return !search.used;
+}
+
+void searchBlock(TreeNodePtr blockNode, UsageSearch* search) {
+    TreeVisitor visitor = {
+        .preVisit = findVariableUse,
+        .postVisit = NULL,
+        .categoryFilter = NULL,
+        .context = search
+    };
+    visitSubtree(blockNode->subtrees[4], &visitor);
+
+    TreeNodePtr functionsNode = blockNode->subtrees[3];
+    if(functionsNode == NULL) {
+        return;
+    }
+    for (TreeNodePtr functionNode = functionsNode->subtrees[0]; functionNode != NULL && !search->used;
+         functionNode = functionNode->next) {
+        if(!declaresIdentifier(functionNode, search->identifier)) {
+            push(search->functions, functionNode);
+            searchBlock(functionNode->subtrees[1], search);
+            pop(search->functions);
+        }
+    }
+}
+
+bool findVariableUse(TreeNodePtr node, void* context) {
+    UsageSearch* search = (UsageSearch*) context;
+    if(search->used) {
+        return false;
+    }
+
+    switch (node->category) {
+        case ASSIGNMENT_NODE: {
+            TreeNodePtr identifierNode = node->subtrees[0]->subtrees[0];
+            if(strcmp(identifierNode->name, search->identifier) == 0) {
+                // the value only flows back into the variable (ex: "i = i + 1"), unless a call may have side effects
+                search->used = hasFunctionCall(node);
+                return false;
+            }
+            if(isDiscardedAssignment(node, search)) {
+                return false;
+            }
+            break;
+        }
+        case IDENTIFIER_NODE:
+            if(strcmp(node->name, search->identifier) == 0) {
+                search->used = true;
+            }
+            break;
+        default:
+            break;
+    }
+    return !search->used;
+}
+
+/* An assignment to a variable already found unused, unless a nested function being searched declares its target */
+bool isDiscardedAssignment(TreeNodePtr assignmentNode, UsageSearch* search) {
+    char* target = assignmentNode->subtrees[0]->subtrees[0]->name;
+    return isListedIdentifier(search->unusedVariables, target) &&
+           find(search->functions, target, declaresIdentifier) == NULL &&
+           !hasFunctionCall(assignmentNode);
+}
+
+static const bool callsFilter[NODE_CATEGORIES_COUNT] = {
+    [FUNCTION_CALL_NODE] = true
+};
+
+bool hasFunctionCall(TreeNodePtr node) {
+    bool found = false;
+    TreeVisitor visitor = {
+        .preVisit = findFunctionCall,
+        .postVisit = NULL,
+        .categoryFilter = callsFilter,
+        .context = &found
+    };
+    visitSubtree(node, &visitor);
+    return found;
+}
+
+bool findFunctionCall(TreeNodePtr node, void* context) {
+    *((bool*) context) = true;
+    return false;
+}
+
+/* Checks if a nested function declares its own parameter or variable with the given name, shadowing the variable */
+bool declaresIdentifier(void* data, void* secondParam) {
+    TreeNodePtr functionNode = (TreeNodePtr) data;
+    char* identifier = (char*) secondParam;
+
+    TreeNodePtr headerNode = functionNode->subtrees[0];
+    for (TreeNodePtr parameterNode = headerNode->subtrees[2]; parameterNode != NULL;
+         parameterNode = parameterNode->next) {
+        TreeNodePtr identifierNode = parameterNode->category == FUNCTION_PARAMETER_NODE ?
+                                     parameterNode->subtrees[0]->subtrees[1] : parameterNode->subtrees[0];
+        if(listsIdentifier(identifierNode, identifier)) {
+            return true;
+        }
+    }
+
+    TreeNodePtr variablesNode = functionNode->subtrees[1]->subtrees[2];
+    if(variablesNode == NULL) {
+        return false;
+    }
+    for (TreeNodePtr declarationNode = variablesNode->subtrees[0]; declarationNode != NULL;
+         declarationNode = declarationNode->next) {
+        if(listsIdentifier(declarationNode->subtrees[0], identifier)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool listsIdentifier(TreeNodePtr identifierNode, char* identifier) {
+    for (TreeNodePtr current = identifierNode; current != NULL; current = current->next) {
+        if(strcmp(current->name, identifier) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool byName(void* data, void* secondParam) {
+    return strcmp((char*) data, (char*) secondParam) == 0;
+}
+
+/**
+ * Writes
+ **/
+
+static const bool writesFilter[NODE_CATEGORIES_COUNT] = {
+    [ASSIGNMENT_NODE] = true,
+    [FUNCTION_CALL_NODE] = true
+};
+
+bool isReadOnlyParameter(TreeNodePtr functionNode, FunctionHeaderPtr functionHeader, char* identifier) {
+    WriteSearch search = {
+        .identifier = identifier,
+        .functionHeader = functionHeader,
+        .blockNode = functionNode->subtrees[1],
+        .written = false
+    };
+    searchWrites(functionNode->subtrees[1], &search);
+    return !search.written;
+}
+
+bool isWrittenByNestedFunctions(TreeNodePtr blockNode, char* identifier) {
+    WriteSearch search = {
+        .identifier = identifier,
+        .functionHeader = NULL,
+        .blockNode = blockNode,
+        .written = false
+    };
+
+    TreeNodePtr functionsNode = blockNode->subtrees[3];
+    if(functionsNode == NULL) {
+        return false;
+    }
+    for (TreeNodePtr functionNode = functionsNode->subtrees[0]; functionNode != NULL && !search.written;
+         functionNode = functionNode->next) {
+        if(!declaresIdentifier(functionNode, identifier)) {
+            searchWrites(functionNode->subtrees[1], &search);
+        }
+    }
+    return search.written;
+}
+
+void searchWrites(TreeNodePtr blockNode, WriteSearch* search) {
+    TreeVisitor visitor = {
+        .preVisit = findWrite,
+        .postVisit = NULL,
+        .categoryFilter = writesFilter,
+        .context = search
+    };
+    visitSubtree(blockNode->subtrees[4], &visitor);
+
+    TreeNodePtr functionsNode = blockNode->subtrees[3];
+    if(functionsNode == NULL) {
+        return;
+    }
+    for (TreeNodePtr functionNode = functionsNode->subtrees[0]; functionNode != NULL && !search->written;
+         functionNode = functionNode->next) {
+        if(!declaresIdentifier(functionNode, search->identifier)) {
+            searchWrites(functionNode->subtrees[1], search);
+        }
+    }
+}
+
+bool findWrite(TreeNodePtr node, void* context) {
+    WriteSearch* search = (WriteSearch*) context;
+    if(search->written) {
+        return false;
+    }
+
+    if(node->category == ASSIGNMENT_NODE) {
+        search->written = strcmp(node->subtrees[0]->subtrees[0]->name, search->identifier) == 0;
+        return !search->written;
+    }
+
+    int position = 0;
+    for (TreeNodePtr argumentNode = node->subtrees[1]; argumentNode != NULL; argumentNode = argumentNode->next) {
+        TreeNodePtr valueNode = getSingleValueNode(argumentNode);
+        if(valueNode != NULL && strcmp(valueNode->subtrees[0]->name, search->identifier) == 0 &&
+           findArgumentPassage(node->subtrees[0]->name, position, search) != VALUE_PARAMETER) {
+            search->written = true;
+            return false;
+        }
+        position++;
+    }
+    return true;
+}
+
+/* Passage of the parameter at the given position of the called function, by reference if it can't be resolved */
+ParameterPassage findArgumentPassage(char* function, int position, WriteSearch* search) {
+    if(declaresFunction(search->blockNode, function)) {
+        return VARIABLE_PARAMETER;
+    }
+
+    FunctionHeaderPtr functionHeader = search->functionHeader;
+    if(functionHeader != NULL) {
+        if(strcmp(functionHeader->name, function) == 0) {
+            return findHeaderPassageAt(functionHeader->parameters, position);
+        }
+        for (ParameterPtr parameter = functionHeader->parameters; parameter != NULL; parameter = parameter->next) {
+            if(strcmp(parameter->name, function) == 0) {
+                return parameter->passage == FUNCTION_PARAMETER ?
+                       findPassageAt(parameter->type->description.functionTypeDescriptor->parameters, position) :
+                       VARIABLE_PARAMETER;
+            }
+        }
+    }
+
+    SymbolTableEntryPtr entry = findIdentifier(function);
+    if(entry == NULL) {
+        return VARIABLE_PARAMETER;
+    }
+    switch (entry->category) {
+        case PSEUDO_FUNCTION_SYMBOL:
+            return entry->description.pseudoFunction == WRITE ? VALUE_PARAMETER : VARIABLE_PARAMETER;
+        case FUNCTION_SYMBOL:
+            return findPassageAt(entry->description.functionDescriptor->parameters, position);
+        case PARAMETER_SYMBOL: {
+            TypeDescriptorPtr type = entry->description.parameterDescriptor->type;
+            return type->category == FUNCTION_TYPE ?
+                   findPassageAt(type->description.functionTypeDescriptor->parameters, position) :
+                   VARIABLE_PARAMETER;
+        }
+        default:
+            return VARIABLE_PARAMETER;
+    }
+}
+
+ParameterPassage findPassageAt(ParameterDescriptorsListPtr parameters, int position) {
+    ParameterDescriptorsListPtr parameter = parameters;
+    for (int i = 0; i < position && parameter != NULL; i++) {
+        parameter = parameter->next;
+    }
+    return parameter != NULL ? parameter->descriptor->parameterPassage : VARIABLE_PARAMETER;
+}
+
+ParameterPassage findHeaderPassageAt(ParameterPtr parameters, int position) {
+    ParameterPtr parameter = parameters;
+    for (int i = 0; i < position && parameter != NULL; i++) {
+        parameter = parameter->next;
+    }
+    return parameter != NULL ? parameter->passage : VARIABLE_PARAMETER;
+}
+
+static const bool headersFilter[NODE_CATEGORIES_COUNT] = {
+    [FUNCTION_HEADER_NODE] = true
+};
+
+/* Checks if the block declares a function or function parameter with the given name, in its nested functions too */
+bool declaresFunction(TreeNodePtr blockNode, char* identifier) {
+    IdentifierSearch search = {
+        .identifier = identifier,
+        .found = false
+    };
+    TreeVisitor visitor = {
+        .preVisit = findFunctionHeader,
+        .postVisit = NULL,
+        .categoryFilter = headersFilter,
+        .context = &search
+    };
+    visitSubtree(blockNode, &visitor);
+    return search.found;
+}
+
+bool findFunctionHeader(TreeNodePtr node, void* context) {
+    IdentifierSearch* search = (IdentifierSearch*) context;
+    if(strcmp(node->subtrees[1]->name, search->identifier) == 0) {
+        search->found = true;
+    }
+    return !search->found;
+}
+
+static const bool valuesFilter[NODE_CATEGORIES_COUNT] = {
+    [VALUE_NODE] = true
+};
+
+bool isPassedAsArgument(TreeNodePtr blockNode, char* identifier) {
+    IdentifierSearch search = {
+        .identifier = identifier,
+        .found = false
+    };
+    TreeVisitor visitor = {
+        .preVisit = findValue,
+        .postVisit = NULL,
+        .categoryFilter = valuesFilter,
+        .context = &search
+    };
+    visitSubtree(blockNode, &visitor);
+    return search.found;
+}
+
+bool findValue(TreeNodePtr node, void* context) {
+    IdentifierSearch* search = (IdentifierSearch*) context;
+    if(strcmp(node->subtrees[0]->name, search->identifier) == 0) {
+        search->found = true;
+    }
+    return !search->found;
+}
+
+/**
+ * Returns
+ **/
+
+static const bool returnsFilter[NODE_CATEGORIES_COUNT] = {
+    [RETURN_NODE] = true
+};
+
+char* findReturnedVariable(TreeNodePtr blockNode) {
+    ReturnSearch search = {
+        .variablesNode = blockNode->subtrees[2],
+        .identifier = NULL,
+        .returnsOther = false
+    };
+    if(search.variablesNode == NULL) {
+        return NULL;
+    }
+
+    TreeVisitor visitor = {
+        .preVisit = findReturn,
+        .postVisit = NULL,
+        .categoryFilter = returnsFilter,
+        .context = &search
+    };
+    visitSubtree(blockNode->subtrees[4], &visitor);
+    return search.returnsOther ? NULL : search.identifier;
+}
+
+bool findReturn(TreeNodePtr node, void* context) {
+    ReturnSearch* search = (ReturnSearch*) context;
+    TreeNodePtr valueNode = node->subtrees[0] != NULL ? getSingleValueNode(node->subtrees[0]) : NULL;
+    if(valueNode == NULL || valueNode->subtrees[1] != NULL) {
+        search->returnsOther = true;
+        return false;
+    }
+
+    char* identifier = valueNode->subtrees[0]->name;
+    if(search->identifier == NULL) {
+        bool declared = false;
+        for (TreeNodePtr declarationNode = search->variablesNode->subtrees[0]; declarationNode != NULL && !declared;
+             declarationNode = declarationNode->next) {
+            declared = listsIdentifier(declarationNode->subtrees[0], identifier);
+        }
+        search->returnsOther = !declared;
+        search->identifier = identifier;
+    } else if(strcmp(search->identifier, identifier) != 0) {
+        search->returnsOther = true;
+    }
+    return false;
+}
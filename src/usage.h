@@ -0,0 +1,55 @@
+/**
+ * This module finds how a function uses its variables and parameters: the variables it declares but never reads, so
+ * the code generator can leave them out of the activation record along with the stores to them, and the arrays it
+ * never writes or returns, so they can be passed and returned without copies
+ **/
+
+#ifndef USAGE_HEADER
+#define USAGE_HEADER
+
+#include "tree.h"
+#include "symboltable.h"
+
+/*
+ * Finds the variables of the block that its body and its nested functions (the ones not declaring a parameter or
+ * variable with the same name) only use in assignments to themselves without function calls: their stores are dead
+ * and discarding them discards no side effect.
+ * Reads inside the assignments to the variables found don't count either, so a variable only copied to unused
+ * variables is unused too. It is conservative: any other occurrence of the identifier counts as a read, a read
+ * statement or an argument passed by reference included.
+ * Returns the identifiers found, they are looked up with isListedIdentifier and released with freeIdentifiers
+ */
+Stack* findUnusedVariables(TreeNodePtr blockNode);
+
+bool isListedIdentifier(Stack* identifiers, char* identifier);
+void freeIdentifiers(Stack* identifiers);
+
+/*
+ * Checks if a function never writes one of its parameters: its body and nested functions (the ones not declaring the
+ * same name) never assign it, read into it nor pass it, or one of its elements, on to a parameter by reference.
+ * The called functions are resolved by name, like the compiler resolves them when it reaches the call (the function
+ * itself, its function parameters and the functions visible where it is declared), it must be called before the
+ * function is added to the symbol table. Functions it can't resolve are taken as receiving their arguments by reference
+ */
+bool isReadOnlyParameter(TreeNodePtr functionNode, FunctionHeaderPtr functionHeader, char* identifier);
+
+/*
+ * Checks if the nested functions of a block may write one of its variables, the calls are resolved like
+ * isReadOnlyParameter resolves them, so the functions declared inside the block are taken as receiving their arguments
+ * by reference
+ */
+bool isWrittenByNestedFunctions(TreeNodePtr blockNode, char* identifier);
+
+/* Checks if the subtree calls a function, a pseudo function included */
+bool hasFunctionCall(TreeNodePtr node);
+
+/* Checks if the name of a function declared by the block is used as a value in the block, i.e. passed as an argument */
+bool isPassedAsArgument(TreeNodePtr blockNode, char* identifier);
+
+/*
+ * The variable of the block returned by every return statement of its body, NULL if there are none or one returns
+ * anything else (an element of the variable included)
+ */
+char* findReturnedVariable(TreeNodePtr blockNode);
+
+#endif
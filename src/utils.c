@@ -1,9 +1,11 @@
 #include "utils.h"
 #include "slc.h"
+#include "stats.h"
 
 #include <stdlib.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdint.h>
 
 /**
  * Stack
@@ -64,19 +66,189 @@ void freeLinkedNode(LinkedNode* node) {
     free(node);
 }
 
+/**
+ * Map
+ **/
+
+#define MAP_INITIAL_CAPACITY 16
+
+MapItem* findMapItem(MapItem* items, int capacity, void* key);
+
+Map* newMap() {
+    Map* map = malloc(sizeof(Map));
+    map->capacity = MAP_INITIAL_CAPACITY;
+    map->size = 0;
+    map->items = calloc(map->capacity, sizeof(MapItem));
+    return map;
+}
+
+void mapPut(Map* map, void* key, void* value) {
+    MapItem* item = findMapItem(map->items, map->capacity, key);
+    if(item->key == NULL) {
+        // open addressing: grows at half full so the probe sequences stay short
+        if(2 * (map->size + 1) > map->capacity) {
+            MapItem* items = map->items;
+            int capacity = map->capacity;
+            map->capacity *= 2;
+            map->items = calloc(map->capacity, sizeof(MapItem));
+            for (int i = 0; i < capacity; i++) {
+                if(items[i].key != NULL) {
+                    *findMapItem(map->items, map->capacity, items[i].key) = items[i];
+                }
+            }
+            free(items);
+            item = findMapItem(map->items, map->capacity, key);
+        }
+        item->key = key;
+        map->size++;
+    }
+    item->value = value;
+}
+
+void* mapGet(Map* map, void* key) {
+    return findMapItem(map->items, map->capacity, key)->value;
+}
+
+void freeMap(Map* map, void (*freeValue)(void*)) {
+    for (int i = 0; freeValue != NULL && i < map->capacity; i++) {
+        if(map->items[i].value != NULL) {
+            freeValue(map->items[i].value);
+        }
+    }
+    free(map->items);
+    free(map);
+}
+
+/* The item of the key, or the empty one where it would be put (the capacity is a power of two) */
+MapItem* findMapItem(MapItem* items, int capacity, void* key) {
+    // Fibonacci hashing, the low bits of an address are the same for every allocation
+    uintptr_t hash = (uintptr_t) key * (uintptr_t) 0x9E3779B97F4A7C15ULL;
+    int index = (int) ((hash >> (sizeof(uintptr_t) * 8 / 2)) & (uintptr_t) (capacity - 1));
+    while (items[index].key != NULL && items[index].key != key) {
+        index = (index + 1) & (capacity - 1);
+    }
+    return &items[index];
+}
+
 /**
  * Code generation functions
  **/
 
+typedef struct {
+    char** commands;
+    int size;
+    int capacity;
+} CommandsBuffer;
+
+bool buffering = false;
+bool discarding = false;
+CommandsBuffer buffer = {NULL, 0, 0};
+
+void printCommand(const char* command);
+char* formatCommand(const char* commandFormat, va_list args);
+
 void addCommand(const char* commandFormat, ...) {
+    if (discarding) {
+        return;
+    }
+
     va_list args;
     va_start(args, commandFormat);
-    printf("\t");
-    vprintf(commandFormat, args);
-    printf("\n");
+    if (buffering) {
+        int index = addPlaceholderCommand();
+        buffer.commands[index] = formatCommand(commandFormat, args);
+
+        if (compilerOptions.stats) {
+            countBufferedCommand();
+        }
+    } else {
+        printf("\t");
+        vprintf(commandFormat, args);
+        printf("\n");
+
+        if (compilerOptions.stats) {
+            countInstruction();
+        }
+    }
     va_end(args);
 }
 
+void enableCommandsBuffering() {
+    buffering = true;
+}
+
+bool commandsBuffered() {
+    return buffering;
+}
+
+int addPlaceholderCommand() {
+    if (buffer.size == buffer.capacity) {
+        buffer.capacity = buffer.capacity == 0 ? 1024 : 2 * buffer.capacity;
+        buffer.commands = realloc(buffer.commands, buffer.capacity * sizeof(char*));
+    }
+    buffer.commands[buffer.size] = NULL;
+    return buffer.size++;
+}
+
+void replaceCommand(int index, const char* commandFormat, ...) {
+    va_list args;
+    va_start(args, commandFormat);
+    free(buffer.commands[index]);
+    buffer.commands[index] = formatCommand(commandFormat, args);
+    va_end(args);
+}
+
+int nextCommandIndex() {
+    return buffer.size;
+}
+
+const char* getCommand(int index) {
+    return buffer.commands[index];
+}
+
+void removeCommands(int first, int last) {
+    for (int i = first; i < last; i++) {
+        free(buffer.commands[i]);
+        buffer.commands[i] = NULL;
+    }
+}
+
+void discardCommands(bool discard) {
+    discarding = discard;
+}
+
+void flushCommands() {
+    if (compilerOptions.stats) {
+        sampleHeapUsage();
+    }
+    for (int i = 0; i < buffer.size; i++) {
+        if (buffer.commands[i] != NULL) {
+            printCommand(buffer.commands[i]);
+            free(buffer.commands[i]);
+        }
+    }
+    buffer.size = 0;
+}
+
+void printCommand(const char* command) {
+    printf("\t%s\n", command);
+
+    if (compilerOptions.stats) {
+        countInstruction();
+    }
+}
+
+char* formatCommand(const char* commandFormat, va_list args) {
+    va_list lengthArgs;
+    va_copy(lengthArgs, args);
+    int length = vsnprintf(NULL, 0, commandFormat, lengthArgs);
+    va_end(lengthArgs);
+
+    char* command = malloc(length + 1);
+    vsnprintf(command, length + 1, commandFormat, args);
+    return command;
+}
+
 /**
  * Semantic Error Treatment
  **/
@@ -87,6 +259,8 @@ void throwSemanticError(const char* messageFormat, ...) {
 
     char message[500];
     vsprintf(message, messageFormat, args);
+    // the code generated until the error is part of the compiler output
+    flushCommands();
     SemanticError(message);
 
     va_end(args);
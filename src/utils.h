@@ -35,6 +35,32 @@ void* pop(Stack* stack);
  */
 void* find(Stack* stack, void* secondParam, bool (*predicate)(void*, void*));
 
+/**
+ * Map
+ **/
+/*
+ * Hash map whose keys are compared by address (ex: symbol table entries or tree nodes), for the lookups repeated once
+ * per statement that a search through a stack would make quadratic
+ */
+typedef struct {
+    void* key;
+    void* value;
+} MapItem;
+
+typedef struct {
+    MapItem* items;
+    int capacity;
+    int size;
+} Map;
+
+Map* newMap();
+/* Replaces the value of a key already in the map, a NULL value makes mapGet behave as if the key was never put */
+void mapPut(Map* map, void* key, void* value);
+/* The value of the key, NULL if it isn't in the map */
+void* mapGet(Map* map, void* key);
+/* Frees the map and, if freeValue isn't NULL, calls it with each value */
+void freeMap(Map* map, void (*freeValue)(void*));
+
 /**
  * Code generation functions
  **/
@@ -43,6 +69,31 @@ void* find(Stack* stack, void* secondParam, bool (*predicate)(void*, void*));
  */
 void addCommand(const char* commandFormat, ...);
 
+/*
+ * Commands are printed as soon as they are added, unless buffering is enabled: then they are kept until flushCommands,
+ * so the code generator can still rewrite a command emitted earlier (ex: the frame allocation of a function whose
+ * frame grows with compiler temporaries while its body is compiled)
+ */
+void enableCommandsBuffering();
+bool commandsBuffered();
+/* Adds an empty buffered command and returns its index, it is only printed if replaceCommand fills it */
+int addPlaceholderCommand();
+void replaceCommand(int index, const char* commandFormat, ...);
+/* Index the next buffered command will have */
+int nextCommandIndex();
+/* The buffered command at the index, NULL for a placeholder or a removed command */
+const char* getCommand(int index);
+/* Discards the buffered commands from the first index up to the last one, excluded */
+void removeCommands(int first, int last);
+/*
+ * While commands are discarded, addCommand drops them: the code is only compiled for its semantic checks (ex: a dead
+ * store, which may address variables left out of the activation record), so none of it reaches the output, not even
+ * when a semantic error is reported
+ */
+void discardCommands(bool discard);
+/* Prints the buffered commands, it is called at the end of the program and before a semantic error is reported */
+void flushCommands();
+
 
 /**
  * Semantic Error Treatment
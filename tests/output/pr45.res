@@ -0,0 +1,3 @@
+100
+10
+2
@@ -0,0 +1,2 @@
+10
+10
@@ -0,0 +1,2 @@
+21
+21
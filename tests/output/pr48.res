@@ -0,0 +1,2 @@
+37
+13
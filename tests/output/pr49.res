@@ -0,0 +1,2 @@
+13
+5
@@ -0,0 +1 @@
+140
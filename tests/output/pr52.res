@@ -0,0 +1,5 @@
+0
+2
+4
+110
+11
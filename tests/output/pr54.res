@@ -0,0 +1,4 @@
+120
+64
+6
+0
@@ -0,0 +1,3 @@
+12
+5
+20
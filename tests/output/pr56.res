@@ -0,0 +1,2 @@
+465
+21
@@ -0,0 +1 @@
+24
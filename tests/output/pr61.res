@@ -0,0 +1,3 @@
+7
+1
+8
@@ -0,0 +1,2 @@
+30
+24
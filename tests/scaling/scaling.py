@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+"""
+Scaling tests for long sequences.
+
+Every shape below grows one sequence of the program (statements in a body or in a loop body, arguments of write/read,
+formal parameters of a function) and is compiled at doubling sizes with the C stack limited to STACK_LIMIT_KIB. A test fails if the
+compiler does not finish successfully, which is what happens when some phase recurses once per element, or if doubling
+the size more than TIME_RATIO_LIMIT times the compilation time, which is what happens when some phase is quadratic.
+"""
+
+import argparse
+import os
+import resource
+import subprocess
+import sys
+import tempfile
+import time
+
+STACK_LIMIT_KIB = 512
+TIME_RATIO_LIMIT = 3.0
+
+
+def statements(n):
+    return "void Main()\n  vars x: integer;\n{\n" + "  x = x+1;\n" * n + "}\n"
+
+
+def loop_statements(n):
+    return ("void Main()\n  vars i, x: integer;\n    a: integer[10];\n{\n  i = 0;\n  while (i < 10) {\n" +
+            "    a[i] = a[i]+x;\n    x = x+1;\n" * (n // 2) + "    i = i+1;\n  }\n  write(x, a[0]);\n}\n")
+
+
+def write_arguments(n):
+    return "void Main()\n  vars x: integer;\n{\n  x = 1;\n  write(" + ", ".join(["x"] * n) + ");\n}\n"
+
+
+def read_arguments(n):
+    return "void Main()\n  vars x: integer;\n{\n  read(" + ", ".join(["x"] * n) + ");\n}\n"
+
+
+def formal_parameters(n):
+    parameters = ", ".join("p%d: integer" % i for i in range(n))
+    arguments = ", ".join(["1"] * n)
+    return ("void Main()\n  functions\n    void f(" + parameters + ")\n    {\n    }\n"
+            "{\n  f(" + arguments + ");\n}\n")
+
+
+# name -> (program generator, compiler arguments, sizes)
+SHAPES = {
+    "statements": (statements, [], [250000, 500000, 1000000, 2000000]),
+    "dump-tree": (statements, ["--dump-tree"], [125000, 250000, 500000, 1000000]),
+    # the loop analyses of the optimizations look at the body of a loop once per statement
+    "loop-body": (loop_statements, ["-O2"], [50000, 100000, 200000, 400000]),
+    "write-arguments": (write_arguments, [], [250000, 500000, 1000000, 2000000]),
+    "read-arguments": (read_arguments, [], [250000, 500000, 1000000, 2000000]),
+    "formal-parameters": (formal_parameters, [], [125000, 250000, 500000, 1000000]),
+}
+
+
+def limit_stack():
+    limit = STACK_LIMIT_KIB * 1024
+    resource.setrlimit(resource.RLIMIT_STACK, (limit, limit))
+
+
+def compile_program(compiler, arguments, program, workdir):
+    source_path = os.path.join(workdir, "program.sl")
+    with open(source_path, "w") as source:
+        source.write(program)
+
+    with open(source_path, "rb") as source, open(os.devnull, "wb") as devnull:
+        start = time.perf_counter()
+        result = subprocess.run([compiler] + arguments, stdin=source, stdout=devnull, stderr=subprocess.PIPE,
+                                preexec_fn=limit_stack)
+        return result.returncode, time.perf_counter() - start
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--compiler", default="build/main")
+    parser.add_argument("shapes", nargs="*", help="shapes to test, all of them by default")
+    arguments = parser.parse_args()
+
+    failed = False
+    with tempfile.TemporaryDirectory() as workdir:
+        for name in arguments.shapes or SHAPES:
+            generator, compiler_arguments, sizes = SHAPES[name]
+            previous_seconds = None
+            for size in sizes:
+                status, seconds = compile_program(arguments.compiler, compiler_arguments, generator(size), workdir)
+                ratio = seconds / previous_seconds if previous_seconds else None
+
+                result = "SUCCESS"
+                if status != 0:
+                    result = "FAILED (exit status %d)" % status
+                elif ratio is not None and ratio > TIME_RATIO_LIMIT:
+                    result = "FAILED (not linear)"
+                failed = failed or result != "SUCCESS"
+
+                print("%-18s %9d elements %8.3fs %8s  %s" % (
+                    name, size, seconds, "x%.2f" % ratio if ratio is not None else "", result))
+                previous_seconds = seconds
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())